@@ -3,8 +3,16 @@
 #include<stdlib.h>
 #include<assert.h>
 #include<string.h>
+#include<new>
+
+// the arena nodes are allocated from, per thread (see setASTArena())
+static thread_local arena *ast_arena = NULL;
 
 /* local helper functions */
+astNode* newNode(){
+	return (astNode *)arenaAlloc(getASTArena(), sizeof(astNode));
+}
+
 char * get_indent_str(int n){
 	char * ret = (char *) calloc(n+1, sizeof(char));
 	for (int i=0; i < n; i++)
@@ -12,38 +20,52 @@ char * get_indent_str(int n){
 	return ret;
 }
 
+arena* setASTArena(arena *new_arena){
+	arena *old_arena = ast_arena;
+	ast_arena = new_arena;
+	return old_arena;
+}
+
+arena* getASTArena(){
+	// threads that never set an arena get one that lasts as long as they do
+	static thread_local arena *thread_arena = NULL;
+	if (ast_arena == NULL){
+		if (thread_arena == NULL)
+			thread_arena = createArena();
+		ast_arena = thread_arena;
+	}
+	return ast_arena;
+}
+
+astList* createList(){
+	arena *owner = getASTArena();
+	return new (arenaAlloc(owner, sizeof(astList))) astList(arenaAllocator<astNode*>(owner));
+}
+
 /* create and free functions for ast_prog type astNode */
-astNode* createProg(astNode *ext1, astNode	*ext2, astNode	*func){
+astNode* createProg(astNode *ext1, astNode	*ext2, astList *func_list){
 	astNode	*node;
-	node = (astNode *)calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_prog;
 
 	node->prog.ext1 = ext1;
 	node->prog.ext2 = ext2;
-	node->prog.func = func;
+	node->prog.func_list = func_list;
 	
 	return(node); 
 }
 
 void freeProg(astNode *node){
 	assert(node != NULL && node->type == ast_prog);
-	
-	freeExtern(node->prog.ext1);
-	freeExtern(node->prog.ext2);
-	freeFunc(node->prog.func);
-	
-	free(node);
-	return;
 }
 
 /*create and free functions for ast_func type astNode */
-astNode* createFunc(const char *name, astNode *param, astNode* body){
+astNode* createFunc(nameId name, astNode *param, astNode* body){
 	astNode *node;
-	node = (astNode*)calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_func;
 
-	node->func.name = (char *) calloc(1, sizeof(char) * (strlen(name)+1));
-	strcpy(node->func.name, name);
+	node->func.name = name;
 
 	node->func.param = param;
 	node->func.body = body;
@@ -51,68 +73,58 @@ astNode* createFunc(const char *name, astNode *param, astNode* body){
 	return node;
 }
 
+astNode* createFunc(const char *name, astNode *param, astNode* body){
+	return createFunc(internName(name), param, body);
+}
+
 void freeFunc(astNode *node){
 	assert(node != NULL && node->type == ast_func);
-	
-	free(node->func.name);
-	if (node->func.param != NULL)
-		freeVar(node->func.param);
-
-	freeBlock(node->func.body);
-	
-	free(node);
-	
-	return;
 }
 
 /*create and free functionns for ast_extern*/
 
-astNode* createExtern(const char *name){
+astNode* createExtern(nameId name){
 	astNode *node;
-	node = (astNode*)calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_extern;
 	
-	node->ext.name = (char *) calloc(1, sizeof(char) * (strlen(name)+1));
-	strcpy(node->ext.name, name);
+	node->ext.name = name;
 
 	return(node);
 }
 
+astNode* createExtern(const char *name){
+	return createExtern(internName(name));
+}
+
 void freeExtern(astNode *node){
 	assert(node != NULL && node->type == ast_extern);
-	
-	free(node->ext.name);
-	free(node);
-
-	return;
 }
 
 /*create and free functions for ast_var*/
 
-astNode* createVar(const char *name){
+astNode* createVar(nameId name){
 	astNode *node;
-	node = (astNode*)calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_var;
 	
-	node->var.name = (char *) calloc(1, sizeof(char) * (strlen(name)+1));
-	strcpy(node->var.name, name);
+	node->var.name = name;
 	
 	return(node);
 }
 
+astNode* createVar(const char *name){
+	return createVar(internName(name));
+}
+
 void freeVar(astNode *node){
 	assert(node != NULL && node->type == ast_var);
-	
-	free(node->var.name);
-	free(node);
-
-	return;
 }
 
 /*create and free functions for ast_cnst type of node*/
 astNode* createCnst(int value){
 	astNode *node;
-	node = (astNode*)calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_cnst;
 
 	node->cnst.value = value;
@@ -121,15 +133,12 @@ astNode* createCnst(int value){
 
 void freeCnst(astNode *node){
 	assert(node != NULL);
-	free(node);
-
-	return;
 }
 
 /*create and free functions for ast_rexpr type of node*/
 astNode* createRExpr(astNode *lhs, astNode *rhs, rop_type op){
 	astNode *node;
-	node = (astNode*)calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_rexpr;
 	
 	node->rexpr.lhs = lhs;
@@ -141,20 +150,13 @@ astNode* createRExpr(astNode *lhs, astNode *rhs, rop_type op){
 
 void freeRExpr(astNode *node){
 	assert(node != NULL && node->type == ast_rexpr);
-	
-	// We call freeNode as we don't know the type of nodes for lhs and rhs
-	freeNode(node->rexpr.lhs);
-	freeNode(node->rexpr.rhs);
-	free(node);
-
-	return;
 }
 
 
 /*create and free functions for ast_bexpr type of node*/
 astNode* createBExpr(astNode *lhs, astNode *rhs, op_type op){
 	astNode *node;
-	node = (astNode*)calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_bexpr;
 	
 	node->bexpr.lhs = lhs;
@@ -166,20 +168,12 @@ astNode* createBExpr(astNode *lhs, astNode *rhs, op_type op){
 
 void freeBExpr(astNode *node){
 	assert(node != NULL && node->type == ast_bexpr);
-	
-	//We call freeNode as we don't know the type of nodes for rhs and lhs
-	freeNode(node->bexpr.lhs);
-	freeNode(node->bexpr.rhs);
-
-	free(node);
-
-	return;
 }
 
 /* create and free functions for ast_uexpr type of node */
 astNode* createUExpr(astNode *expr, op_type op){
 	astNode *node;
-	node = (astNode*)calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_uexpr;
 	
 	node->uexpr.expr = expr;
@@ -190,44 +184,35 @@ astNode* createUExpr(astNode *expr, op_type op){
 
 void freeUExpr(astNode *node){
 	assert(node != NULL && node->type == ast_uexpr);
-	
-	freeNode(node->uexpr.expr);
-	free(node);
-
-	return;
 }
 
 /* create and free functions for a statement of type ast_call */
-astNode* createCall(const char *name, astNode *param){
+astNode* createCall(nameId name, astNode *param){
 	astNode *node;
-	node = (astNode*) calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_stmt;
 	node->stmt.type = ast_call;
 	
-	node->stmt.call.name = (char *) calloc(strlen(name) + 1, sizeof(char));
-	strcpy(node->stmt.call.name, name);
+	node->stmt.call.name = name;
 	
 	node->stmt.call.param = param;
 
 	return node;
 }
 
+astNode* createCall(const char *name, astNode *param){
+	return createCall(internName(name), param);
+}
+
 void freeCall(astNode *node){
 	assert(node != NULL && node->type == ast_stmt);
 	assert(node->stmt.type == ast_call);
-	
-	free(node->stmt.call.name);
-	if (node->stmt.call.param != NULL)
-		freeNode(node->stmt.call.param);
-
-	free(node);
-	return;
 }
 
 /*create and free functions for a stmt of type ast_ret*/
 astNode* createRet(astNode	*expr){
 	astNode *node;
-	node = (astNode*) calloc(1, sizeof(astNode));
+	node = newNode();
 	node->type = ast_stmt;
 	node->stmt.type = ast_ret;
 	
@@ -235,19 +220,14 @@ astNode* createRet(astNode	*expr){
 	return(node);
 }
 
-void freeRet(astNode *node){	
+void freeRet(astNode *node){
 	assert(node != NULL && node->type == ast_stmt);
 	assert(node->stmt.type == ast_ret);
-
-	freeNode(node->stmt.ret.expr);
-	free(node);
-	return;
 }
 
 /*create and free functions for a stmt of type ast_block*/
-astNode* createBlock(vector<astNode*> *stmt_list){
-	vector<astNode*> slist;
-	astNode* node = (astNode *)calloc(1, sizeof(astNode));
+astNode* createBlock(astList *stmt_list){
+	astNode* node = newNode();
 	node->type = ast_stmt;
 	node->stmt.type = ast_block;
 	
@@ -259,23 +239,11 @@ astNode* createBlock(vector<astNode*> *stmt_list){
 void freeBlock(astNode *node){
 	assert(node != NULL && node->type == ast_stmt);
 	assert(node->stmt.type == ast_block);
-
-	vector<astNode *> slist = *(node->stmt.block.stmt_list);
-	vector<astNode*>::iterator it = slist.begin();
-
-	while (it != slist.end()){
-		freeNode(*it);
-		it++;	
-	}
-	
-	delete(node->stmt.block.stmt_list);
-	free(node);
-	return;
 }
 
 /* create and free functions for stmt of type while*/
 astNode* createWhile(astNode *cond, astNode *body){
-	astNode* node = (astNode *)calloc(1, sizeof(astNode));
+	astNode* node = newNode();
 	node->type = ast_stmt;
 	node->stmt.type = ast_while;
 	
@@ -288,17 +256,11 @@ astNode* createWhile(astNode *cond, astNode *body){
 void freeWhile(astNode *node){
 	assert(node != NULL && node->type == ast_stmt);
 	assert(node->stmt.type == ast_while);
-
-	freeNode(node->stmt.whilen.cond);
-	freeNode(node->stmt.whilen.body);
-	
-	free(node);
-	return;
 }
 
 /*create and free functions for stmt of type if*/
 astNode* createIf(astNode *cond, astNode *ifbody, astNode *elsebody){
-	astNode* node = (astNode *)calloc(1, sizeof(astNode));
+	astNode* node = newNode();
 	node->type = ast_stmt;
 	node->stmt.type = ast_if;
 
@@ -312,40 +274,31 @@ astNode* createIf(astNode *cond, astNode *ifbody, astNode *elsebody){
 void freeIf(astNode *node){
 	assert(node != NULL && node->type == ast_stmt);
 	assert(node->stmt.type == ast_if);
-	
-	freeNode(node->stmt.ifn.cond);
-	freeNode(node->stmt.ifn.if_body);
-	if (node->stmt.ifn.else_body != NULL)
-		freeNode(node->stmt.ifn.else_body);
-
-	free(node);	
-
-	return;
 }
 
 /* create and free functions of stmt type ast_decl */
-astNode* createDecl(const char *name){
-	astNode* node = (astNode *)calloc(1, sizeof(astNode));
+astNode* createDecl(nameId name){
+	astNode* node = newNode();
 	node->type = ast_stmt;
 	node->stmt.type = ast_decl;
 
-	node->stmt.decl.name = (char *)calloc(strlen(name)+1, sizeof(char));
-	strcpy(node->stmt.decl.name, name);
+	node->stmt.decl.name = name;
 
 	return(node);
 }
 
+astNode* createDecl(const char *name){
+	return createDecl(internName(name));
+}
+
 void freeDecl(astNode *node){
 	assert(node != NULL && node->type == ast_stmt);
 	assert(node->stmt.type == ast_decl);
-	
-	free(node->stmt.decl.name);
-	free(node);
 }
 
 /* create and free functions of stmt type ast_assign */
 astNode* createAsgn(astNode *lhs, astNode *rhs){
-	astNode* node = (astNode *)calloc(1, sizeof(astNode));
+	astNode* node = newNode();
 	node->type = ast_stmt;
 	node->stmt.type = ast_asgn;
 
@@ -358,222 +311,307 @@ astNode* createAsgn(astNode *lhs, astNode *rhs){
 void freeAsgn(astNode *node){
 	assert(node != NULL && node->type == ast_stmt);
 	assert(node->stmt.type == ast_asgn);
-	
-	freeVar(node->stmt.asgn.lhs);
-	freeNode(node->stmt.asgn.rhs);
-	free(node);
-
-	return;
 }
 
-/* free function for releasing all the memory assigned to a node based
-on the type. This function is called by other free* functions when
-the type of a child node is not obvious from the context */
+/* nodes live in the AST arena, which releases all of them at once, so
+freeing a node or statement releases nothing */
 
 void freeNode(astNode *node){
 	assert(node != NULL);
-
-	switch(node->type){
-		case ast_prog:{
-						freeProg(node);
-						break;
-					  }
-		case ast_func:{
-						freeFunc(node);
-						break;
-					  }
-		case ast_stmt:{
-						freeStmt(node);
-						break;
-					  }
-		case ast_extern:{
-						freeExtern(node);
-						break;
-					  }
-		case ast_var: {	
-						freeVar(node);
-						break;
-					  }
-		case ast_cnst: {
-						 freeCnst(node);
-						 break;
-					  }
-		case ast_rexpr: {
-						freeRExpr(node);
-						break;
-					  }
-		case ast_bexpr: {
-						freeBExpr(node);
-						break;
-					  }
-		case ast_uexpr: {
-						freeUExpr(node);
-						break;
-					  }
-		default: {
-					fprintf(stderr,"Incorrect node type\n");
-				 	exit(1);
-				 }
-	}
 }
 
-/* free function to stmt. To be called when stmt type is not obvious
-from the context */
 void freeStmt(astNode *node){
 	assert(node != NULL && node->type == ast_stmt);
-	
-	switch(node->stmt.type){
-		case ast_call: 
-						freeCall(node);
-						break;
-		case ast_ret: 
-						freeRet(node);
-						break;
-		case ast_block:
-						freeBlock(node);
-						break;
-		case ast_while:
-						freeWhile(node);
-						break;
-		case ast_if: 
-						freeIf(node);
-						break;
-		case ast_asgn:	
-						freeAsgn(node);
-						break;
-		case ast_decl:	
-						 freeDecl(node);
-						 break;
-		default: {
-					fprintf(stderr,"Incorrect node type\n");
-				 	exit(1);
-				 };
-	}
 }
 
+/* local helper for printNode and printStmt: an entry of their work stack, which is a node or a
+statement to print at 'indent', or, when both are NULL, a label to print between two children */
+typedef struct {
+	astNode *node;
+	astStmt *stmt;
+	const char *label;
+	int indent;
+} printItem;
+
+void printItems(vector<printItem> &stack);
+
 void printNode(astNode *node, int n){
 	assert(node != NULL);
-	char *indent = get_indent_str(n);
-	
-	switch(node->type){
-		case ast_prog:{
-						printf("%sProg:\n",indent);
-						printNode(node->prog.func, n+1);
-						break;
-					  }
-		case ast_func:{
-						printf("%sFunc: %s\n",indent, node->func.name);
-						if (node->func.param != NULL)
-							printNode(node->func.param, n+1);
-
-						printNode(node->func.body, n+1);
-						break;
-					  }
-		case ast_stmt:{
-						printf("%sStmt: \n",indent);
-						astStmt stmt= node->stmt;
-						printStmt(&stmt, n+1);
-						break;
-					  }
-		case ast_extern:{
-						printf("%sExtern: %s\n", indent, node->ext.name);
-						break;
-					  }
-		case ast_var: {	
-						printf("%sVar: %s\n", indent, node->var.name);
-						break;
-					  }
-		case ast_cnst: {
-						printf("%sConst: %d\n", indent, node->cnst.value);
-						 break;
-					  }
-		case ast_rexpr: {
-						printf("%sRExpr: \n", indent);
-						printNode(node->rexpr.lhs, n+1);
-						printNode(node->rexpr.rhs, n+1);
-						break;
-					  }
-		case ast_bexpr: {
-						printf("%sBExpr: \n", indent);
-						printNode(node->bexpr.lhs, n+1);
-						printNode(node->bexpr.rhs, n+1);
-						break;
-					  }
-		case ast_uexpr: {
-						printf("%sUExpr: \n", indent);
-						printNode(node->uexpr.expr, n+1);
-						break;
-					  }
-		default: {
-					fprintf(stderr,"Incorrect node type\n");
-				 	exit(1);
-				 }
-	}
-	free(indent);
+	vector<printItem> stack;
+	stack.reserve(AST_STACK_CAPACITY);
+	stack.push_back({node, NULL, NULL, n});
+	printItems(stack);
 }
 
 void printStmt(astStmt *stmt, int n){
 	assert(stmt != NULL);
-	char *indent = get_indent_str(n);
-
-	switch(stmt->type){
-		case ast_call: { 
-							printf("%sCall: name %s\n", indent, stmt->call.name);
-							if (stmt->call.param != NULL){
-								printf("%sCall: param\n", indent);
-								printNode(stmt->call.param, n+1);
-							}
+	vector<printItem> stack;
+	stack.reserve(AST_STACK_CAPACITY);
+	stack.push_back({NULL, stmt, NULL, n});
+	printItems(stack);
+}
+
+/* local helper for printNode and printStmt: prints the items on the stack until it is empty. The
+children of an item (and the labels between them) are pushed in reverse, so they are printed in order */
+void printItems(vector<printItem> &stack){
+	while (!stack.empty()){
+		printItem item = stack.back();
+		stack.pop_back();
+		int n = item.indent;
+		char *indent = get_indent_str(n);
+
+		if (item.label != NULL){
+			printf("%s%s\n", indent, item.label);
+		}
+		else if (item.node != NULL){
+			astNode *node = item.node;
+			switch(node->type){
+				case ast_prog:{
+								printf("%sProg:\n",indent);
+								for (int i = node->prog.func_list->size() - 1; i >= 0; i--)
+									stack.push_back({node->prog.func_list->at(i), NULL, NULL, n+1});
+								break;
+							  }
+				case ast_func:{
+								printf("%sFunc: %s\n",indent, getName(node->func.name));
+								stack.push_back({node->func.body, NULL, NULL, n+1});
+								if (node->func.param != NULL)
+									stack.push_back({node->func.param, NULL, NULL, n+1});
+								break;
+							  }
+				case ast_stmt:{
+								printf("%sStmt: \n",indent);
+								stack.push_back({NULL, &node->stmt, NULL, n+1});
+								break;
+							  }
+				case ast_extern:{
+								printf("%sExtern: %s\n", indent, getName(node->ext.name));
+								break;
+							  }
+				case ast_var: {
+								printf("%sVar: %s\n", indent, getName(node->var.name));
+								break;
+							  }
+				case ast_cnst: {
+								printf("%sConst: %d\n", indent, node->cnst.value);
+								 break;
+							  }
+				case ast_rexpr: {
+								printf("%sRExpr: \n", indent);
+								stack.push_back({node->rexpr.rhs, NULL, NULL, n+1});
+								stack.push_back({node->rexpr.lhs, NULL, NULL, n+1});
+								break;
+							  }
+				case ast_bexpr: {
+								printf("%sBExpr: \n", indent);
+								stack.push_back({node->bexpr.rhs, NULL, NULL, n+1});
+								stack.push_back({node->bexpr.lhs, NULL, NULL, n+1});
+								break;
+							  }
+				case ast_uexpr: {
+								printf("%sUExpr: \n", indent);
+								stack.push_back({node->uexpr.expr, NULL, NULL, n+1});
+								break;
+							  }
+				default: {
+							fprintf(stderr,"Incorrect node type\n");
+							exit(1);
+						 }
+			}
+		}
+		else {
+			astStmt *stmt = item.stmt;
+			switch(stmt->type){
+				case ast_call: {
+									printf("%sCall: name %s\n", indent, getName(stmt->call.name));
+									if (stmt->call.param != NULL){
+										stack.push_back({stmt->call.param, NULL, NULL, n+1});
+										stack.push_back({NULL, NULL, "Call: param", n});
+									}
+									break;
+								}
+				case ast_ret: {
+									printf("%sRet:\n", indent);
+									stack.push_back({stmt->ret.expr, NULL, NULL, n+1});
+									break;
+								}
+				case ast_block: {
+									printf("%sBlock:\n", indent);
+									for (int i = stmt->block.stmt_list->size() - 1; i >= 0; i--)
+										stack.push_back({stmt->block.stmt_list->at(i), NULL, NULL, n+1});
+									break;
+								}
+				case ast_while: {
+									printf("%sWhile: cond \n", indent);
+									stack.push_back({stmt->whilen.body, NULL, NULL, n+1});
+									stack.push_back({NULL, NULL, "While: body ", n});
+									stack.push_back({stmt->whilen.cond, NULL, NULL, n+1});
+									break;
+								}
+				case ast_if: {
+									printf("%sIf: cond\n", indent);
+									if (stmt->ifn.else_body != NULL)
+									{
+										stack.push_back({stmt->ifn.else_body, NULL, NULL, n+1});
+										stack.push_back({NULL, NULL, "Else: body", n});
+									}
+									stack.push_back({stmt->ifn.if_body, NULL, NULL, n+1});
+									stack.push_back({NULL, NULL, "If: body", n});
+									stack.push_back({stmt->ifn.cond, NULL, NULL, n+1});
+									break;
+								}
+				case ast_asgn:	{
+									printf("%sAsgn: lhs\n", indent);
+									stack.push_back({stmt->asgn.rhs, NULL, NULL, n+1});
+									stack.push_back({NULL, NULL, "Asgn: rhs", n});
+									stack.push_back({stmt->asgn.lhs, NULL, NULL, n+1});
+									break;
+								}
+				case ast_decl:	{
+									printf("%sDecl: %s\n", indent, getName(stmt->decl.name));
+									break;
+								}
+				default: {
+							fprintf(stderr,"Incorrect node type\n");
+							exit(1);
+						 }
+			}
+		}
+		free(indent);
+	}
+}
+
+/* local helper for serializeNode: appends a name preceded by its length */
+void serializeName(nameId name, string &out){
+	out += to_string(getNameLength(name));
+	out.push_back(':');
+	out.append(getName(name), getNameLength(name));
+}
+
+/* the subtrees still to be encoded are kept on a stack, the next one on top; an absent child
+is pushed as NULL and encoded as '-' */
+void serializeNode(astNode *root, string &out){
+	vector<astNode *> stack;
+	stack.reserve(AST_STACK_CAPACITY);
+	stack.push_back(root);
+
+	while (!stack.empty()){
+		astNode *node = stack.back();
+		stack.pop_back();
+		if (node == NULL){
+			out.push_back('-');
+			continue;
+		}
+
+		switch(node->type){
+			case ast_prog:{
+							out.push_back('P');
+							out += to_string(node->prog.func_list->size());
+							out.push_back(';');
+							for (int i = node->prog.func_list->size() - 1; i >= 0; i--)
+								stack.push_back(node->prog.func_list->at(i));
 							break;
-						}
-		case ast_ret: {
-							printf("%sRet:\n", indent);
-							printNode(stmt->ret.expr, n+1);
+						  }
+			case ast_func:{
+							out.push_back('F');
+							serializeName(node->func.name, out);
+							stack.push_back(node->func.body);
+							stack.push_back(node->func.param);
 							break;
-						}
-		case ast_block: {
-							printf("%sBlock:\n", indent);
-							vector<astNode*> slist = *(stmt->block.stmt_list);
-							vector<astNode*>::iterator it = slist.begin();
-							while (it != slist.end()){
-								printNode(*it, n+1);
-								it++;
+						  }
+			case ast_stmt:{
+							astStmt *stmt = &node->stmt;
+							switch(stmt->type){
+								case ast_call: {
+													out.push_back('c');
+													serializeName(stmt->call.name, out);
+													stack.push_back(stmt->call.param);
+													break;
+												}
+								case ast_ret: {
+													out.push_back('r');
+													stack.push_back(stmt->ret.expr);
+													break;
+												}
+								case ast_block: {
+													out.push_back('b');
+													out += to_string(stmt->block.stmt_list->size());
+													out.push_back(';');
+													for (int i = stmt->block.stmt_list->size() - 1; i >= 0; i--)
+														stack.push_back(stmt->block.stmt_list->at(i));
+													break;
+												}
+								case ast_while: {
+													out.push_back('w');
+													stack.push_back(stmt->whilen.body);
+													stack.push_back(stmt->whilen.cond);
+													break;
+												}
+								case ast_if: {
+													out.push_back('i');
+													stack.push_back(stmt->ifn.else_body);
+													stack.push_back(stmt->ifn.if_body);
+													stack.push_back(stmt->ifn.cond);
+													break;
+												}
+								case ast_asgn: {
+													out.push_back('a');
+													stack.push_back(stmt->asgn.rhs);
+													stack.push_back(stmt->asgn.lhs);
+													break;
+												}
+								case ast_decl: {
+													out.push_back('d');
+													serializeName(stmt->decl.name, out);
+													break;
+												}
+								default: {
+											fprintf(stderr,"Incorrect statement type\n");
+											exit(1);
+										 }
 							}
 							break;
-						}
-		case ast_while: {
-							printf("%sWhile: cond \n", indent);
-							printNode(stmt->whilen.cond, n+1);
-							printf("%sWhile: body \n", indent);
-							printNode(stmt->whilen.body, n+1);
+						  }
+			case ast_extern:{
+							out.push_back('E');
+							serializeName(node->ext.name, out);
 							break;
-						}
-		case ast_if: {
-							printf("%sIf: cond\n", indent);
-							printNode(stmt->ifn.cond, n+1);
-							printf("%sIf: body\n", indent);
-							printNode(stmt->ifn.if_body, n+1);
-							if (stmt->ifn.else_body != NULL)
-							{
-								printf("%sElse: body\n", indent);
-								printNode(stmt->ifn.else_body, n+1);
-							}
+						  }
+			case ast_var: {
+							out.push_back('V');
+							serializeName(node->var.name, out);
+							break;
+						  }
+			case ast_cnst: {
+							out.push_back('C');
+							out += to_string(node->cnst.value);
+							out.push_back(';');
+							break;
+						  }
+			case ast_rexpr: {
+							out.push_back('R');
+							out.push_back('0' + node->rexpr.op);
+							stack.push_back(node->rexpr.rhs);
+							stack.push_back(node->rexpr.lhs);
 							break;
-						}
-		case ast_asgn:	{
-							printf("%sAsgn: lhs\n", indent);
-							printNode(stmt->asgn.lhs, n+1);
-							printf("%sAsgn: rhs\n", indent);
-							printNode(stmt->asgn.rhs, n+1);
+						  }
+			case ast_bexpr: {
+							out.push_back('B');
+							out.push_back('0' + node->bexpr.op);
+							stack.push_back(node->bexpr.rhs);
+							stack.push_back(node->bexpr.lhs);
 							break;
-						}
-		case ast_decl:	{
-							printf("%sDecl: %s\n", indent, stmt->decl.name);
+						  }
+			case ast_uexpr: {
+							out.push_back('U');
+							out.push_back('0' + node->uexpr.op);
+							stack.push_back(node->uexpr.expr);
 							break;
-						}
-		default: {
-					fprintf(stderr,"Incorrect node type\n");
-				 	exit(1);
-				 }
+						  }
+			default: {
+						fprintf(stderr,"Incorrect node type\n");
+					 	exit(1);
+					 }
+		}
 	}
-	free(indent);
 }
@@ -3,6 +3,9 @@
 
 #include <cstddef>
 #include<vector>
+#include<string>
+#include "../support/name_table.h"
+#include "../support/arena.h"
 using namespace std;
 
 struct ast_Node;
@@ -11,6 +14,9 @@ typedef struct ast_Node astNode;
 struct ast_Stmt;
 typedef struct ast_Stmt astStmt;
 
+// lists of nodes (functions, statements) are allocated in the AST arena like the nodes
+typedef vector<astNode*, arenaAllocator<astNode*> > astList;
+
 //enum to identify node type
 typedef enum {
 		ast_prog,
@@ -58,21 +64,21 @@ typedef enum {
 typedef struct {
 	 	astNode* ext1; //extern function print
 		astNode* ext2; //extern function read
-		astNode* func; //function defined in input miniC program
+		astList *func_list; //functions defined in input miniC program, in source order
 	} astProg;
 
 typedef struct {
-		char* name; // name of the function
+		nameId name; // name of the function
 		astNode* param; // parameter, possibly NULL if the function doesn't take a param
 		astNode* body; //function body
 	} astFunc;
 
 typedef struct {
-		char* name; // For extern functions defined we will only save function names
+		nameId name; // For extern functions defined we will only save function names
 	} astExtern;
 
 typedef struct {
-		char* name;
+		nameId name;
 	} astVar; 
 
 typedef struct {
@@ -98,8 +104,8 @@ typedef struct {
 
 /* structs for different statement types */
 typedef struct {
-		char* name;
-		astNode* param; // For read function this field will be NULL
+		nameId name;
+		astNode* param; // For read (and user functions without a parameter) this field will be NULL
 	} astCall;
 
 typedef struct {
@@ -107,7 +113,7 @@ typedef struct {
 	} astRet;
 
 typedef struct {
-		vector<astNode*> *stmt_list;
+		astList *stmt_list;
 	} astBlock;
 
 typedef struct {
@@ -122,7 +128,7 @@ typedef struct {
 	} astIf;
 
 typedef struct {
-		char* name;
+		nameId name;
 	} astDecl;
 
 typedef struct {
@@ -159,14 +165,32 @@ struct ast_Node{
 	};
 
 
+/*
+Nodes and lists are allocated from the AST arena of the calling thread,
+so a whole tree is released at once by resetting or freeing that arena
+(see "arena.h"). setASTArena() makes the given arena the calling thread's
+AST arena and returns the previous one (NULL restores the default: an
+arena of the thread's own that lasts as long as the thread).
+*/
+arena* setASTArena(arena *ast_arena);
+arena* getASTArena();
+
+/* creates an empty list of nodes in the AST arena */
+astList* createList();
+
 /* 
 Declarations of create* functions for all the types of nodes 
 defined above. All the create* functions return a astNode*. 
+Names are stored as the IDs "name_table.h" interns them as; the
+overloads taking a string intern it first.
 */
 
-astNode* createProg(astNode* extern1, astNode* extern2, astNode* func);
+astNode* createProg(astNode* extern1, astNode* extern2, astList* func_list);
+astNode* createFunc(nameId name, astNode* param, astNode* body);
 astNode* createFunc(const char* name, astNode* param, astNode* body);
+astNode* createExtern(nameId name);
 astNode* createExtern(const char *name);
+astNode* createVar(nameId name);
 astNode* createVar(const char *name);
 astNode* createCnst(int value);
 astNode* createRExpr(astNode* lhs, astNode* rhs, rop_type op);
@@ -180,17 +204,20 @@ other create functions these functions return
 a astNode*.
 */
 
+astNode* createCall(nameId name, astNode *param=NULL);
 astNode* createCall(const char *name, astNode *param=NULL);
 astNode* createRet(astNode* expr);
-astNode* createBlock(vector<astNode*> *stmt_list);
+astNode* createBlock(astList *stmt_list);
 astNode* createWhile(astNode* cond, astNode* body);
 astNode* createIf(astNode* cond, astNode* if_body, astNode* else_body=NULL);
+astNode* createDecl(nameId decl);
 astNode* createDecl(const char* decl);
 astNode* createAsgn(astNode* lhs, astNode* rhs);
 
 /* 
-Declarations for all free* functions. All these functions take a astNode* as parameter
-as free the memory allocated by corresponding create functions.
+Declarations for all free* functions. All these functions take a astNode* as parameter.
+Nodes are released with their arena, so they free nothing and only remain for existing
+callers.
 */
 
 void freeProg(astNode*);
@@ -211,15 +238,25 @@ void freeIf(astNode*);
 void freeDecl(astNode*);
 void freeAsgn(astNode*);
 
-/* freeNode checks the node type and calls the corresponding free* function.*/
+/* freeNode accepts a node of any type.*/
 void freeNode(astNode*);
 
-/* freeStmt checks the stmt type and calls the corresponding free* function.*/
+/* freeStmt accepts a statement of any type.*/
 void freeStmt(astNode*);
 
+/* Initial capacity of the explicit stacks the traversals of an AST (printing, serializing,
+   flattening and IR generation) keep instead of recursing. Deeper trees grow them on the heap,
+   so how deep a tree can be nested is bounded by memory rather than by the native stack.*/
+#define AST_STACK_CAPACITY 256
+
 /* Function to print astNode and astStmt. The second parameter is to beautify the output.*/
 
 void printNode(astNode*, int indent=0);
 void printStmt(astStmt*, int indent=0);
 
+/* Appends a compact encoding of the subtree rooted at the node to the string. Two subtrees
+   have the same encoding exactly when they are identical, so it can be hashed to fingerprint
+   e.g. a function.*/
+void serializeNode(astNode*, string &out);
+
 #endif
@@ -0,0 +1,184 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * ast_file.c - implements writing a flat AST to a binary file and mapping it back
+ */
+
+#include "ast_file.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+// numbers the temporary files written by this process
+static std::atomic<long> temp_counter(0);
+
+/***************************************** FUNCTION HEADERS *****************************************/
+bool isNamedKind(uint8_t kind);
+void appendArray(std::string &out, const void *array, size_t bytes);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "ast_file.h" for details ***********************/
+void encodeFlatAST(const flatAST *ast, size_t source_len, std::string &out) {
+    uint32_t num_nodes = ast->kinds.size();
+
+    // number the names in the order the nodes first refer to them
+    std::vector<int32_t> data(ast->data);
+    std::unordered_map<nameId, int32_t> indices;
+    std::vector<nameId> names;
+    for (astIndex node = 0; node < num_nodes; node++) {
+        if (isNamedKind(ast->kinds[node])) {
+            std::pair<std::unordered_map<nameId, int32_t>::iterator, bool> entry = indices.insert(
+                std::pair<nameId, int32_t>(data[node], names.size()));
+            if (entry.second) {
+                names.push_back(data[node]);
+            }
+            data[node] = entry.first->second;
+        }
+    }
+    std::vector<uint32_t> name_ends;
+    uint64_t names_len = 0;
+    for (int i = 0; i < names.size(); i++) {
+        names_len += getNameLength(names.at(i));
+        name_ends.push_back(names_len);
+    }
+
+    astFileHeader header;
+    memcpy(header.magic, AST_FILE_MAGIC, sizeof(header.magic));
+    header.version = AST_FILE_VERSION;
+    header.byte_order = AST_FILE_BYTE_ORDER;
+    header.source_len = source_len;
+    header.num_nodes = num_nodes;
+    header.num_names = names.size();
+    header.names_len = names_len;
+
+    out.reserve(out.size() + sizeof(header) + (size_t)num_nodes * 9 + names.size() * sizeof(uint32_t) + names_len);
+    appendArray(out, &header, sizeof(header));
+    appendArray(out, ast->sizes.data(), num_nodes * sizeof(astIndex));
+    appendArray(out, data.data(), num_nodes * sizeof(int32_t));
+    appendArray(out, name_ends.data(), name_ends.size() * sizeof(uint32_t));
+    appendArray(out, ast->kinds.data(), num_nodes * sizeof(uint8_t));
+    for (int i = 0; i < names.size(); i++) {
+        out.append(getName(names.at(i)), getNameLength(names.at(i)));
+    }
+}
+
+/*********************** see "ast_file.h" for details ***********************/
+flatAST *decodeFlatAST(const char *contents, size_t size, size_t source_len) {
+    astFileHeader header;
+    if (size < sizeof(header)) {
+        return NULL;
+    }
+    memcpy(&header, contents, sizeof(header));
+    if (memcmp(header.magic, AST_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != AST_FILE_VERSION
+            || header.byte_order != AST_FILE_BYTE_ORDER || header.source_len != source_len || header.num_nodes == 0
+            || size != sizeof(header) + (uint64_t)header.num_nodes * 9 + (uint64_t)header.num_names * sizeof(uint32_t)
+                        + header.names_len) {
+        return NULL;
+    }
+    uint32_t num_nodes = header.num_nodes;
+    const char *sizes = contents + sizeof(header);
+    const char *data = sizes + num_nodes * sizeof(astIndex);
+    const char *name_ends = data + num_nodes * sizeof(int32_t);
+    const char *kinds = name_ends + header.num_names * sizeof(uint32_t);
+    const char *names = kinds + num_nodes;
+
+    // the names are interned from the file itself, which gives the IDs to put in their nodes
+    std::vector<nameId> ids(header.num_names);
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < header.num_names; i++) {
+        uint32_t end;
+        memcpy(&end, name_ends + i * sizeof(uint32_t), sizeof(end));
+        if (end < start || end > header.names_len) {
+            return NULL;
+        }
+        ids.at(i) = internName(names + start, end - start);
+        start = end;
+    }
+
+    flatAST *ast = new flatAST();
+    ast->kinds.assign((const uint8_t *)kinds, (const uint8_t *)kinds + num_nodes);
+    ast->sizes.resize(num_nodes);
+    memcpy(ast->sizes.data(), sizes, num_nodes * sizeof(astIndex));
+    ast->data.resize(num_nodes);
+    memcpy(ast->data.data(), data, num_nodes * sizeof(int32_t));
+
+    // check that every subtree lies within its parent's, so that a damaged file cannot send a
+    // traversal out of bounds, while swapping the names' indices for their IDs
+    std::vector<astIndex> ends;
+    ends.reserve(AST_STACK_CAPACITY);
+    for (astIndex node = 0; node < num_nodes; node++) {
+        while (!ends.empty() && ends.back() <= node) {
+            ends.pop_back();
+        }
+        astIndex node_size = ast->sizes[node];
+        bool valid = ast->kinds[node] <= flat_decl && node_size > 0 && node_size <= num_nodes - node
+            && (node == 0 ? node_size == num_nodes : node + node_size <= ends.back());
+        if (valid && isNamedKind(ast->kinds[node])) {
+            valid = ast->data[node] >= 0 && ast->data[node] < header.num_names;
+            ast->data[node] = valid ? ids.at(ast->data[node]) : 0;
+        }
+        if (!valid) {
+            freeFlatAST(ast);
+            return NULL;
+        }
+        ends.push_back(node + node_size);
+    }
+    return ast;
+}
+
+/*********************** see "ast_file.h" for details ***********************/
+size_t writeASTFile(const char *path, const flatAST *ast, size_t source_len) {
+    std::string contents;
+    encodeFlatAST(ast, source_len, contents);
+
+    std::string temp_path = std::string(path) + ".tmp." + std::to_string(getpid()) + "." + std::to_string(temp_counter++);
+    FILE *fp = fopen(temp_path.c_str(), "w");
+    if (fp == NULL) {
+        return 0;
+    }
+    bool ok = fwrite(contents.data(), 1, contents.size(), fp) == contents.size();
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(temp_path.c_str(), path) != 0) {
+        unlink(temp_path.c_str());
+        return 0;
+    }
+    return contents.size();
+}
+
+/*********************** see "ast_file.h" for details ***********************/
+flatAST *mapASTFile(const char *path, size_t source_len) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < sizeof(astFileHeader)) {
+        close(fd);
+        return NULL;
+    }
+    void *contents = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (contents == MAP_FAILED) {
+        return NULL;
+    }
+    flatAST *ast = decodeFlatAST((const char *)contents, st.st_size, source_len);
+    munmap(contents, st.st_size);
+    return ast;
+}
+
+/* returns true if the 'data' of a node of kind 'kind' is a name ID */
+bool isNamedKind(uint8_t kind) {
+    return kind == flat_extern || kind == flat_func || kind == flat_var || kind == flat_call || kind == flat_decl;
+}
+
+/* appends 'bytes' bytes of 'array' to 'out' */
+void appendArray(std::string &out, const void *array, size_t bytes) {
+    out.append((const char *)array, bytes);
+}
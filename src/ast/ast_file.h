@@ -0,0 +1,85 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * ast_file.h - defines a binary file format for a parsed program's flat AST, so that a program
+ * compiled again can be memory-mapped back in place of being scanned and parsed
+ */
+
+#ifndef AST_FILE_H
+#define AST_FILE_H
+
+#include "flat_ast.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// bumped whenever the layout of the file or the meaning of a flat_kind changes, so that files
+// written by an older compiler are rejected instead of misread
+#define AST_FILE_VERSION 1
+#define AST_FILE_MAGIC "MINICAST"
+
+// written as is, so a file from a machine with the other byte order does not match it
+#define AST_FILE_BYTE_ORDER 0x01020304u
+
+/*
+ * Header at the start of every file. It is followed by, in order: the 'sizes' of the nodes
+ * (num_nodes uint32_t), their 'data' (num_nodes int32_t, where a name is the index of the name
+ * in the file rather than a name ID), the offset in the name text just past the end of each
+ * name (num_names uint32_t), the 'kinds' of the nodes (num_nodes bytes), and the text of the
+ * names (names_len bytes, not NUL-terminated). Each array starts at a multiple of its alignment.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t source_len; // length of the source text the AST was parsed from
+    uint32_t num_nodes;
+    uint32_t num_names;
+    uint64_t names_len;
+} astFileHeader;
+
+/*
+ * Params:
+ *      const flatAST *ast: a finished flatAST (see finishFlatAST())
+ *      size_t source_len: length of the source text 'ast' was parsed from
+ *      std::string &out: receives the contents of the file
+ *
+ * Notes:
+ *      Each name is stored once, however many nodes refer to it.
+ */
+void encodeFlatAST(const flatAST *ast, size_t source_len, std::string &out);
+
+/*
+ * Params:
+ *      const char *contents, size_t size: the contents of a file written by encodeFlatAST()
+ *      size_t source_len: length of the source text the AST is expected to come from
+ *
+ * Returns:
+ *      a pointer to a newly allocated flatAST holding the program, or NULL if 'contents' is not
+ *      a complete file of this version and byte order, was written for a source of another
+ *      length, or does not hold a well-formed tree
+ *
+ * Notes:
+ *      The names are interned straight from 'contents', and the node arrays are copied out of
+ *      it in one block each, remapping the names to the name IDs of this process; nothing is
+ *      scanned or parsed.
+ */
+flatAST *decodeFlatAST(const char *contents, size_t size, size_t source_len);
+
+/*
+ * Params:
+ *      const char *path: the file to write; it is written to a temporary file first and renamed
+ *      into place, so readers never see a partial file
+ *      const flatAST *ast, size_t source_len: as for encodeFlatAST()
+ *
+ * Returns:
+ *      the number of bytes written, or 0 if the file could not be written
+ */
+size_t writeASTFile(const char *path, const flatAST *ast, size_t source_len);
+
+/*
+ * Same as decodeFlatAST() for the file at 'path', which is mapped into memory rather than read;
+ * returns NULL if it does not exist or is rejected
+ */
+flatAST *mapASTFile(const char *path, size_t source_len);
+
+#endif
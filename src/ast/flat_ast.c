@@ -0,0 +1,373 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * flat_ast.c - implements the conversion of the pointer-based AST to the flat one, and the
+ * functions that read it
+ */
+
+#include "flat_ast.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+/***************************************** FUNCTION HEADERS *****************************************/
+void appendNode(flatAST *ast, astNode *node);
+astIndex addNode(flatAST *ast, flat_kind kind, int32_t data);
+void serializeFlatName(nameId name, std::string &out);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "flat_ast.h" for details ***********************/
+flatAST *flattenAST(astNode *root) {
+    flatAST *ast = new flatAST();
+    appendNode(ast, root);
+    ast->kinds.shrink_to_fit();
+    ast->data.shrink_to_fit();
+    ast->sizes.shrink_to_fit();
+    return ast;
+}
+
+/*********************** see "flat_ast.h" for details ***********************/
+flatAST *createFlatAST() {
+    return new flatAST();
+}
+
+/*********************** see "flat_ast.h" for details ***********************/
+astIndex addFlatNode(flatAST *ast, flat_kind kind, int32_t data, astIndex first_child) {
+    addNode(ast, kind, data);
+    ast->sizes.back() = ast->kinds.size() - first_child;
+    return first_child;
+}
+
+/*********************** see "flat_ast.h" for details ***********************/
+astIndex addFlatLeaf(flatAST *ast, flat_kind kind, int32_t data) {
+    return addNode(ast, kind, data);
+}
+
+/*********************** see "flat_ast.h" for details ***********************/
+void finishFlatAST(flatAST *ast) {
+    size_t count = ast->kinds.size();
+    std::vector<uint8_t> kinds(count);
+    std::vector<int32_t> data(count);
+    std::vector<astIndex> sizes(count);
+
+    // a subtree occupies a range of nodes in both orders, with its children's subtrees in the
+    // same order, so a node moves forward by one for each of its ancestors (which come before it
+    // in preorder rather than after it). Going backwards, the ancestors of a node are the nodes
+    // seen so far whose subtree has not started yet.
+    std::vector<astIndex> ancestors; // where the subtree of each ancestor starts
+    for (astIndex node = count; node-- > 0;) {
+        astIndex start = node + 1 - ast->sizes[node];
+        while (!ancestors.empty() && ancestors.back() > node) {
+            ancestors.pop_back();
+        }
+        astIndex moved = start + ancestors.size();
+        kinds[moved] = ast->kinds[node];
+        data[moved] = ast->data[node];
+        sizes[moved] = ast->sizes[node];
+        ancestors.push_back(start);
+    }
+
+    ast->kinds.swap(kinds);
+    ast->data.swap(data);
+    ast->sizes.swap(sizes);
+}
+
+/*********************** see "flat_ast.h" for details ***********************/
+void freeFlatAST(flatAST *ast) {
+    delete ast;
+}
+
+/*********************** see "flat_ast.h" for details ***********************/
+size_t getFlatASTBytes(flatAST *ast) {
+    return ast->kinds.capacity() * sizeof(uint8_t) + ast->data.capacity() * sizeof(int32_t)
+        + ast->sizes.capacity() * sizeof(astIndex) + ast->slots.capacity() * sizeof(int32_t);
+}
+
+/*********************** see "flat_ast.h" for details ***********************/
+int countChildren(const flatAST *ast, astIndex node) {
+    int count = 0;
+    for (astIndex child = node + 1; child < getNextNode(ast, node); child = getNextNode(ast, child)) {
+        count++;
+    }
+    return count;
+}
+
+/*********************** see "flat_ast.h" for details ***********************/
+void getFunctions(const flatAST *ast, std::vector<astIndex> &functions) {
+    for (astIndex child = 1; child < getNextNode(ast, 0); child = getNextNode(ast, child)) {
+        if (ast->kinds[child] == flat_func) {
+            functions.push_back(child);
+        }
+    }
+}
+
+/*********************** see "flat_ast.h" for details ***********************/
+void serializeFlatNode(const flatAST *ast, astIndex root, std::string &out) {
+    // the nodes are in preorder, so one pass over the subtree encodes it in order. The only part
+    // of the encoding that follows a subtree instead of preceding it is the '-' of a missing else
+    // body, which waits on this stack for the end of its if statement
+    std::vector<astIndex> missing_else;
+    missing_else.reserve(AST_STACK_CAPACITY);
+
+    astIndex end = getNextNode(ast, root);
+    for (astIndex node = root; node < end; node++) {
+        while (!missing_else.empty() && missing_else.back() <= node) {
+            missing_else.pop_back();
+            out.push_back('-');
+        }
+
+        switch (ast->kinds[node]) {
+            case flat_prog: {
+                // only the functions are encoded; every program has the same externs
+                std::vector<astIndex> functions;
+                getFunctions(ast, functions);
+                out.push_back('P');
+                out += std::to_string(functions.size());
+                out.push_back(';');
+                break;
+            }
+            case flat_func: {
+                out.push_back('F');
+                serializeFlatName(ast->data[node], out);
+                if (ast->kinds[node + 1] != flat_var) {
+                    out.push_back('-');
+                }
+                break;
+            }
+            case flat_extern: {
+                if (node == root) {
+                    out.push_back('E');
+                    serializeFlatName(ast->data[node], out);
+                }
+                break;
+            }
+            case flat_var: {
+                out.push_back('V');
+                serializeFlatName(ast->data[node], out);
+                break;
+            }
+            case flat_cnst: {
+                out.push_back('C');
+                out += std::to_string(ast->data[node]);
+                out.push_back(';');
+                break;
+            }
+            case flat_rexpr:
+            case flat_bexpr:
+            case flat_uexpr: {
+                out.push_back(ast->kinds[node] == flat_rexpr ? 'R' : ast->kinds[node] == flat_bexpr ? 'B' : 'U');
+                out.push_back('0' + ast->data[node]);
+                break;
+            }
+            case flat_call: {
+                out.push_back('c');
+                serializeFlatName(ast->data[node], out);
+                if (ast->sizes[node] == 1) {
+                    out.push_back('-');
+                }
+                break;
+            }
+            case flat_ret: {
+                out.push_back('r');
+                break;
+            }
+            case flat_block: {
+                out.push_back('b');
+                out += std::to_string(countChildren(ast, node));
+                out.push_back(';');
+                break;
+            }
+            case flat_while:
+            case flat_asgn: {
+                out.push_back(ast->kinds[node] == flat_while ? 'w' : 'a');
+                break;
+            }
+            case flat_if: {
+                out.push_back('i');
+                if (countChildren(ast, node) < 3) {
+                    missing_else.push_back(getNextNode(ast, node));
+                }
+                break;
+            }
+            case flat_decl: {
+                out.push_back('d');
+                serializeFlatName(ast->data[node], out);
+                break;
+            }
+            default: {
+                fprintf(stderr, "Incorrect node type\n");
+                exit(1);
+            }
+        }
+    }
+    for (; !missing_else.empty(); missing_else.pop_back()) {
+        out.push_back('-');
+    }
+}
+
+/* one entry of appendNode()'s work stack: a node still to append or, when 'node' is NULL, the
+   index of an appended node whose subtree has been appended in full */
+typedef struct {
+    astNode *node;
+    astIndex index;
+} appendItem;
+
+/* appends 'root' and its subtree to 'ast' in preorder */
+void appendNode(flatAST *ast, astNode *root) {
+    std::vector<appendItem> stack;
+    stack.reserve(AST_STACK_CAPACITY);
+    stack.push_back({root, 0});
+
+    // a node's children go on the stack above the entry that closes the node, and are then
+    // reversed so that the first child is appended first
+    while (!stack.empty()) {
+        appendItem item = stack.back();
+        stack.pop_back();
+        if (item.node == NULL) {
+            ast->sizes[item.index] = ast->kinds.size() - item.index;
+            continue;
+        }
+
+        astNode *node = item.node;
+        size_t first = stack.size() + 1; // where the children go, after the closing entry
+        astIndex index;
+        switch (node->type) {
+            case ast_prog: {
+                index = addNode(ast, flat_prog, 0);
+                stack.push_back({NULL, index});
+                stack.push_back({node->prog.ext1, 0});
+                stack.push_back({node->prog.ext2, 0});
+                for (int i = 0; i < node->prog.func_list->size(); i++) {
+                    stack.push_back({node->prog.func_list->at(i), 0});
+                }
+                break;
+            }
+            case ast_func: {
+                index = addNode(ast, flat_func, node->func.name);
+                stack.push_back({NULL, index});
+                if (node->func.param != NULL) {
+                    stack.push_back({node->func.param, 0});
+                }
+                stack.push_back({node->func.body, 0});
+                break;
+            }
+            case ast_extern: {
+                index = addNode(ast, flat_extern, node->ext.name);
+                stack.push_back({NULL, index});
+                break;
+            }
+            case ast_var: {
+                index = addNode(ast, flat_var, node->var.name);
+                stack.push_back({NULL, index});
+                break;
+            }
+            case ast_cnst: {
+                index = addNode(ast, flat_cnst, node->cnst.value);
+                stack.push_back({NULL, index});
+                break;
+            }
+            case ast_rexpr: {
+                index = addNode(ast, flat_rexpr, node->rexpr.op);
+                stack.push_back({NULL, index});
+                stack.push_back({node->rexpr.lhs, 0});
+                stack.push_back({node->rexpr.rhs, 0});
+                break;
+            }
+            case ast_bexpr: {
+                index = addNode(ast, flat_bexpr, node->bexpr.op);
+                stack.push_back({NULL, index});
+                stack.push_back({node->bexpr.lhs, 0});
+                stack.push_back({node->bexpr.rhs, 0});
+                break;
+            }
+            case ast_uexpr: {
+                index = addNode(ast, flat_uexpr, node->uexpr.op);
+                stack.push_back({NULL, index});
+                stack.push_back({node->uexpr.expr, 0});
+                break;
+            }
+            case ast_stmt: {
+                astStmt *stmt = &node->stmt;
+                switch (stmt->type) {
+                    case ast_call: {
+                        index = addNode(ast, flat_call, stmt->call.name);
+                        stack.push_back({NULL, index});
+                        if (stmt->call.param != NULL) {
+                            stack.push_back({stmt->call.param, 0});
+                        }
+                        break;
+                    }
+                    case ast_ret: {
+                        index = addNode(ast, flat_ret, 0);
+                        stack.push_back({NULL, index});
+                        stack.push_back({stmt->ret.expr, 0});
+                        break;
+                    }
+                    case ast_block: {
+                        index = addNode(ast, flat_block, 0);
+                        stack.push_back({NULL, index});
+                        for (int i = 0; i < stmt->block.stmt_list->size(); i++) {
+                            stack.push_back({stmt->block.stmt_list->at(i), 0});
+                        }
+                        break;
+                    }
+                    case ast_while: {
+                        index = addNode(ast, flat_while, 0);
+                        stack.push_back({NULL, index});
+                        stack.push_back({stmt->whilen.cond, 0});
+                        stack.push_back({stmt->whilen.body, 0});
+                        break;
+                    }
+                    case ast_if: {
+                        index = addNode(ast, flat_if, 0);
+                        stack.push_back({NULL, index});
+                        stack.push_back({stmt->ifn.cond, 0});
+                        stack.push_back({stmt->ifn.if_body, 0});
+                        if (stmt->ifn.else_body != NULL) {
+                            stack.push_back({stmt->ifn.else_body, 0});
+                        }
+                        break;
+                    }
+                    case ast_asgn: {
+                        index = addNode(ast, flat_asgn, 0);
+                        stack.push_back({NULL, index});
+                        stack.push_back({stmt->asgn.lhs, 0});
+                        stack.push_back({stmt->asgn.rhs, 0});
+                        break;
+                    }
+                    case ast_decl: {
+                        index = addNode(ast, flat_decl, stmt->decl.name);
+                        stack.push_back({NULL, index});
+                        break;
+                    }
+                    default: {
+                        fprintf(stderr, "Incorrect statement type\n");
+                        exit(1);
+                    }
+                }
+                break;
+            }
+            default: {
+                fprintf(stderr, "Incorrect node type\n");
+                exit(1);
+            }
+        }
+        std::reverse(stack.begin() + first, stack.end());
+    }
+}
+
+/* appends a node with no children yet to 'ast' and returns its index */
+astIndex addNode(flatAST *ast, flat_kind kind, int32_t data) {
+    ast->kinds.push_back(kind);
+    ast->data.push_back(data);
+    ast->sizes.push_back(1);
+    return ast->kinds.size() - 1;
+}
+
+/* same encoding as the one serializeNode() uses for names */
+void serializeFlatName(nameId name, std::string &out) {
+    out += std::to_string(getNameLength(name));
+    out.push_back(':');
+    out.append(getName(name), getNameLength(name));
+}
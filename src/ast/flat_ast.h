@@ -0,0 +1,144 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * flat_ast.h - defines a compact, index-based form of the abstract syntax tree: the nodes are
+ * stored in preorder in parallel arrays, so a node's subtree is the contiguous range of nodes
+ * that starts with it, and the phases after parsing walk the program in memory order
+ */
+
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "ast.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+ * Index of a node in a flatAST; the root is 0
+ */
+typedef uint32_t astIndex;
+
+/*
+ * Kinds of node. Their children, in order, are:
+ *      flat_prog: the two externs (in source order), then every function in source order
+ *      flat_func: the parameter (a flat_var) if the function takes one, then the body
+ *      flat_call: the argument, if there is one
+ *      flat_if: the condition, the if body, then the else body if there is one
+ *      flat_while: the condition, then the body
+ *      flat_asgn: the variable (a flat_var), then the expression
+ *      flat_ret, flat_uexpr: the expression
+ *      flat_rexpr, flat_bexpr: the left-hand side, then the right-hand side
+ *      flat_block: its statements
+ *      flat_extern, flat_var, flat_cnst, flat_decl: none
+ */
+typedef enum {
+    flat_prog,
+    flat_extern,
+    flat_func,
+    flat_var,
+    flat_cnst,
+    flat_rexpr,
+    flat_bexpr,
+    flat_uexpr,
+    flat_call,
+    flat_ret,
+    flat_block,
+    flat_while,
+    flat_if,
+    flat_asgn,
+    flat_decl
+} flat_kind;
+
+/*
+ * A program in flat form. Once built, the nodes are in preorder, so the subtree of node i is
+ * nodes i to i + sizes[i] - 1. While it is being built with addFlatNode() and addFlatLeaf(),
+ * the nodes are in the order they are completed in (postorder), the subtree of node i ending
+ * with it; finishFlatAST() puts them in preorder.
+ */
+typedef struct {
+    std::vector<uint8_t> kinds; // the flat_kind of each node
+    std::vector<int32_t> data; // name ID (extern, func, var, call, decl), value (cnst) or operator
+                               // (rexpr, bexpr, uexpr) of each node; 0 for the others
+    std::vector<astIndex> sizes; // number of nodes in the subtree of each node, itself included
+    std::vector<int32_t> slots; // slot of the variable each var and decl node refers to, numbered
+                                // from 0 within each function; empty until isValidAST() fills it
+} flatAST;
+
+/*
+ * Params:
+ *      astNode *root: the root of the AST of a miniC program (an 'ast_prog' node)
+ *
+ * Returns:
+ *      a pointer to a newly allocated flatAST holding the same program; 'root' is not
+ *      modified and may be freed independently
+ */
+flatAST *flattenAST(astNode *root);
+
+/*
+ * Returns a pointer to a newly allocated flatAST with no nodes, to be built bottom-up: every
+ * node is added once its children have been (e.g. by the parser, as it reduces each rule)
+ */
+flatAST *createFlatAST();
+
+/*
+ * Params:
+ *      flatAST *ast: a flatAST that is being built
+ *
+ *      flat_kind kind, int32_t data: the kind of the new node and its entry in 'data'
+ *
+ *      astIndex first_child: the value addFlatNode() or addFlatLeaf() returned for the first
+ *      child of the new node; its other children must have been added after it, in order
+ *
+ * Returns:
+ *      the index the subtree of the new node starts at, which its parent is built from
+ */
+astIndex addFlatNode(flatAST *ast, flat_kind kind, int32_t data, astIndex first_child);
+
+/*
+ * Same as above for a node with no children
+ */
+astIndex addFlatLeaf(flatAST *ast, flat_kind kind, int32_t data);
+
+/*
+ * Puts the nodes of 'ast', whose last node is the root of the program, in preorder once it
+ * has been built. Takes a single pass over the nodes and no recursion.
+ */
+void finishFlatAST(flatAST *ast);
+
+/*
+ * Frees 'ast' and its arrays
+ */
+void freeFlatAST(flatAST *ast);
+
+/*
+ * Returns the number of bytes the node arrays of 'ast' take up
+ */
+size_t getFlatASTBytes(flatAST *ast);
+
+/*
+ * Returns the index of the node that follows the subtree of 'node': its next sibling, or
+ * the end of its parent's subtree. The children of 'node' are therefore found by starting at
+ * node + 1 and stepping with getNextNode() until getNextNode(ast, node) is reached.
+ */
+inline astIndex getNextNode(const flatAST *ast, astIndex node) {
+    return node + ast->sizes[node];
+}
+
+/*
+ * Returns the number of children of 'node'
+ */
+int countChildren(const flatAST *ast, astIndex node);
+
+/*
+ * Appends the indices of the program's functions (the 'flat_func' children of the root) to
+ * 'functions', in source order
+ */
+void getFunctions(const flatAST *ast, std::vector<astIndex> &functions);
+
+/*
+ * Appends the encoding of the subtree of 'node' to 'out'; it is the same encoding
+ * serializeNode() produces for the corresponding astNode (see "ast.h")
+ */
+void serializeFlatNode(const flatAST *ast, astIndex node, std::string &out);
+
+#endif
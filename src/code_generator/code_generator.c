@@ -1,6 +1,6 @@
 /* Author: Eric Richardson
  * Dartmouth CS57, Spring 2023
- * ir_generator.c - implements functions necessary for performing assembly code generation
+ * code_generator.c - implements functions necessary for performing assembly code generation
  */
 
 #include "code_generator.h"
@@ -25,21 +25,46 @@ bool isReturnTypeVoid(LLVMValueRef call_inst) {
         LLVMTypeRef func_type = LLVMGetCalledFunctionType(call_inst);
         LLVMTypeRef ret_type = LLVMGetReturnType(func_type);
 
-        if (ret_type == LLVMVoidType()) {
+        if (LLVMGetTypeKind(ret_type) == LLVMVoidTypeKind) {
             return true;
         }
     }
     return false;
 }
 
+/*
+ * Finds the values of the provided function that live past the end of the block that defines
+ * them: phi nodes, the values they merge and any value used in another block. Registers are
+ * only allocated within a block, so each of these gets a stack slot of its own instead
+ */
+std::unordered_set<LLVMValueRef> getCrossBlockValues(LLVMValueRef function) {
+    std::unordered_set<LLVMValueRef> cross_block;
+    for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(bb); instruction; instruction = LLVMGetNextInstruction(instruction)) {
+            if (LLVMIsAPHINode(instruction)) {
+                cross_block.insert(instruction);
+                continue;
+            }
+            for (LLVMUseRef use = LLVMGetFirstUse(instruction); use; use = LLVMGetNextUse(use)) {
+                LLVMValueRef user = LLVMGetUser(use);
+                if (LLVMIsAPHINode(user) || LLVMGetInstructionParent(user) != bb) {
+                    cross_block.insert(instruction);
+                    break;
+                }
+            }
+        }
+    }
+    return cross_block;
+}
+
 /*
  * Assigns index values and computes the 'liveness range' for each instruction 
- * in a given basic block. 
+ * in a given basic block. Values in 'cross_block' get no range, as they are not given a register.
  *
  * Note: it is expected that the caller passes empty maps by reference for 'inst_index' and 
  * 'live_range' 
  */
-void computeLiveness(LLVMBasicBlockRef bb, std::unordered_map<LLVMValueRef, int> &inst_index, std::unordered_map<LLVMValueRef, std::pair<int, int>> &live_range) {
+void computeLiveness(LLVMBasicBlockRef bb, std::unordered_set<LLVMValueRef> &cross_block, std::unordered_map<LLVMValueRef, int> &inst_index, std::unordered_map<LLVMValueRef, std::pair<int, int>> &live_range) {
 
     // assign an index to all non-alloca instructions
     int i = 0;
@@ -56,7 +81,8 @@ void computeLiveness(LLVMBasicBlockRef bb, std::unordered_map<LLVMValueRef, int>
 
     // Determine index range for which each instruction is live
     for (LLVMValueRef instruction = LLVMGetFirstInstruction(bb); instruction; instruction = LLVMGetNextInstruction(instruction)) {
-        if (LLVMIsAAllocaInst(instruction) || LLVMIsAStoreInst(instruction) || LLVMIsABranchInst(instruction) || LLVMIsAReturnInst(instruction) || isReturnTypeVoid(instruction)) {
+        if (LLVMIsAAllocaInst(instruction) || LLVMIsAStoreInst(instruction) || LLVMIsABranchInst(instruction) || LLVMIsAReturnInst(instruction) || isReturnTypeVoid(instruction)
+                || cross_block.count(instruction)) {
             continue;
         }
         
@@ -93,9 +119,13 @@ void computeLiveness(LLVMBasicBlockRef bb, std::unordered_map<LLVMValueRef, int>
 
 }
 
-// Comparator used for sorting live range end times
+// Comparator used for sorting live range end times; ties are broken by start index so the
+// order never depends on where the instructions happen to be allocated
 bool reg_cmp(std::pair<LLVMValueRef, std::pair<int, int>> &a, std::pair<LLVMValueRef, std::pair<int, int>> &b) {
-    return a.second.second > b.second.second;
+    if (a.second.second != b.second.second) {
+        return a.second.second > b.second.second;
+    }
+    return a.second.first < b.second.first;
 }
 
 // Sorts the keys of 'live_range' in descending end-index order
@@ -132,10 +162,11 @@ LLVMValueRef findSpill(LLVMBasicBlockRef bb, std::vector<LLVMValueRef> &sorted_v
  */
 std::unordered_map<LLVMValueRef, int> allocateRegisters(LLVMValueRef function, std::unordered_map<LLVMValueRef, int> &inst_index, std::unordered_map<LLVMValueRef, std::pair<int, int>> &live_range) {
     std::unordered_map<LLVMValueRef, int> reg_map;
+    std::unordered_set<LLVMValueRef> cross_block = getCrossBlockValues(function);
     for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
         std::unordered_set<int> available_registers ({EBX, ECX, EDX});
         
-        computeLiveness(bb, inst_index, live_range);
+        computeLiveness(bb, cross_block, inst_index, live_range);
         
         for (LLVMValueRef instruction = LLVMGetFirstInstruction(bb); instruction; instruction = LLVMGetNextInstruction(instruction)) {
             if (LLVMIsAAllocaInst(instruction)) { 
@@ -158,6 +189,9 @@ std::unordered_map<LLVMValueRef, int> allocateRegisters(LLVMValueRef function, s
                 }
    
             }
+            else if (cross_block.count(instruction)) {
+                // kept in its stack slot (see getOffsetMap()); the registers of its operands are freed below
+            }
             else {
                 
                 LLVMOpcode opcode = LLVMGetInstructionOpcode(instruction);
@@ -168,10 +202,14 @@ std::unordered_map<LLVMValueRef, int> allocateRegisters(LLVMValueRef function, s
 
                     if (reg_map.count(first_op) && reg_map.at(first_op) != SPILL && live_range.at(first_op).second <= inst_index.at(instruction)) {
                         
-                        std::unordered_set<int>::iterator reg_it = available_registers.begin();
-                        int reg = *reg_it;
-                        
-                        available_registers.erase(reg);
+                        // the first operand dies here, so its register is free for the result if
+                        // no other one is
+                        int reg = reg_map.at(first_op);
+                        if (!available_registers.empty()) {
+                            std::unordered_set<int>::iterator reg_it = available_registers.begin();
+                            reg = *reg_it;
+                            available_registers.erase(reg);
+                        }
                         std::pair<LLVMValueRef, int> reg_entry (instruction, reg);
                         reg_map.insert(reg_entry);
 
@@ -232,6 +270,10 @@ std::unordered_map<LLVMValueRef, int> allocateRegisters(LLVMValueRef function, s
                 }
                     
             }
+            // an operand that died here may have handed its register to this instruction
+            if (reg_map.count(instruction) && reg_map.at(instruction) != SPILL) {
+                available_registers.erase(reg_map.at(instruction));
+            }
                 
         }
         
@@ -245,15 +287,18 @@ std::unordered_map<LLVMValueRef, int> allocateRegisters(LLVMValueRef function, s
 
 /* 
  * Calculates the offset map for all local/temporary variables in the
- * provided function; also populates local_mem variable
+ * provided function; also populates local_mem variable. Values that did not get a register
+ * in 'reg_map' and are never stored to a variable get a stack slot of their own
  */
-std::unordered_map<LLVMValueRef, int> getOffsetMap(LLVMValueRef function, int *local_mem) {
+std::unordered_map<LLVMValueRef, int> getOffsetMap(LLVMValueRef function, std::unordered_map<LLVMValueRef, int> &reg_map, int *local_mem) {
     std::unordered_map<LLVMValueRef, int> offset_map;
-    LLVMValueRef param;
+    LLVMValueRef param = NULL;
 
+    // the parameter is read from where the caller pushed it, as is a variable it is stored to
     if (LLVMCountParams(function)) {
         param = LLVMGetParam(function, 0);
-        *local_mem = 4;
+        std::pair<LLVMValueRef, int> offset_entry (param, 8);
+        offset_map.insert(offset_entry);
     }
     
     for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
@@ -293,29 +338,39 @@ std::unordered_map<LLVMValueRef, int> getOffsetMap(LLVMValueRef function, int *l
             
         }
     }
-    *local_mem *= -1;
-    if (param != NULL) {
-        *local_mem += 8;
+
+    // spilled (or unallocated) temporaries are computed in %eax and written to their own slot
+    for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(bb); instruction; instruction = LLVMGetNextInstruction(instruction)) {
+            if (LLVMIsAAllocaInst(instruction) || LLVMIsAStoreInst(instruction) || LLVMIsABranchInst(instruction)
+                    || LLVMIsAReturnInst(instruction) || isReturnTypeVoid(instruction) || offset_map.count(instruction)
+                    || (reg_map.count(instruction) && reg_map.at(instruction) != SPILL)) {
+                continue;
+            }
+            *local_mem -= 4;
+            std::pair<LLVMValueRef, int> offset_entry (instruction, *local_mem);
+            offset_map.insert(offset_entry);
+        }
     }
+    *local_mem *= -1;
     return offset_map;
 }
 
 /*
- * Assigns a string label to each basic block in the provided function
+ * Assigns a string label to each basic block in the provided function; labels are prefixed
+ * with the function's name, so a function's assembly is the same wherever it appears in the
+ * output file
  */
 std::unordered_map<LLVMBasicBlockRef, std::string> createBBLabels(LLVMValueRef function) {
     
     std::unordered_map<LLVMBasicBlockRef, std::string> bb_labels;
 
-    LLVMBasicBlockRef first_bb = LLVMGetFirstBasicBlock(function);
-    const char *first_label = ".LFB0";
-
-    std::pair<LLVMBasicBlockRef, std::string> first (first_bb, first_label);
-    bb_labels.insert(first);
+    size_t func_len;
+    std::string prefix = ".L" + std::string(LLVMGetValueName2(function, &func_len)) + ".";
 
-    int count = 1;
-    for (LLVMBasicBlockRef bb = LLVMGetNextBasicBlock(first_bb); bb; bb = LLVMGetNextBasicBlock(bb)) {
-        std::string label = ".L" + std::to_string(count);
+    int count = 0;
+    for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+        std::string label = prefix + std::to_string(count);
         std::pair<LLVMBasicBlockRef, std::string> bblabel_entry (bb, label);
         bb_labels.insert(bblabel_entry);
 
@@ -327,19 +382,14 @@ std::unordered_map<LLVMBasicBlockRef, std::string> createBBLabels(LLVMValueRef f
 /*
  * Writes the function prologue to the provided file
  */
-void printDirectives(LLVMModuleRef module, LLVMValueRef function, FILE *fp) {
-    size_t flen;
-    const char *fname = LLVMGetSourceFileName(module, &flen);
-
+void printDirectives(LLVMValueRef function, std::unordered_map<LLVMBasicBlockRef, std::string> &bb_labels, FILE *fp) {
     size_t func_len;
     const char *func_name = LLVMGetValueName2(function, &func_len);
 
-    fprintf(fp, "\t.file\t\"%s\"\n", fname);
-    fprintf(fp, "\t.text\n");
     fprintf(fp, "\t.globl\t%s\n", func_name);
     fprintf(fp, "\t.type\t%s, @function\n", func_name);
     fprintf(fp, "%s:\n", func_name);
-    fprintf(fp, ".LFB0:\n");
+    fprintf(fp, "%s:\n", bb_labels.at(LLVMGetFirstBasicBlock(function)).c_str());
     fprintf(fp, "\tpushl\t%%ebp\n");
     fprintf(fp, "\tmovl\t%%esp, %%ebp\n");
 
@@ -376,20 +426,292 @@ const char *getRegisterStr(int reg) {
     }
 }
 
+/*
+ * Determines whether the provided basic block starts with phi nodes
+ */
+bool hasPhis(LLVMBasicBlockRef bb) {
+    LLVMValueRef first = LLVMGetFirstInstruction(bb);
+    return first != NULL && LLVMIsAPHINode(first);
+}
+
+/*
+ * Writes the copies that give the phi nodes of 'to' the values they take when it is entered
+ * from 'from'. The phis take their values all at once (one may merge another), so every value
+ * is pushed before any phi's slot is written; pushes and pops leave the flags alone
+ */
+void printPhiCopies(LLVMBasicBlockRef from, LLVMBasicBlockRef to, std::unordered_map<LLVMValueRef, int> &reg_map, std::unordered_map<LLVMValueRef, int> &offset_map, FILE *fp) {
+    std::vector<LLVMValueRef> copied;
+    for (LLVMValueRef phi = LLVMGetFirstInstruction(to); phi && LLVMIsAPHINode(phi); phi = LLVMGetNextInstruction(phi)) {
+        for (unsigned i = 0; i < LLVMCountIncoming(phi); i++) {
+            LLVMValueRef value = LLVMGetIncomingValue(phi, i);
+            if (LLVMGetIncomingBlock(phi, i) != from || value == phi) {
+                continue;
+            }
+            if (LLVMIsAConstantInt(value)) {
+                int const_val = LLVMConstIntGetSExtValue(value);
+                fprintf(fp, "\tpushl\t$%d\n", const_val);
+            }
+            else if (reg_map.count(value) && reg_map.at(value) != SPILL) {
+                fprintf(fp, "\tpushl\t%%%s\n", getRegisterStr(reg_map.at(value)));
+            }
+            else {
+                int offset = offset_map.at(value);
+                fprintf(fp, "\tpushl\t%d(%%ebp)\n", offset);
+            }
+            copied.push_back(phi);
+            break;
+        }
+    }
+    for (int i = (int)copied.size() - 1; i >= 0; i--) {
+        fprintf(fp, "\tpopl\t%d(%%ebp)\n", offset_map.at(copied.at(i)));
+    }
+}
+
+/*
+ * Determines whether 'type' is an integer type of exactly 'bits' bits
+ */
+bool isIntType(LLVMTypeRef type, unsigned bits) {
+    return LLVMGetTypeKind(type) == LLVMIntegerTypeKind && LLVMGetIntTypeWidth(type) == bits;
+}
+
+/*
+ * Returns the first line of the textual IR of 'value', without its indentation, for error messages
+ */
+std::string describeValue(LLVMValueRef value) {
+    char *text = LLVMPrintValueToString(value);
+    std::string description = text;
+    LLVMDisposeMessage(text);
+    size_t start = description.find_first_not_of(' ');
+    description.erase(0, start == std::string::npos ? description.size() : start);
+    size_t newline = description.find('\n');
+    if (newline != std::string::npos) {
+        description.erase(newline);
+    }
+    return description;
+}
+
+/*
+ * Returns why a function of type 'type' (a function type) cannot be defined in a program the
+ * code generator handles, or NULL if it can: it must return i32 and take at most one i32
+ */
+const char *checkFunctionType(LLVMTypeRef type) {
+    if (!isIntType(LLVMGetReturnType(type), 32)) {
+        return "does not return i32";
+    }
+    if (LLVMIsFunctionVarArg(type)) {
+        return "takes a variable number of arguments";
+    }
+    if (LLVMCountParamTypes(type) > 1) {
+        return "takes more than one parameter";
+    }
+    if (LLVMCountParamTypes(type) == 1) {
+        LLVMTypeRef param_type;
+        LLVMGetParamTypes(type, &param_type);
+        if (!isIntType(param_type, 32)) {
+            return "takes a parameter that is not an i32";
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Returns why the call 'call' cannot be generated, or NULL if it can: it must call 'print'
+ * (void(i32)), 'read' (i32(), with no arguments) or a function the module defines, with the
+ * function's own type
+ */
+const char *checkCall(LLVMValueRef call) {
+    LLVMValueRef callee = LLVMGetCalledValue(call);
+    if (!LLVMIsAFunction(callee)) {
+        return "calls something other than a function";
+    }
+    LLVMTypeRef type = LLVMGlobalGetValueType(callee);
+    if (LLVMGetCalledFunctionType(call) != type) {
+        return "calls a function with a type other than its own";
+    }
+    if (LLVMCountBasicBlocks(callee) > 0) {
+        return NULL; // its type is checked with its body
+    }
+
+    size_t name_len;
+    std::string name = LLVMGetValueName2(callee, &name_len);
+    LLVMTypeRef param_type;
+    bool one_i32 = LLVMCountParamTypes(type) == 1 && !LLVMIsFunctionVarArg(type)
+        && (LLVMGetParamTypes(type, &param_type), isIntType(param_type, 32));
+    if (name == "print" && LLVMGetTypeKind(LLVMGetReturnType(type)) == LLVMVoidTypeKind && one_i32) {
+        return NULL;
+    }
+    // C declares read() without a prototype, which clang turns into i32 (...)
+    if (name == "read" && isIntType(LLVMGetReturnType(type), 32) && LLVMCountParamTypes(type) == 0
+            && LLVMGetNumArgOperands(call) == 0) {
+        return NULL;
+    }
+    return "calls a function other than print(i32), read() or one the module defines";
+}
+
+/*
+ * Returns why the code generator cannot generate 'instruction', or NULL if it can. It handles
+ * the instructions the IR generator emits and the optimizer keeps: i32 arithmetic (add, sub,
+ * mul, sdiv), comparisons that a conditional branch right after them consumes, branches,
+ * returns, phi nodes, calls (see checkCall()), and loads and stores of i32 variables allocated
+ * in the entry block
+ */
+const char *checkInstruction(LLVMValueRef instruction) {
+    LLVMBasicBlockRef bb = LLVMGetInstructionParent(instruction);
+    LLVMOpcode opcode = LLVMGetInstructionOpcode(instruction);
+
+    // every operand is an integer constant, the parameter, another instruction or a block; the
+    // last operand of a call is the callee, which checkCall() looks at
+    int num_operands = LLVMGetNumOperands(instruction) - (opcode == LLVMCall ? 1 : 0);
+    for (int i = 0; i < num_operands; i++) {
+        LLVMValueRef operand = LLVMGetOperand(instruction, i);
+        if (!LLVMIsAConstantInt(operand) && !LLVMIsAArgument(operand) && !LLVMIsAInstruction(operand)
+                && !LLVMValueIsBasicBlock(operand)) {
+            return "has an operand that is not an integer constant, the parameter or an instruction";
+        }
+    }
+
+    switch (opcode) {
+        case LLVMAlloca: {
+            LLVMValueRef count = LLVMGetOperand(instruction, 0);
+            if (!isIntType(LLVMGetAllocatedType(instruction), 32) || bb != LLVMGetEntryBasicBlock(LLVMGetBasicBlockParent(bb))
+                    || !LLVMIsAConstantInt(count) || LLVMConstIntGetZExtValue(count) != 1) {
+                return "allocates something other than a single i32 in the entry block";
+            }
+            return NULL;
+        }
+        case LLVMLoad: {
+            if (!isIntType(LLVMTypeOf(instruction), 32) || !LLVMIsAAllocaInst(LLVMGetOperand(instruction, 0))) {
+                return "loads something other than an i32 variable";
+            }
+            return NULL;
+        }
+        case LLVMStore: {
+            if (!isIntType(LLVMTypeOf(LLVMGetOperand(instruction, 0)), 32)
+                    || !LLVMIsAAllocaInst(LLVMGetOperand(instruction, 1))) {
+                return "stores something other than an i32 to a variable";
+            }
+            return NULL;
+        }
+        case LLVMAdd:
+        case LLVMSub:
+        case LLVMMul:
+        case LLVMSDiv:
+        case LLVMPHI: {
+            if (!isIntType(LLVMTypeOf(instruction), 32)) {
+                return "computes a value that is not an i32";
+            }
+            return NULL;
+        }
+        case LLVMICmp: {
+            // the branch jumps on the flags the comparison sets, so nothing may come in between
+            LLVMIntPredicate predicate = LLVMGetICmpPredicate(instruction);
+            if (predicate != LLVMIntEQ && predicate != LLVMIntSLT && predicate != LLVMIntSLE
+                    && predicate != LLVMIntSGT && predicate != LLVMIntSGE) {
+                return "compares with a predicate other than eq, slt, sle, sgt or sge";
+            }
+            if (!isIntType(LLVMTypeOf(LLVMGetOperand(instruction, 0)), 32)) {
+                return "compares values that are not i32";
+            }
+            LLVMValueRef next = LLVMGetNextInstruction(instruction);
+            LLVMUseRef use = LLVMGetFirstUse(instruction);
+            if (next == NULL || !LLVMIsABranchInst(next) || !LLVMIsConditional(next) || LLVMGetCondition(next) != instruction
+                    || use == NULL || LLVMGetNextUse(use) != NULL) {
+                return "is not used only by the conditional branch right after it";
+            }
+            return NULL;
+        }
+        case LLVMBr: {
+            if (LLVMIsConditional(instruction)) {
+                LLVMValueRef cond = LLVMGetCondition(instruction);
+                if (!LLVMIsAConstantInt(cond) && !LLVMIsAICmpInst(cond)) {
+                    return "branches on something other than a comparison";
+                }
+            }
+            return NULL;
+        }
+        case LLVMRet: {
+            return NULL; // the function returns i32, so the verifier made sure there is a value
+        }
+        case LLVMCall: {
+            return checkCall(instruction);
+        }
+        default: {
+            return "is not an instruction the code generator supports";
+        }
+    }
+}
+
 /*********************** see "code_generator.h" for details ***********************/
-void generateAssembly(LLVMModuleRef module) {
-    FILE *fp = fopen("func.s", "w");
+bool isSupportedModule(LLVMModuleRef module, const char *name, FILE *diagnostics) {
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        if (LLVMCountBasicBlocks(function) == 0) {
+            continue; // declarations are checked where they are called
+        }
+
+        size_t name_len;
+        const char *func_name = LLVMGetValueName2(function, &name_len);
+        const char *reason = checkFunctionType(LLVMGlobalGetValueType(function));
+        if (reason != NULL) {
+            fprintf(diagnostics, "Error: '%s' is not IR the compiler supports: function '%s' %s\n", name, func_name, reason);
+            return false;
+        }
+        for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+            for (LLVMValueRef instruction = LLVMGetFirstInstruction(bb); instruction; instruction = LLVMGetNextInstruction(instruction)) {
+                reason = checkInstruction(instruction);
+                if (reason != NULL) {
+                    fprintf(diagnostics, "Error: '%s' is not IR the compiler supports: in function '%s', '%s' %s\n", name,
+                        func_name, describeValue(instruction).c_str(), reason);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/*********************** see "code_generator.h" for details ***********************/
+bool generateAssembly(LLVMModuleRef module, const char *filename) {
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: unable to open '%s' for writing\n", filename);
+        return false;
+    }
+    generateAssembly(module, fp);
+    bool ok = !ferror(fp);
+    return fclose(fp) == 0 && ok;
+}
+
+/*********************** see "code_generator.h" for details ***********************/
+void generateAssembly(LLVMModuleRef module, FILE *fp) {
+    size_t flen;
+    generateAssemblyHeader(LLVMGetSourceFileName(module, &flen), fp);
+
+    // only functions defined in the program have a body; 'print', 'read' and the like are external
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        if (LLVMCountBasicBlocks(function) > 0) {
+            generateFunctionAssembly(function, fp);
+        }
+    }
+}
+
+/*********************** see "code_generator.h" for details ***********************/
+void generateAssemblyHeader(const char *source_filename, FILE *fp) {
+    fprintf(fp, "\t.file\t\"%s\"\n", source_filename);
+    fprintf(fp, "\t.text\n");
+}
+
+/*********************** see "code_generator.h" for details ***********************/
+void generateFunctionAssembly(LLVMValueRef function, FILE *fp) {
     std::unordered_map<LLVMValueRef, int> inst_index;
     std::unordered_map<LLVMValueRef, std::pair<int, int>> live_range;
 
-    LLVMValueRef function = LLVMGetLastFunction(module);
     std::unordered_map<LLVMValueRef, int> reg_map = allocateRegisters(function, inst_index, live_range);
     
     int local_mem = 0;
-    std::unordered_map<LLVMValueRef, int> offset_map = getOffsetMap(function, &local_mem);
+    std::unordered_map<LLVMValueRef, int> offset_map = getOffsetMap(function, reg_map, &local_mem);
 
     std::unordered_map<LLVMBasicBlockRef, std::string> bb_labels = createBBLabels(function);
-    printDirectives(module, function, fp);
+    printDirectives(function, bb_labels, fp);
     fprintf(fp, "\tsubl\t$%d, %%esp\n", local_mem);
     fprintf(fp, "\tpushl\t%%ebx\n");
 
@@ -481,7 +803,7 @@ void generateAssembly(LLVMModuleRef module) {
                     fprintf(fp, "\tpopl\t%%ecx\n");
                     fprintf(fp, "\tpopl\t%%ebx\n");
 
-                    if (!LLVMCountParams(func_call)) {
+                    if (!isReturnTypeVoid(instruction)) {
                         if (reg_map.count(instruction) && reg_map.at(instruction) != SPILL) {
                             
                             fprintf(fp, "\tmovl\t%%eax, %%%s\n", getRegisterStr(reg_map.at(instruction)));
@@ -493,11 +815,16 @@ void generateAssembly(LLVMModuleRef module) {
                     }
                     break;
                 }
+                // the phi nodes of a block are written by the branches into it
+                case LLVMPHI: {
+                    break;
+                }
                 case LLVMBr: {
                     if (!LLVMIsConditional(instruction)) {
                         LLVMValueRef bb_value = LLVMGetOperand(instruction, 0);
                         LLVMBasicBlockRef bb_ref = LLVMValueAsBasicBlock(bb_value);
                         const char *jump_to = bb_labels.at(bb_ref).c_str();
+                        printPhiCopies(bb, bb_ref, reg_map, offset_map, fp);
                         fprintf(fp, "\tjmp\t%s\n", jump_to); 
                     }
                     else {
@@ -507,10 +834,21 @@ void generateAssembly(LLVMModuleRef module) {
                         LLVMBasicBlockRef if_bb = LLVMValueAsBasicBlock(if_bb_val);
                         LLVMBasicBlockRef else_bb = LLVMValueAsBasicBlock(else_bb_val);
 
-                        const char *if_label = bb_labels.at(if_bb).c_str();
-                        const char *else_label = bb_labels.at(else_bb).c_str();
-
+                        // a comparison of constants is folded when it is built, and always takes the same branch
                         LLVMValueRef cond = LLVMGetCondition(instruction);
+                        if (LLVMIsAConstantInt(cond)) {
+                            LLVMBasicBlockRef taken = LLVMConstIntGetZExtValue(cond) ? if_bb : else_bb;
+                            printPhiCopies(bb, taken, reg_map, offset_map, fp);
+                            fprintf(fp, "\tjmp\t%s\n", bb_labels.at(taken).c_str());
+                            break;
+                        }
+
+                        // a target with phi nodes is jumped to through a stub that copies their values first
+                        std::string if_target = hasPhis(if_bb) ? bb_labels.at(bb) + ".if" : bb_labels.at(if_bb);
+                        std::string else_target = hasPhis(else_bb) ? bb_labels.at(bb) + ".else" : bb_labels.at(else_bb);
+                        const char *if_label = if_target.c_str();
+                        const char *else_label = else_target.c_str();
+
                         LLVMIntPredicate predicate = LLVMGetICmpPredicate(cond);
 
                         switch (predicate) {
@@ -540,6 +878,17 @@ void generateAssembly(LLVMModuleRef module) {
                             }
                         }
                         fprintf(fp, "\tjmp\t%s\n", else_label);
+
+                        if (hasPhis(if_bb)) {
+                            fprintf(fp, "%s:\n", if_label);
+                            printPhiCopies(bb, if_bb, reg_map, offset_map, fp);
+                            fprintf(fp, "\tjmp\t%s\n", bb_labels.at(if_bb).c_str());
+                        }
+                        if (hasPhis(else_bb)) {
+                            fprintf(fp, "%s:\n", else_label);
+                            printPhiCopies(bb, else_bb, reg_map, offset_map, fp);
+                            fprintf(fp, "\tjmp\t%s\n", bb_labels.at(else_bb).c_str());
+                        }
                     }
                     break;
                 }
@@ -682,6 +1031,62 @@ void generateAssembly(LLVMModuleRef module) {
                     }
                     break;
                 }
+                case LLVMSDiv: {
+                    int reg;
+                    if (reg_map.count(instruction) && reg_map.at(instruction) != SPILL) {
+                        reg = reg_map.at(instruction);
+                    }
+                    else {
+                        reg = EAX;
+                    }
+
+                    LLVMValueRef op1 = LLVMGetOperand(instruction, 0);
+                    LLVMValueRef op2 = LLVMGetOperand(instruction, 1);
+
+                    // idivl divides %edx:%eax, so %edx is saved around it unless it receives the
+                    // result; the divisor goes on the stack, where cltd cannot overwrite it
+                    if (reg != EDX) {
+                        fprintf(fp, "\tpushl\t%%edx\n");
+                    }
+                    if (LLVMIsAConstantInt(op2)) {
+                        int const_val_op2 = LLVMConstIntGetSExtValue(op2);
+                        fprintf(fp, "\tpushl\t$%d\n", const_val_op2);
+                    }
+                    else if (reg_map.count(op2) && reg_map.at(op2) != SPILL) {
+                        fprintf(fp, "\tpushl\t%%%s\n", getRegisterStr(reg_map.at(op2)));
+                    }
+                    else {
+                        int offset_op2 = offset_map.at(op2);
+                        fprintf(fp, "\tpushl\t%d(%%ebp)\n", offset_op2);
+                    }
+
+                    if (LLVMIsAConstantInt(op1)) {
+                        int const_val_op1 = LLVMConstIntGetSExtValue(op1);
+                        fprintf(fp, "\tmovl\t$%d, %%eax\n", const_val_op1);
+                    }
+                    else if (reg_map.count(op1) && reg_map.at(op1) != SPILL) {
+                        fprintf(fp, "\tmovl\t%%%s, %%eax\n", getRegisterStr(reg_map.at(op1)));
+                    }
+                    else {
+                        int offset_op1 = offset_map.at(op1);
+                        fprintf(fp, "\tmovl\t%d(%%ebp), %%eax\n", offset_op1);
+                    }
+                    fprintf(fp, "\tcltd\n");
+                    fprintf(fp, "\tidivl\t(%%esp)\n");
+                    fprintf(fp, "\taddl\t$4, %%esp\n");
+                    if (reg != EDX) {
+                        fprintf(fp, "\tpopl\t%%edx\n");
+                    }
+
+                    if (reg == EAX) {
+                        int offset_res = offset_map.at(instruction);
+                        fprintf(fp, "\tmovl\t%%eax, %d(%%ebp)\n", offset_res);
+                    }
+                    else {
+                        fprintf(fp, "\tmovl\t%%eax, %%%s\n", getRegisterStr(reg));
+                    }
+                    break;
+                }
                 case LLVMICmp: {
                     int reg;
                     if (reg_map.count(instruction) && reg_map.at(instruction) != SPILL) {
@@ -698,7 +1103,7 @@ void generateAssembly(LLVMModuleRef module) {
                         int const_val_op1 = LLVMConstIntGetSExtValue(op1);
                         fprintf(fp, "\tmovl\t$%d, %%%s\n", const_val_op1, getRegisterStr(reg));
                     }
-                    if (reg_map.count(op1) && reg_map.at(op1) != SPILL) {
+                    else if (reg_map.count(op1) && reg_map.at(op1) != SPILL) {
                         if (reg_map.at(op1) != reg) {
 
                             fprintf(fp, "\tmovl\t%%%s, %%%s\n", getRegisterStr(reg_map.at(op1)), getRegisterStr(reg));
@@ -732,5 +1137,4 @@ void generateAssembly(LLVMModuleRef module) {
         }
 
     }
-    fclose(fp);
 }
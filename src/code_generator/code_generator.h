@@ -6,6 +6,7 @@
 #ifndef CODE_GENERATOR_H
 #define CODE_GENERATOR_H 
 
+#include <stdio.h>
 #include <llvm-c/Core.h>
 #include <llvm-c/IRReader.h>
 #include <llvm-c/Types.h>
@@ -22,20 +23,68 @@ typedef enum {
     SPILL
 } reg_t;
 
+/*
+ * Params:
+ *      LLVMModuleRef module: a module that passes LLVM's verifier, e.g. one read from a file
+ *      const char *name: name of the module, used in the error message
+ *      FILE *diagnostics: stream the error message is printed to
+ *
+ * Returns:
+ *      TRUE, if the module is in the subset of LLVM IR the IR generator emits, which is all the
+ *      optimizer and the code generator handle: every function it defines returns i32 and takes
+ *      at most one i32; values are i32, except for the i1 of a comparison that the conditional
+ *      branch right after it consumes; the instructions are add, sub, mul, sdiv, icmp (eq, slt,
+ *      sle, sgt, sge), br, ret, phi, call (of print, read or a function the module defines) and
+ *      alloca, load and store of single i32 variables
+ *      FALSE, otherwise (the first construct outside the subset is printed to 'diagnostics')
+ */
+bool isSupportedModule(LLVMModuleRef module, const char *name, FILE *diagnostics);
+
 /*
  * Params: 
  *      LLVMModuleRef module: the module corresponding to the optimized LLVM
  *      IR code created by ir_generator.c and optimized from optimizer.c
- *      
+ *
+ *      const char *filename: path of the assembly file to write
  * 
  * Returns:
- *      void
+ *      TRUE, if the assembly file was written successfully
+ *      FALSE, if it could not be opened or written
  * 
  * Notes: 
  *      This function generates the assembly code corresponding to the
- *      generated LLVM IR. The assembly code is written to a file within the
- *      'src' directory called 'func.s'
+ *      generated LLVM IR. By default, the assembly code is written to a file
+ *      within the current directory called 'func.s'
+ */
+bool generateAssembly(LLVMModuleRef module, const char *filename = "func.s");
+
+/*
+ * Same as above, but writes the assembly code to the open stream 'fp', which is left open
+ */
+void generateAssembly(LLVMModuleRef module, FILE *fp);
+
+/*
+ * Params: 
+ *      const char *source_filename: name of the miniC program the assembly is generated from
+ *      FILE *fp: stream the directives are written to
+ * 
+ * Notes: 
+ *      Writes the directives that start every assembly file. generateAssembly() is this
+ *      followed by generateFunctionAssembly() for each function the module defines.
+ */
+void generateAssemblyHeader(const char *source_filename, FILE *fp);
+
+/*
+ * Params: 
+ *      LLVMValueRef function: an optimized function with a body
+ *      FILE *fp: stream the assembly code is written to
+ * 
+ * Notes: 
+ *      Writes the assembly code of a single function. The output only depends on the
+ *      function itself (block labels are prefixed with its name), so functions can be
+ *      generated separately, on different threads if they live in different contexts,
+ *      and concatenated in any order after generateAssemblyHeader().
  */
-void generateAssembly(LLVMModuleRef module);
+void generateFunctionAssembly(LLVMValueRef function, FILE *fp);
 
 #endif
\ No newline at end of file
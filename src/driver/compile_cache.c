@@ -0,0 +1,472 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * compile_cache.c - implements an on-disk, content-addressed cache of compiler outputs
+ */
+
+#include "compile_cache.h"
+#include "../support/file_io.h"
+#include "../ast/ast_file.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <link.h>
+#include <elf.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// bumped whenever the layout of an entry changes
+#define CACHE_FORMAT_VERSION 1
+#define CACHE_MAGIC "MNCC"
+#define ENTRY_SUFFIX ".entry"
+#define STATS_FILE "stats"
+
+// temporary files older than this were left behind by a writer that died before renaming them
+#define STALE_TEMP_SECONDS 3600
+
+/* header at the start of every entry, followed by the IR and then the assembly */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t ll_len;
+    uint64_t s_len;
+} entryHeader;
+
+/* an entry found while scanning the cache directory */
+typedef struct {
+    std::string path;
+    long size;
+    struct timespec last_used;
+} cacheEntry;
+
+struct compile_Cache {
+    std::string dir;
+    long max_bytes;
+    std::string key_prefix; // build ID and options, hashed in front of the source text
+    std::string function_key_prefix; // same, for the fingerprints of single functions
+    std::string ast_key_prefix; // build ID, hashed in front of the source text for the keys of ASTs
+    bool per_function;
+    std::mutex lock; // guards the two fields below
+    bool size_known;
+    long total_bytes;
+    std::atomic<long> hits;
+    std::atomic<long> misses;
+    std::atomic<long> evictions;
+    std::atomic<long> functions_reused;
+    std::atomic<long> functions_rebuilt;
+    std::atomic<long> asts_loaded;
+    std::atomic<long> asts_parsed;
+    std::atomic<long> temp_counter;
+};
+
+/***************************************** FUNCTION HEADERS *****************************************/
+std::string getBuildID();
+int readBuildIDNote(struct dl_phdr_info *info, size_t size, void *data);
+std::string getEntryPath(compileCache *cache, const std::string &key);
+void appendField(std::string &key, const std::string &field);
+std::string hashKey(const std::string &prefix, const char *source, size_t len);
+bool readEntry(compileCache *cache, const std::string &key, std::string &ll_text, std::string &s_text);
+long scanEntries(compileCache *cache, std::vector<cacheEntry> *entries);
+void evictEntries(compileCache *cache);
+bool updateStatsFile(compileCache *cache, long *hits, long *misses, long *evictions, bool add);
+void addEntryBytes(compileCache *cache, long bytes);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "compile_cache.h" for details ***********************/
+compileCache *createCompileCache(const char *dir, long max_bytes, const std::string &options, bool per_function) {
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: unable to create cache directory '%s': %s\n", dir, strerror(errno));
+        return NULL;
+    }
+
+    compileCache *cache = new compileCache();
+    cache->dir = dir;
+    cache->max_bytes = max_bytes;
+    std::string build_id = getBuildID();
+    appendField(cache->key_prefix, build_id);
+    appendField(cache->key_prefix, options);
+    cache->function_key_prefix = cache->key_prefix;
+    appendField(cache->function_key_prefix, "function");
+    appendField(cache->ast_key_prefix, build_id);
+    appendField(cache->ast_key_prefix, "ast");
+    cache->per_function = per_function;
+    cache->size_known = false;
+    cache->total_bytes = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    cache->functions_reused = 0;
+    cache->functions_rebuilt = 0;
+    cache->asts_loaded = 0;
+    cache->asts_parsed = 0;
+    cache->temp_counter = 0;
+    return cache;
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+std::string getCacheKey(compileCache *cache, const char *module_name, const char *source, size_t len) {
+    std::string prefix = cache->key_prefix;
+    appendField(prefix, module_name);
+    return hashKey(prefix, source, len);
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+bool lookupCache(compileCache *cache, const std::string &key, std::string &ll_text, std::string &s_text) {
+    if (!readEntry(cache, key, ll_text, s_text)) {
+        cache->misses++;
+        return false;
+    }
+    cache->hits++;
+    return true;
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+std::string getASTKey(compileCache *cache, const char *source, size_t len) {
+    return hashKey(cache->ast_key_prefix, source, len);
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+flatAST *lookupAST(compileCache *cache, const std::string &key, size_t len) {
+    std::string path = getEntryPath(cache, key);
+    flatAST *ast = mapASTFile(path.c_str(), len);
+    if (ast == NULL) {
+        cache->asts_parsed++;
+        return NULL;
+    }
+    cache->asts_loaded++;
+    utimensat(AT_FDCWD, path.c_str(), NULL, 0);
+    return ast;
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+void storeAST(compileCache *cache, const std::string &key, const flatAST *ast, size_t len) {
+    size_t bytes = writeASTFile(getEntryPath(cache, key).c_str(), ast, len);
+    if (bytes > 0) {
+        addEntryBytes(cache, bytes);
+    }
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+bool cachesFunctions(compileCache *cache) {
+    return cache->per_function;
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+std::string getFunctionKey(compileCache *cache, const std::string &fingerprint) {
+    return hashKey(cache->function_key_prefix, fingerprint.data(), fingerprint.size());
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+bool lookupFunction(compileCache *cache, const std::string &key, std::string &ll_text, std::string &s_text) {
+    if (!readEntry(cache, key, ll_text, s_text)) {
+        cache->functions_rebuilt++;
+        return false;
+    }
+    cache->functions_reused++;
+    return true;
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+void getFunctionCounts(compileCache *cache, long *reused, long *rebuilt) {
+    *reused = cache->functions_reused;
+    *rebuilt = cache->functions_rebuilt;
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+void storeCache(compileCache *cache, const std::string &key, const std::string &ll_text, const std::string &s_text) {
+    entryHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_FORMAT_VERSION;
+    header.ll_len = ll_text.size();
+    header.s_len = s_text.size();
+
+    std::string entry((const char *)&header, sizeof(header));
+    entry += ll_text;
+    entry += s_text;
+
+    // every writer uses its own temporary file, and rename() replaces the entry atomically
+    std::string path = getEntryPath(cache, key);
+    std::string temp_path = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(cache->temp_counter++);
+    FILE *fp = fopen(temp_path.c_str(), "w");
+    if (fp == NULL) {
+        return;
+    }
+    bool ok = fwrite(entry.data(), 1, entry.size(), fp) == entry.size();
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(temp_path.c_str(), path.c_str()) != 0) {
+        unlink(temp_path.c_str());
+        return;
+    }
+    addEntryBytes(cache, entry.size());
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+void printCacheStats(compileCache *cache, FILE *fp) {
+    std::vector<cacheEntry> entries;
+    long total_bytes;
+    {
+        std::lock_guard<std::mutex> guard(cache->lock);
+        total_bytes = scanEntries(cache, &entries);
+    }
+    long hits = 0;
+    long misses = 0;
+    long evictions = 0;
+    updateStatsFile(cache, &hits, &misses, &evictions, false);
+
+    long lookups = cache->hits + cache->misses;
+    long all_lookups = hits + misses + lookups;
+    fprintf(fp, "Compile cache '%s': %d entries, %.1f of %.1f MiB\n", cache->dir.c_str(), (int)entries.size(),
+        total_bytes / 1048576.0, cache->max_bytes / 1048576.0);
+    fprintf(fp, "  this run: %ld hits, %ld misses (%.1f%% hit rate), %ld evictions\n", cache->hits.load(),
+        cache->misses.load(), lookups > 0 ? 100.0 * cache->hits / lookups : 0.0, cache->evictions.load());
+    fprintf(fp, "  all runs: %ld hits, %ld misses (%.1f%% hit rate), %ld evictions\n", hits + cache->hits,
+        misses + cache->misses, all_lookups > 0 ? 100.0 * (hits + cache->hits) / all_lookups : 0.0,
+        evictions + cache->evictions);
+    if (cache->per_function) {
+        fprintf(fp, "  this run: %ld functions reused, %ld rebuilt\n", cache->functions_reused.load(),
+            cache->functions_rebuilt.load());
+    }
+    if (cache->asts_loaded + cache->asts_parsed > 0) {
+        fprintf(fp, "  this run: %ld ASTs loaded, %ld parsed\n", cache->asts_loaded.load(), cache->asts_parsed.load());
+    }
+}
+
+/*********************** see "compile_cache.h" for details ***********************/
+void freeCompileCache(compileCache *cache) {
+    long hits = cache->hits;
+    long misses = cache->misses;
+    long evictions = cache->evictions;
+    if (hits + misses + evictions > 0) {
+        updateStatsFile(cache, &hits, &misses, &evictions, true);
+    }
+    delete cache;
+}
+
+/* returns an identifier that changes whenever the compiler is rebuilt: the GNU build ID note
+   of the executable if the linker added one, otherwise the executable's size and modification
+   time */
+std::string getBuildID() {
+    std::string build_id;
+    dl_iterate_phdr(readBuildIDNote, &build_id);
+    if (!build_id.empty()) {
+        return build_id;
+    }
+
+    struct stat st;
+    if (stat("/proc/self/exe", &st) != 0) {
+        return "unknown";
+    }
+    return std::to_string(st.st_size) + ":" + std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+}
+
+// dl_iterate_phdr() callback; copies the build ID note of the executable (the first object
+// visited) into the std::string pointed to by 'data'
+int readBuildIDNote(struct dl_phdr_info *info, size_t size, void *data) {
+    std::string *build_id = (std::string *)data;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+        if (phdr->p_type != PT_NOTE) {
+            continue;
+        }
+        const char *pos = (const char *)(info->dlpi_addr + phdr->p_vaddr);
+        const char *end = pos + phdr->p_memsz;
+        while (pos + sizeof(ElfW(Nhdr)) <= end) {
+            const ElfW(Nhdr) *note = (const ElfW(Nhdr) *)pos;
+            const char *name = pos + sizeof(ElfW(Nhdr));
+            const char *desc = name + ((note->n_namesz + 3) & ~3u);
+            if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 && memcmp(name, "GNU", 4) == 0
+                    && desc + note->n_descsz <= end) {
+                build_id->assign(desc, note->n_descsz);
+                return 1;
+            }
+            pos = desc + ((note->n_descsz + 3) & ~3u);
+        }
+    }
+    return 1;
+}
+
+// returns the path of the entry with the given key (whether or not it exists)
+std::string getEntryPath(compileCache *cache, const std::string &key) {
+    return cache->dir + "/" + key + ENTRY_SUFFIX;
+}
+
+// appends 'field' to 'key' preceded by its length, so that no two lists of fields produce
+// the same key
+void appendField(std::string &key, const std::string &field) {
+    key += std::to_string(field.size());
+    key.push_back(':');
+    key += field;
+}
+
+// hashes 'prefix' followed by the source text with 128-bit FNV-1a; returns it as 32 hex digits
+std::string hashKey(const std::string &prefix, const char *source, size_t len) {
+    const unsigned __int128 prime = ((unsigned __int128)1 << 88) + 0x13b;
+    unsigned __int128 hash = ((unsigned __int128)0x6c62272e07bb0142ULL << 64) + 0x62b821756295c58dULL;
+    for (size_t i = 0; i < prefix.size(); i++) {
+        hash = (hash ^ (unsigned char)prefix[i]) * prime;
+    }
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)source[i]) * prime;
+    }
+
+    char hex[33];
+    snprintf(hex, sizeof(hex), "%016llx%016llx", (unsigned long long)(hash >> 64), (unsigned long long)hash);
+    return hex;
+}
+
+// reads the entry stored under 'key' into 'll_text' and 's_text' and marks it as used; returns
+// false if there is no such entry or it is not valid
+bool readEntry(compileCache *cache, const std::string &key, std::string &ll_text, std::string &s_text) {
+    std::string path = getEntryPath(cache, key);
+    std::string entry;
+    entryHeader header;
+    if (!readFile(path.c_str(), entry) || entry.size() < sizeof(header)) {
+        return false;
+    }
+
+    // an entry that does not match its header was written by another compiler version or is
+    // corrupt; it is treated as a miss and overwritten by the next store
+    memcpy(&header, entry.data(), sizeof(header));
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_FORMAT_VERSION
+            || entry.size() != sizeof(header) + header.ll_len + header.s_len) {
+        return false;
+    }
+
+    ll_text.assign(entry, sizeof(header), header.ll_len);
+    s_text.assign(entry, sizeof(header) + header.ll_len, header.s_len);
+
+    // the modification time doubles as the last-used time, since many filesystems do not
+    // keep access times up to date
+    utimensat(AT_FDCWD, path.c_str(), NULL, 0);
+    return true;
+}
+
+// returns the total size of the entries in the cache directory, and lists them in 'entries'
+// if it is not NULL; temporary files abandoned by dead writers are removed along the way
+long scanEntries(compileCache *cache, std::vector<cacheEntry> *entries) {
+    DIR *dir = opendir(cache->dir.c_str());
+    if (dir == NULL) {
+        return 0;
+    }
+
+    long total_bytes = 0;
+    time_t now = time(NULL);
+    struct dirent *dirent;
+    while ((dirent = readdir(dir)) != NULL) {
+        std::string name = dirent->d_name;
+        bool is_entry = name.size() > strlen(ENTRY_SUFFIX)
+            && name.compare(name.size() - strlen(ENTRY_SUFFIX), std::string::npos, ENTRY_SUFFIX) == 0;
+        bool is_temp = name.find(ENTRY_SUFFIX ".tmp.") != std::string::npos;
+        if (!is_entry && !is_temp) {
+            continue;
+        }
+
+        std::string path = cache->dir + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            continue; // removed by another process since readdir()
+        }
+        if (is_temp) {
+            if (now - st.st_mtime > STALE_TEMP_SECONDS) {
+                unlink(path.c_str());
+            }
+            continue;
+        }
+
+        total_bytes += st.st_size;
+        if (entries != NULL) {
+            cacheEntry entry;
+            entry.path = path;
+            entry.size = st.st_size;
+            entry.last_used = st.st_mtim;
+            entries->push_back(entry);
+        }
+    }
+    closedir(dir);
+    return total_bytes;
+}
+
+// removes the least recently used entries until the cache is at most 90% of its size bound,
+// leaving room for new entries before the next eviction; the caller holds cache->lock
+void evictEntries(compileCache *cache) {
+    std::vector<cacheEntry> entries;
+    long total_bytes = scanEntries(cache, &entries);
+    std::sort(entries.begin(), entries.end(), [](const cacheEntry &a, const cacheEntry &b) {
+        if (a.last_used.tv_sec != b.last_used.tv_sec) {
+            return a.last_used.tv_sec < b.last_used.tv_sec;
+        }
+        return a.last_used.tv_nsec < b.last_used.tv_nsec;
+    });
+
+    long target = cache->max_bytes - cache->max_bytes / 10;
+    for (int i = 0; i < entries.size() && total_bytes > target; i++) {
+        // another process may have evicted the same entry already
+        if (unlink(entries.at(i).path.c_str()) == 0) {
+            cache->evictions++;
+        }
+        total_bytes -= entries.at(i).size;
+    }
+    cache->total_bytes = total_bytes;
+}
+
+// reads the statistics of every process that used the cache from its stats file; if 'add' is
+// true, adds 'hits', 'misses' and 'evictions' to them and writes them back, otherwise returns
+// them through the same pointers. The file is locked so concurrent processes do not lose updates
+bool updateStatsFile(compileCache *cache, long *hits, long *misses, long *evictions, bool add) {
+    std::string path = cache->dir + "/" STATS_FILE;
+    int fd = open(path.c_str(), add ? O_RDWR | O_CREAT : O_RDONLY, 0666);
+    if (fd < 0) {
+        return false;
+    }
+    if (flock(fd, add ? LOCK_EX : LOCK_SH) != 0) {
+        close(fd);
+        return false;
+    }
+
+    char buf[256];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    buf[n > 0 ? n : 0] = '\0';
+    long old_hits = 0;
+    long old_misses = 0;
+    long old_evictions = 0;
+    sscanf(buf, "hits %ld misses %ld evictions %ld", &old_hits, &old_misses, &old_evictions);
+
+    bool ok = true;
+    if (add) {
+        int len = snprintf(buf, sizeof(buf), "hits %ld misses %ld evictions %ld\n",
+            old_hits + *hits, old_misses + *misses, old_evictions + *evictions);
+        ok = ftruncate(fd, 0) == 0 && pwrite(fd, buf, len, 0) == len;
+    }
+    else {
+        *hits = old_hits;
+        *misses = old_misses;
+        *evictions = old_evictions;
+    }
+    close(fd); // also releases the lock
+    return ok;
+}
+
+// accounts for a new entry of 'bytes' bytes, and evicts entries if the cache has grown too large
+void addEntryBytes(compileCache *cache, long bytes) {
+    std::lock_guard<std::mutex> guard(cache->lock);
+    if (!cache->size_known) {
+        cache->total_bytes = scanEntries(cache, NULL);
+        cache->size_known = true;
+    }
+    else {
+        cache->total_bytes += bytes;
+    }
+    if (cache->total_bytes > cache->max_bytes) {
+        evictEntries(cache);
+    }
+}
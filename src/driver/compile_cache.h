@@ -0,0 +1,165 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * compile_cache.h - defines an on-disk, content-addressed cache of compiler outputs, so that
+ * recompiling an unchanged program skips IR generation, optimization and code generation
+ */
+
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include "../ast/flat_ast.h"
+#include <stdio.h>
+#include <string>
+
+struct compile_Cache;
+typedef struct compile_Cache compileCache;
+
+/*
+ * Environment variable naming the cache directory; './compile' uses it when '--cache' is
+ * not given
+ */
+#define COMPILE_CACHE_ENV "MINIC_CACHE_DIR"
+
+// default bound on the total size of the cache entries
+#define COMPILE_CACHE_DEFAULT_SIZE (256L * 1024 * 1024)
+
+/*
+ * Params:
+ *      const char *dir: directory holding the cache; it is created if it does not exist
+ *      long max_bytes: once the entries take up more than this many bytes, the least recently
+ *      used ones are evicted
+ *      const std::string &options: every option that changes the compiler's output; programs
+ *      compiled with different options never share an entry
+ *      bool per_function: if TRUE, the cache works incrementally: instead of whole programs,
+ *      it holds the outputs of each function, so that recompiling a program in which only a
+ *      few functions changed rebuilds just those (see cachesFunctions())
+ *
+ * Returns:
+ *      a pointer to a newly allocated cache, or NULL if 'dir' could not be created
+ *
+ * Notes:
+ *      Entries are keyed by a 128-bit hash of the source text, the build ID of the running
+ *      compiler and 'options' (and, for whole programs, the program's name), so rebuilding the
+ *      compiler invalidates every entry. A cache may be shared by several threads and by
+ *      several processes using the same directory.
+ */
+compileCache *createCompileCache(const char *dir, long max_bytes, const std::string &options,
+                                    bool per_function = false);
+
+/*
+ * Params:
+ *      compileCache *cache: the cache the key is used with
+ *      const char *module_name: name given to the program, which its outputs mention (in the
+ *      '.file' directive, the module ID and the source filename)
+ *      const char *source, size_t len: text of the program being compiled
+ *
+ * Returns:
+ *      the key of the entry holding the outputs of 'source' compiled as 'module_name'; the same
+ *      source under another name has an entry of its own
+ */
+std::string getCacheKey(compileCache *cache, const char *module_name, const char *source, size_t len);
+
+/*
+ * Params:
+ *      compileCache *cache: the cache to look in
+ *      const std::string &key: the key getCacheKey() returned for the program
+ *      std::string &ll_text: receives the cached LLVM IR on a hit
+ *      std::string &s_text: receives the cached assembly on a hit
+ *
+ * Returns:
+ *      TRUE, if an entry was found (a hit); its last-used time is updated
+ *      FALSE, otherwise (a miss)
+ */
+bool lookupCache(compileCache *cache, const std::string &key, std::string &ll_text, std::string &s_text);
+
+/*
+ * Params:
+ *      compileCache *cache: the cache to store into
+ *      const std::string &key: the key getCacheKey() returned for the program
+ *      const std::string &ll_text, const std::string &s_text: the outputs of the compile
+ *
+ * Notes:
+ *      The entry is written to a temporary file and renamed into place, so concurrent writers
+ *      and readers only ever see complete entries. Failures are silently ignored; the cache
+ *      is only an optimization.
+ */
+void storeCache(compileCache *cache, const std::string &key, const std::string &ll_text, const std::string &s_text);
+
+/*
+ * Params:
+ *      compileCache *cache: the cache the key is used with
+ *      const char *source, size_t len: text of the program, before it is parsed
+ *
+ * Returns:
+ *      the key of the entry holding the AST of 'source'. It depends on the source text and the
+ *      build ID of the compiler but not on the options, so the AST is shared by compiles with
+ *      different options, and a rebuilt compiler, whose AST layout may have changed, never
+ *      decodes an entry of another build (an entry in an older format is also rejected when it
+ *      is loaded, see "ast_file.h")
+ */
+std::string getASTKey(compileCache *cache, const char *source, size_t len);
+
+/*
+ * Params:
+ *      compileCache *cache: the cache to look in
+ *      const std::string &key: the key getASTKey() returned for the program
+ *      size_t len: length of the program's source text
+ *
+ * Returns:
+ *      the program's AST, mapped from its entry, or NULL if there is no valid entry; the
+ *      caller frees it with freeFlatAST()
+ */
+flatAST *lookupAST(compileCache *cache, const std::string &key, size_t len);
+
+/*
+ * Stores 'ast', parsed from a source text of length 'len', under 'key' (from getASTKey()).
+ * Like storeCache(), the entry appears atomically and failures are ignored
+ */
+void storeAST(compileCache *cache, const std::string &key, const flatAST *ast, size_t len);
+
+/*
+ * Returns TRUE if 'cache' was created to hold the outputs of single functions rather than of
+ * whole programs
+ */
+bool cachesFunctions(compileCache *cache);
+
+/*
+ * Params:
+ *      compileCache *cache: the cache the key is used with
+ *      const std::string &fingerprint: an encoding of everything the function's outputs
+ *      depend on (see serializeNode() and serializeFlatNode())
+ *
+ * Returns:
+ *      the key of the entry holding the outputs of the function; function keys never
+ *      collide with the keys of whole programs
+ */
+std::string getFunctionKey(compileCache *cache, const std::string &fingerprint);
+
+/*
+ * Same as lookupCache(), but for the entry of a single function stored with storeCache() under
+ * a key from getFunctionKey(). Hits count as reused functions and misses as rebuilt ones,
+ * rather than as hits and misses of the cache
+ */
+bool lookupFunction(compileCache *cache, const std::string &key, std::string &ll_text, std::string &s_text);
+
+/*
+ * Sets 'reused' and 'rebuilt' to the number of lookupFunction() hits and misses of this
+ * process
+ */
+void getFunctionCounts(compileCache *cache, long *reused, long *rebuilt);
+
+/*
+ * Writes the hits, misses and evictions of this process, the totals over every process that
+ * used the cache directory, and the cache's current size to 'fp'; for a per-function cache,
+ * also the number of functions this process reused and rebuilt, and if any ASTs were looked
+ * up, how many were loaded and how many had to be parsed
+ */
+void printCacheStats(compileCache *cache, FILE *fp);
+
+/*
+ * Adds this process's statistics to the totals kept in the cache directory and releases all
+ * memory associated with 'cache'
+ */
+void freeCompileCache(compileCache *cache);
+
+#endif
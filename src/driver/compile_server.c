@@ -0,0 +1,277 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * compile_server.c - implements a persistent compile server that listens on a Unix domain
+ * socket, and the client used to send it compile requests
+ */
+
+#include "compile_server.h"
+#include "thread_pool.h"
+#include "../support/time_report.h"
+#include "../support/file_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// fields larger than this are treated as a corrupt message rather than allocated
+#define MAX_FIELD_LEN (512u * 1024u * 1024u)
+
+static volatile sig_atomic_t stop_requested = 0;
+
+/***************************************** FUNCTION HEADERS *****************************************/
+void handleConnection(int fd, compileCache *cache);
+void handleStopSignal(int sig);
+bool fillSocketAddress(const char *socket_path, struct sockaddr_un *addr);
+bool writeAll(int fd, const void *buf, size_t len);
+bool readAll(int fd, void *buf, size_t len);
+bool writeU32(int fd, uint32_t value);
+bool readU32(int fd, uint32_t *value);
+bool writeField(int fd, const std::string &field);
+bool readField(int fd, std::string &field);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "compile_server.h" for details ***********************/
+int runCompileServer(const char *socket_path, int num_threads, compileCache *cache) {
+    struct sockaddr_un addr;
+    if (!fillSocketAddress(socket_path, &addr)) {
+        return 1;
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "Error: unable to listen on '%s': %s\n", socket_path, strerror(errno));
+        close(listen_fd);
+        return 1;
+    }
+
+    // a client that disconnects early must not kill the server, and the stop signals must
+    // interrupt accept() rather than restart it
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handleStopSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    // workers inherit the blocked signals, so the stop signals are always delivered to this thread
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+    threadPool *pool = createThreadPool(num_threads);
+    pthread_sigmask(SIG_UNBLOCK, &stop_signals, NULL);
+
+    fprintf(stderr, "Compile server listening on '%s' with %d thread(s)\n", socket_path, getPoolSize(pool));
+
+    while (!stop_requested) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno != EINTR) {
+                perror("accept");
+            }
+            continue;
+        }
+        submitTask(pool, [fd, cache] { handleConnection(fd, cache); });
+    }
+
+    freeThreadPool(pool);
+    close(listen_fd);
+    unlink(socket_path);
+    return 0;
+}
+
+/*********************** see "compile_server.h" for details ***********************/
+bool compileOnServer(const char *socket_path, const char *filename, std::vector<std::string> &options,
+                        const char *ll_path, const char *s_path, compile_status *status) {
+    struct sockaddr_un addr;
+    std::string source;
+    if (!fillSocketAddress(socket_path, &addr) || !readFile(filename, source)) {
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    std::string packed_options;
+    for (int i = 0; i < options.size(); i++) {
+        packed_options += options.at(i);
+        packed_options.push_back('\0');
+    }
+
+    uint32_t magic;
+    uint32_t res_status;
+    std::string ll;
+    std::string s;
+    std::string diagnostics;
+    bool ok = writeU32(fd, COMPILE_SERVER_MAGIC) && writeField(fd, filename) && writeField(fd, packed_options)
+        && writeField(fd, source) && readU32(fd, &magic) && magic == COMPILE_SERVER_MAGIC && readU32(fd, &res_status)
+        && readField(fd, ll) && readField(fd, s) && readField(fd, diagnostics);
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+
+    fputs(diagnostics.c_str(), stderr);
+    *status = (compile_status)res_status;
+    if (*status == COMPILE_OK && ((ll_path != NULL && !writeFile(ll_path, ll)) || (s_path != NULL && !writeFile(s_path, s)))) {
+        *status = COMPILE_OUTPUT_ERROR;
+    }
+    return true;
+}
+
+/* reads one request from 'fd', compiles it and sends back the response */
+void handleConnection(int fd, compileCache *cache) {
+    uint32_t magic;
+    std::string filename;
+    std::string options;
+    std::string source;
+    if (!(readU32(fd, &magic) && magic == COMPILE_SERVER_MAGIC && readField(fd, filename)
+            && readField(fd, options) && readField(fd, source))) {
+        close(fd);
+        return;
+    }
+
+    // options are NUL-terminated strings packed back to back
+    bool time_report = false;
+    int emit = EMIT_ASM | EMIT_LL;
+    for (size_t pos = 0; pos < options.size(); pos += strlen(options.c_str() + pos) + 1) {
+        const char *option = options.c_str() + pos;
+        if (strcmp(option, "-ftime-report") == 0) {
+            time_report = true;
+        }
+        else if (strncmp(option, "--emit=", strlen("--emit=")) == 0) {
+            emit = parseEmitKinds(option + strlen("--emit="));
+        }
+    }
+    if (emit < 0) {
+        close(fd);
+        return;
+    }
+    timeReport *report = time_report ? createTimeReport() : NULL;
+
+    std::string ll;
+    std::string s;
+
+    // the messages of this compile are collected for its client rather than printed to the
+    // server's stderr, where they would mix with those of the other requests
+    char *messages = NULL;
+    size_t messages_len = 0;
+    FILE *diagnostics_fp = open_memstream(&messages, &messages_len);
+
+    // the request already owns the source, so it is scanned in place
+    size_t len = source.size();
+    source.append(2, '\0');
+    compile_status status = compileBuffer(&source[0], len, filename.c_str(),
+        (emit & EMIT_LL) ? &ll : NULL, NULL, (emit & EMIT_ASM) ? &s : NULL, report, cache, 1, diagnostics_fp);
+
+    if (report != NULL) {
+        printTimeReport(report, diagnostics_fp);
+        freeTimeReport(report);
+    }
+    fclose(diagnostics_fp);
+    std::string diagnostics(messages, messages_len);
+    free(messages);
+
+    writeU32(fd, COMPILE_SERVER_MAGIC) && writeU32(fd, status) && writeField(fd, ll) && writeField(fd, s)
+        && writeField(fd, diagnostics);
+    close(fd);
+}
+
+// asks the accept loop to stop; requests already accepted are still completed
+void handleStopSignal(int sig) {
+    stop_requested = 1;
+}
+
+// fills in the address of the socket at 'socket_path'; fails if the path is too long
+bool fillSocketAddress(const char *socket_path, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Error: socket path '%s' is too long\n", socket_path);
+        return false;
+    }
+    strcpy(addr->sun_path, socket_path);
+    return true;
+}
+
+// writes exactly 'len' bytes, retrying after partial writes and interruptions
+bool writeAll(int fd, const void *buf, size_t len) {
+    const char *pos = (const char *)buf;
+    while (len > 0) {
+        ssize_t n = write(fd, pos, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        pos += n;
+        len -= n;
+    }
+    return true;
+}
+
+// reads exactly 'len' bytes; fails if the connection closes first
+bool readAll(int fd, void *buf, size_t len) {
+    char *pos = (char *)buf;
+    while (len > 0) {
+        ssize_t n = read(fd, pos, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        pos += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool writeU32(int fd, uint32_t value) {
+    uint32_t net_value = htonl(value);
+    return writeAll(fd, &net_value, sizeof(net_value));
+}
+
+bool readU32(int fd, uint32_t *value) {
+    uint32_t net_value;
+    if (!readAll(fd, &net_value, sizeof(net_value))) {
+        return false;
+    }
+    *value = ntohl(net_value);
+    return true;
+}
+
+bool writeField(int fd, const std::string &field) {
+    return writeU32(fd, field.size()) && writeAll(fd, field.data(), field.size());
+}
+
+bool readField(int fd, std::string &field) {
+    uint32_t len;
+    if (!readU32(fd, &len) || len > MAX_FIELD_LEN) {
+        return false;
+    }
+    field.resize(len);
+    return readAll(fd, &field[0], len);
+}
@@ -0,0 +1,73 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * compile_server.h - defines a persistent compile server that listens on a Unix domain socket,
+ * and the client used to send it compile requests
+ */
+
+#ifndef COMPILE_SERVER_H
+#define COMPILE_SERVER_H
+
+#include "driver.h"
+#include <string>
+#include <vector>
+
+/*
+ * PROTOCOL:
+ *      Every message starts with the 32-bit magic number COMPILE_SERVER_MAGIC followed by a
+ *      sequence of fields. All integers are 32 bits wide and sent in network byte order; a
+ *      field is its length followed by that many bytes.
+ *
+ *      request:  magic, field 'filename', field 'options', field 'source'
+ *      response: magic, status (a compile_status), field 'll', field 's', field 'diagnostics'
+ *
+ *      'options' holds the client's command-line options, each terminated by a NUL byte. The
+ *      server acts on '--emit=kinds', which selects the outputs it produces ('ll' and 's' are
+ *      empty for the others), and on '-ftime-report'. 'diagnostics' holds what the compile would
+ *      have printed to stderr had the client run it itself: the errors found in the program,
+ *      followed by the time report if one was asked for. Each connection carries exactly one
+ *      request and one response.
+ */
+#define COMPILE_SERVER_MAGIC 0x4d4e4331 // "MNC1"
+
+/*
+ * Environment variable naming the socket of a running server. When it is set, './compile'
+ * sends single-file compiles to that server instead of compiling them itself.
+ */
+#define COMPILE_SERVER_ENV "MINIC_COMPILE_SERVER"
+
+/*
+ * Params:
+ *      const char *socket_path: path of the Unix domain socket to listen on; a stale socket
+ *      left behind at that path is replaced
+ *      int num_threads: number of requests handled concurrently; less than 1 uses one per
+ *      hardware thread
+ *      compileCache *cache: if not NULL, every request is looked up in and stored into it
+ *
+ * Returns:
+ *      0 once the server has been stopped with SIGINT or SIGTERM, non-zero if it could not
+ *      start listening
+ *
+ * Notes:
+ *      Requests are compiled with compileBuffer(), which releases every module, context and
+ *      AST it creates, so the server's memory use does not grow with the number of requests.
+ */
+int runCompileServer(const char *socket_path, int num_threads, compileCache *cache = NULL);
+
+/*
+ * Params:
+ *      const char *socket_path: path of the server's socket
+ *      const char *filename: path of the miniC program to compile
+ *      std::vector<std::string> &options: command-line options forwarded to the server
+ *      const char *ll_path: path the optimized LLVM IR is written to, "-" for stdout, or NULL
+ *      const char *s_path: path the generated assembly is written to, "-" for stdout, or NULL
+ *      compile_status *status: receives the result of the compile
+ *
+ * Returns:
+ *      TRUE, if the server handled the request (in which case 'status' is set)
+ *      FALSE, if the file could not be read or the server could not be reached, so the caller
+ *      should compile the file itself
+ */
+bool compileOnServer(const char *socket_path, const char *filename, std::vector<std::string> &options,
+                        const char *ll_path, const char *s_path, compile_status *status);
+
+#endif
@@ -0,0 +1,35 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * compiler_session.c - implements the LLVM state of a single compile
+ */
+
+#include "compiler_session.h"
+#include <stddef.h>
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "compiler_session.h" for details ***********************/
+compilerSession *createCompilerSession() {
+    compilerSession *session = new compilerSession();
+    session->context = LLVMContextCreate();
+    return session;
+}
+
+/*********************** see "compiler_session.h" for details ***********************/
+LLVMModuleRef ownModule(compilerSession *session, LLVMModuleRef module) {
+    if (module != NULL) {
+        session->modules.push_back(module);
+    }
+    return module;
+}
+
+/*********************** see "compiler_session.h" for details ***********************/
+void freeCompilerSession(compilerSession *session) {
+    // a context must outlive the modules created in it
+    for (int i = 0; i < session->modules.size(); i++) {
+        LLVMDisposeModule(session->modules.at(i));
+    }
+    LLVMContextDispose(session->context);
+    delete session;
+}
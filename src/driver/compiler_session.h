@@ -0,0 +1,48 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * compiler_session.h - defines the LLVM state of a single compile: the context that every module,
+ * type and constant of the compile is created in, and the modules it owns
+ */
+
+#ifndef COMPILER_SESSION_H
+#define COMPILER_SESSION_H
+
+#include <vector>
+#include <llvm-c/Core.h>
+
+/*
+ * A compile's LLVM state. IR generation, optimization and code generation only ever create
+ * types and constants in 'context' (through the *InContext functions, or from the types of the
+ * values they are given), never in LLVM's global context, so compiles in different sessions share
+ * nothing and may run on different threads at once.
+ */
+typedef struct {
+    LLVMContextRef context; // the context every module of the compile is created in
+    std::vector<LLVMModuleRef> modules; // modules handed over with ownModule(), in order
+} compilerSession;
+
+/*
+ * Returns:
+ *      a pointer to a newly allocated session with a context of its own and no modules, to be
+ *      freed with freeCompilerSession() once the compile ends
+ */
+compilerSession *createCompilerSession();
+
+/*
+ * Params:
+ *      compilerSession *session: the session whose context 'module' was created in
+ *      LLVMModuleRef module: a module the caller owns, or NULL
+ *
+ * Returns:
+ *      'module', which the session now owns: it is disposed by freeCompilerSession() and must
+ *      not be disposed by the caller
+ */
+LLVMModuleRef ownModule(compilerSession *session, LLVMModuleRef module);
+
+/*
+ * Disposes every module 'session' owns, then its context, releasing all the memory LLVM used
+ * for the compile, and frees 'session'
+ */
+void freeCompilerSession(compilerSession *session);
+
+#endif
@@ -0,0 +1,636 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * driver.c - implements functions that run the full compile pipeline on one or many
+ * miniC programs
+ */
+
+#include "driver.h"
+#include "compiler_session.h"
+#include "thread_pool.h"
+#include "../support/file_io.h"
+#include "../support/source_buffer.h"
+#include "../parser/parser.h"
+#include "../parser/semantic_analysis.h"
+#include "../ir_generator/ir_generator.h"
+#include "../optimizer/optimizer.h"
+#include "../code_generator/code_generator.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <unordered_set>
+#include <llvm-c/Analysis.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Core.h>
+#include <llvm-c/IRReader.h>
+
+static std::atomic<pipelineKind> selected_pipeline(PIPELINE_AST);
+
+/***************************************** FUNCTION HEADERS *****************************************/
+flatAST *parseSource(char *text, size_t len, timeReport *report, FILE *diagnostics);
+flatAST *loadOrParseSource(char *text, size_t len, compileCache *cache, timeReport *report, FILE *diagnostics);
+void buildModule(const flatAST *ast, const char *module_name, std::string *ll_text, std::string *bc_text,
+                    std::string *s_text, timeReport *report);
+compile_status buildModuleSinglePass(char *text, size_t len, const char *module_name, std::string *ll_text,
+                                        std::string *bc_text, std::string *s_text, timeReport *report,
+                                        FILE *diagnostics);
+compile_status buildModuleFromIR(const char *filename, std::string *ll_text, std::string *bc_text, std::string *s_text,
+                                    timeReport *report, FILE *diagnostics);
+void emitModule(LLVMModuleRef module, std::string *ll_text, std::string *bc_text, std::string *s_text,
+                    timeReport *report);
+compile_status buildFunctions(const flatAST *ast, const char *module_name, std::string *ll_text,
+                                std::string *bc_text, std::string *s_text, int num_threads, compileCache *cache,
+                                timeReport *report, FILE *diagnostics);
+LLVMModuleRef readIR(compilerSession *session, LLVMMemoryBufferRef buffer, const char *name, FILE *diagnostics);
+void printIR(LLVMModuleRef module, std::string *ll_text);
+void writeBitcode(LLVMModuleRef module, std::string *bc_text);
+compile_status convertIRToBitcode(const std::string &ll_text, const char *module_name, std::string *bc_text,
+                                    timeReport *report, FILE *diagnostics);
+void captureOutput(std::string *text, const std::function<void(FILE *)> &generate);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "driver.h" for details ***********************/
+compile_status compileFile(const char *filename, const char *ll_path, const char *bc_path, const char *s_path,
+                            timeReport *report, compileCache *cache, int num_threads, FILE *diagnostics) {
+    std::string ll_text;
+    std::string bc_text;
+    std::string s_text;
+    compile_status status;
+    if (isIRFile(filename)) {
+        status = buildModuleFromIR(filename, ll_path != NULL ? &ll_text : NULL, bc_path != NULL ? &bc_text : NULL,
+            s_path != NULL ? &s_text : NULL, report, diagnostics);
+    }
+    else {
+        sourceBuffer *source = mapSourceFile(filename);
+        if (source == NULL) {
+            return COMPILE_PARSE_ERROR;
+        }
+        status = compileBuffer(source->text, source->len, filename, ll_path != NULL ? &ll_text : NULL,
+            bc_path != NULL ? &bc_text : NULL, s_path != NULL ? &s_text : NULL, report, cache, num_threads, diagnostics);
+        freeSourceBuffer(source);
+    }
+    if (status == COMPILE_OK && ((ll_path != NULL && !writeFile(ll_path, ll_text))
+            || (bc_path != NULL && !writeFile(bc_path, bc_text))
+            || (s_path != NULL && !writeFile(s_path, s_text)))) {
+        status = COMPILE_OUTPUT_ERROR;
+    }
+    return status;
+}
+
+/*********************** see "driver.h" for details ***********************/
+compile_status compileSource(const char *source, size_t len, const char *module_name, std::string *ll_text,
+                                std::string *bc_text, std::string *s_text, timeReport *report, compileCache *cache,
+                                int num_threads, FILE *diagnostics) {
+    sourceBuffer *buffer = copySourceBuffer(source, len);
+    compile_status status = compileBuffer(buffer->text, buffer->len, module_name, ll_text, bc_text, s_text, report,
+                                            cache, num_threads, diagnostics);
+    freeSourceBuffer(buffer);
+    return status;
+}
+
+/*********************** see "driver.h" for details ***********************/
+compile_status compileBuffer(char *buffer, size_t len, const char *module_name, std::string *ll_text,
+                                std::string *bc_text, std::string *s_text, timeReport *report, compileCache *cache,
+                                int num_threads, FILE *diagnostics) {
+    timeStamp compile_start = startTiming();
+
+    // a cache entry always holds both the textual IR and the assembly, so both are produced when
+    // caching whole programs, and the bitcode of a cache hit is converted from its IR; a
+    // per-function cache is consulted for each function once the program is parsed
+    bool per_function = cache != NULL && cachesFunctions(cache);
+    std::string cached_ll;
+    std::string cached_s;
+    std::string cache_key;
+    if (cache != NULL && !per_function) {
+        ll_text = ll_text != NULL ? ll_text : &cached_ll;
+        s_text = s_text != NULL ? s_text : &cached_s;
+
+        // the key is taken before parsing, since the scanner writes into 'buffer'
+        timeStamp start = startTiming();
+        cache_key = getCacheKey(cache, module_name, buffer, len);
+        bool hit = lookupCache(cache, cache_key, *ll_text, *s_text);
+        recordPhase(report, "cacheLookup", start, "hits", hit);
+        if (hit) {
+            compile_status status = COMPILE_OK;
+            if (bc_text != NULL) {
+                status = convertIRToBitcode(*ll_text, module_name, bc_text, report, diagnostics);
+            }
+            recordPhase(report, "compileBuffer", compile_start, NULL, 0, module_name);
+            return status;
+        }
+    }
+
+    if (getPipeline() == PIPELINE_SINGLE_PASS && !per_function) {
+        compile_status status = buildModuleSinglePass(buffer, len, module_name, ll_text, bc_text, s_text, report,
+                                                        diagnostics);
+        if (status != COMPILE_OK) {
+            return status;
+        }
+    }
+    else {
+        flatAST *ast = loadOrParseSource(buffer, len, cache, report, diagnostics);
+        if (ast == NULL) {
+            return COMPILE_PARSE_ERROR;
+        }
+
+        timeStamp start = startTiming();
+        bool is_valid = isValidAST(ast, diagnostics);
+        recordPhase(report, "isValidAST", start);
+        if (!is_valid) {
+            freeFlatAST(ast);
+            return COMPILE_SEMANTIC_ERROR;
+        }
+
+        // programs with a single function gain nothing from splitting them up, unless their
+        // function may be reused from the cache
+        compile_status status = COMPILE_OK;
+        if (!per_function && (num_threads == 1 || countChildren(ast, 0) == 3)) {
+            buildModule(ast, module_name, ll_text, bc_text, s_text, report);
+        }
+        else {
+            status = buildFunctions(ast, module_name, ll_text, bc_text, s_text, num_threads,
+                per_function ? cache : NULL, report, diagnostics);
+        }
+        freeFlatAST(ast);
+        if (status != COMPILE_OK) {
+            return status;
+        }
+    }
+
+    // only successful compiles are cached, so errors are always reported again
+    if (cache != NULL && !per_function) {
+        timeStamp start = startTiming();
+        storeCache(cache, cache_key, *ll_text, *s_text);
+        recordPhase(report, "cacheStore", start);
+    }
+
+    recordPhase(report, "compileBuffer", compile_start, NULL, 0, module_name);
+    return COMPILE_OK;
+}
+
+/*********************** see "driver.h" for details ***********************/
+void selectPipeline(pipelineKind kind) {
+    selected_pipeline.store(kind, std::memory_order_relaxed);
+}
+
+/*********************** see "driver.h" for details ***********************/
+pipelineKind getPipeline() {
+    return selected_pipeline.load(std::memory_order_relaxed);
+}
+
+/*********************** see "driver.h" for details ***********************/
+int compileBatch(std::vector<std::string> &inputs, const char *out_dir, int emit, int num_threads,
+                    timeReport *report, compileCache *cache) {
+    std::vector<std::string> ll_paths;
+    std::vector<std::string> bc_paths;
+    std::vector<std::string> s_paths;
+    std::unordered_set<std::string> seen;
+
+    // two inputs that map to the same output would silently overwrite each other
+    for (int i = 0; i < inputs.size(); i++) {
+        ll_paths.push_back(getOutputPath(inputs.at(i), out_dir, ".ll"));
+        bc_paths.push_back(getOutputPath(inputs.at(i), out_dir, ".bc"));
+        s_paths.push_back(getOutputPath(inputs.at(i), out_dir, ".s"));
+        if (seen.count(s_paths.at(i))) {
+            fprintf(stderr, "Error: more than one input writes '%s'\n", s_paths.at(i).c_str());
+            return inputs.size();
+        }
+        seen.insert(s_paths.at(i));
+    }
+
+    // nor may an IR input be replaced by its own output before the others have read it
+    for (int i = 0; i < inputs.size(); i++) {
+        if (((emit & EMIT_LL) && inputs.at(i) == ll_paths.at(i)) || ((emit & EMIT_BC) && inputs.at(i) == bc_paths.at(i))) {
+            fprintf(stderr, "Error: '%s' would be overwritten by its own output\n", inputs.at(i).c_str());
+            return inputs.size();
+        }
+    }
+
+    std::atomic<int> num_failed(0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    threadPool *pool = createThreadPool(num_threads);
+    for (int i = 0; i < inputs.size(); i++) {
+        submitTask(pool, [&, i] {
+            const char *ll_path = (emit & EMIT_LL) ? ll_paths.at(i).c_str() : NULL;
+            const char *bc_path = (emit & EMIT_BC) ? bc_paths.at(i).c_str() : NULL;
+            const char *s_path = (emit & EMIT_ASM) ? s_paths.at(i).c_str() : NULL;
+            compile_status status = compileFile(inputs.at(i).c_str(), ll_path, bc_path, s_path, report, cache);
+            if (status != COMPILE_OK) {
+                fprintf(stderr, "Error: failed to compile '%s'\n", inputs.at(i).c_str());
+                num_failed++;
+            }
+        });
+    }
+    waitForTasks(pool);
+    int pool_size = getPoolSize(pool);
+    freeThreadPool(pool);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double seconds = elapsed.count();
+    fprintf(stderr, "Compiled %d file(s), %d failed, in %.3f s (%.1f files/sec) using %d thread(s)\n",
+        (int)inputs.size(), num_failed.load(), seconds, seconds > 0 ? inputs.size() / seconds : 0.0, pool_size);
+
+    return num_failed.load();
+}
+
+/*********************** see "driver.h" for details ***********************/
+bool readManifest(const char *manifest, std::vector<std::string> &inputs) {
+    FILE *fp = fopen(manifest, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: unable to open manifest '%s'\n", manifest);
+        return false;
+    }
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t len;
+    while ((len = getline(&line, &capacity, fp)) != -1) {
+        // strip trailing whitespace, including the newline
+        while (len > 0 && strchr(" \t\r\n", line[len - 1]) != NULL) {
+            line[--len] = '\0';
+        }
+        if (len == 0 || line[0] == '#') {
+            continue;
+        }
+        inputs.push_back(line);
+    }
+    free(line);
+    fclose(fp);
+    return true;
+}
+
+/*********************** see "driver.h" for details ***********************/
+int parseEmitKinds(const char *list) {
+    int emit = 0;
+    std::string kinds = list;
+    size_t pos = 0;
+    while (pos <= kinds.size()) {
+        size_t comma = kinds.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = kinds.size();
+        }
+        std::string kind = kinds.substr(pos, comma - pos);
+        if (kind == "asm") {
+            emit |= EMIT_ASM;
+        }
+        else if (kind == "ll") {
+            emit |= EMIT_LL;
+        }
+        else if (kind == "bc") {
+            emit |= EMIT_BC;
+        }
+        else if (kind != "none") {
+            fprintf(stderr, "Error: unknown output kind '%s' (expected asm, ll, bc or none)\n", kind.c_str());
+            return -1;
+        }
+        pos = comma + 1;
+    }
+    return emit;
+}
+
+/*********************** see "driver.h" for details ***********************/
+std::string getOutputPath(const std::string &input, const char *out_dir, const char *extension) {
+    std::string stem = input;
+    size_t slash = stem.find_last_of('/');
+    size_t dot = stem.find_last_of('.');
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+        stem = stem.substr(0, dot);
+    }
+    if (out_dir != NULL) {
+        if (slash != std::string::npos) {
+            stem = stem.substr(slash + 1);
+        }
+        stem = std::string(out_dir) + "/" + stem;
+    }
+    return stem + extension;
+}
+
+/*********************** see "driver.h" for details ***********************/
+bool isIRFile(const char *filename) {
+    size_t len = strlen(filename);
+    return len > 3 && (strcmp(filename + len - 3, ".ll") == 0 || strcmp(filename + len - 3, ".bc") == 0);
+}
+
+/* parses the program in 'text' (followed by two NUL bytes); returns its AST, or NULL if it
+   contains a syntax error, which is printed to 'diagnostics' */
+flatAST *parseSource(char *text, size_t len, timeReport *report, FILE *diagnostics) {
+    timeStamp start = startTiming();
+    flatAST *ast = parse(text, len, diagnostics);
+    recordPhase(report, "parse", start, "nodes", ast != NULL ? ast->kinds.size() : 0);
+    return ast;
+}
+
+/* same as parseSource(), but if 'cache' is not NULL, the AST is mapped from the cache when the
+   same source was parsed before, and stored in it otherwise */
+flatAST *loadOrParseSource(char *text, size_t len, compileCache *cache, timeReport *report, FILE *diagnostics) {
+    if (cache == NULL) {
+        return parseSource(text, len, report, diagnostics);
+    }
+
+    // as for the outputs, the key is taken before the scanner writes into 'text'
+    timeStamp start = startTiming();
+    std::string key = getASTKey(cache, text, len);
+    flatAST *ast = lookupAST(cache, key, len);
+    recordPhase(report, "loadAST", start, "nodes", ast != NULL ? ast->kinds.size() : 0);
+    if (ast != NULL) {
+        return ast;
+    }
+
+    ast = parseSource(text, len, report, diagnostics);
+    if (ast != NULL) {
+        start = startTiming();
+        storeAST(cache, key, ast, len);
+        recordPhase(report, "storeAST", start);
+    }
+    return ast;
+}
+
+/* generates and optimizes the IR of a valid program as a single module, then prints it to
+   'll_text', writes its bitcode to 'bc_text' and generates the assembly into 's_text' (any of
+   which may be NULL) */
+void buildModule(const flatAST *ast, const char *module_name, std::string *ll_text, std::string *bc_text,
+                    std::string *s_text, timeReport *report) {
+    compilerSession *session = createCompilerSession();
+
+    timeStamp start = startTiming();
+    LLVMModuleRef module = ownModule(session, generateIR(ast, module_name, session->context));
+    recordPhase(report, "generateIR", start);
+
+    emitModule(module, ll_text, bc_text, s_text, report);
+    freeCompilerSession(session);
+}
+
+/* same as buildModule(), but the program in 'text' (followed by two NUL bytes) is checked and
+   lowered to IR while it is parsed, in place of parseSource(), isValidAST() and generateIR();
+   returns COMPILE_OK, or the stage the program failed */
+compile_status buildModuleSinglePass(char *text, size_t len, const char *module_name, std::string *ll_text,
+                                        std::string *bc_text, std::string *s_text, timeReport *report,
+                                        FILE *diagnostics) {
+    compilerSession *session = createCompilerSession();
+
+    timeStamp start = startTiming();
+    bool semantic_error;
+    LLVMModuleRef module = ownModule(session, parseToIR(text, len, module_name, session->context, &semantic_error,
+                                                            diagnostics));
+    recordPhase(report, "parseToIR", start);
+    if (module == NULL) {
+        freeCompilerSession(session);
+        return semantic_error ? COMPILE_SEMANTIC_ERROR : COMPILE_PARSE_ERROR;
+    }
+
+    emitModule(module, ll_text, bc_text, s_text, report);
+    freeCompilerSession(session);
+    return COMPILE_OK;
+}
+
+/* same as buildModule(), but the unoptimized module is read from the LLVM IR of a miniC program
+   (textual or bitcode) in the file 'filename', in place of parsing, isValidAST() and generateIR();
+   returns COMPILE_OK, or COMPILE_PARSE_ERROR if the file cannot be read or is not valid IR */
+compile_status buildModuleFromIR(const char *filename, std::string *ll_text, std::string *bc_text, std::string *s_text,
+                                    timeReport *report, FILE *diagnostics) {
+    timeStamp compile_start = startTiming();
+    compilerSession *session = createCompilerSession();
+
+    timeStamp start = startTiming();
+    LLVMModuleRef module = NULL;
+    LLVMMemoryBufferRef buffer;
+    char *message;
+    if (LLVMCreateMemoryBufferWithContentsOfFile(filename, &buffer, &message)) {
+        fprintf(diagnostics, "Error: unable to read '%s': %s\n", filename, message);
+        LLVMDisposeMessage(message);
+    }
+    else {
+        module = ownModule(session, readIR(session, buffer, filename, diagnostics));
+    }
+    recordPhase(report, "readIR", start);
+    if (module == NULL) {
+        freeCompilerSession(session);
+        return COMPILE_PARSE_ERROR;
+    }
+
+    // the module is named after the program it was generated from, not after the IR file
+    size_t name_len;
+    const char *source_name = LLVMGetSourceFileName(module, &name_len);
+    LLVMSetModuleIdentifier(module, source_name, name_len);
+
+    emitModule(module, ll_text, bc_text, s_text, report);
+    freeCompilerSession(session);
+    recordPhase(report, "compileIR", compile_start, NULL, 0, filename);
+    return COMPILE_OK;
+}
+
+/* optimizes the freshly generated 'module', then prints it to 'll_text', writes its bitcode to
+   'bc_text' and generates the assembly into 's_text' (any of which may be NULL) */
+void emitModule(LLVMModuleRef module, std::string *ll_text, std::string *bc_text, std::string *s_text,
+                    timeReport *report) {
+    timeStamp start = startTiming();
+    optimize(module, report);
+    recordPhase(report, "optimize", start);
+
+    // the IR is only printed or written as bitcode when it was asked for
+    if (ll_text != NULL) {
+        start = startTiming();
+        printIR(module, ll_text);
+        recordPhase(report, "printIR", start);
+    }
+    if (bc_text != NULL) {
+        start = startTiming();
+        writeBitcode(module, bc_text);
+        recordPhase(report, "writeBitcode", start);
+    }
+    if (s_text != NULL) {
+        start = startTiming();
+        s_text->clear();
+        captureOutput(s_text, [&](FILE *fp) { generateAssembly(module, fp); });
+        recordPhase(report, "generateAssembly", start);
+    }
+}
+
+/* same as buildModule(), but every function of the program is generated, optimized, printed
+   and turned into assembly on its own, concurrently on a pool of 'num_threads' threads. Each
+   function gets its own session (and so its own LLVM context), since LLVM state is not
+   thread-safe within a context. The
+   outputs of the functions are concatenated in source order, so they match those of
+   buildModule(). If 'cache' is not NULL, a function whose fingerprint (its AST, which also
+   names and gives the arity of every function it calls) is found in it is not compiled again,
+   and the outputs of the other functions are stored in it. The bitcode is converted from the
+   concatenated IR, since no single module holds every function; returns COMPILE_OK, or
+   COMPILE_OUTPUT_ERROR if that conversion failed */
+compile_status buildFunctions(const flatAST *ast, const char *module_name, std::string *ll_text,
+                                std::string *bc_text, std::string *s_text, int num_threads, compileCache *cache,
+                                timeReport *report, FILE *diagnostics) {
+    std::string converted_ll;
+    if (bc_text != NULL && ll_text == NULL) {
+        ll_text = &converted_ll;
+    }
+
+    std::vector<astIndex> flist;
+    getFunctions(ast, flist);
+    std::vector<std::string> func_asm(flist.size());
+    std::vector<std::string> func_ir(flist.size());
+
+    // no point in starting more threads than there are functions
+    if (num_threads < 1 || num_threads > flist.size()) {
+        num_threads = std::min((int)flist.size(), num_threads < 1 ? (int)std::thread::hardware_concurrency() : num_threads);
+    }
+
+    timeStamp functions_start = startTiming();
+    threadPool *pool = createThreadPool(num_threads);
+    for (int i = 0; i < flist.size(); i++) {
+        submitTask(pool, [&, i] {
+            astIndex func_node = flist.at(i);
+            const char *func_name = getName(ast->data[func_node]);
+
+            // the outputs of a function only depend on the function itself, so they can be
+            // reused whatever the rest of the program looks like
+            std::string key;
+            if (cache != NULL) {
+                timeStamp start = startTiming();
+                std::string fingerprint;
+                serializeFlatNode(ast, func_node, fingerprint);
+                key = getFunctionKey(cache, fingerprint);
+                bool hit = lookupFunction(cache, key, func_ir.at(i), func_asm.at(i));
+                recordPhase(report, "cacheLookup", start, "hits", hit, func_name);
+                if (hit) {
+                    return;
+                }
+            }
+
+            compilerSession *session = createCompilerSession();
+            timeStamp start = startTiming();
+            LLVMModuleRef module = ownModule(session, generateFunctionIR(ast, func_node, module_name, session->context));
+            LLVMValueRef function = LLVMGetNamedFunction(module, func_name);
+            recordPhase(report, "generateIR", start, NULL, 0, func_name);
+
+            start = startTiming();
+            optimizeFunction(function, report);
+            recordPhase(report, "optimize", start, NULL, 0, func_name);
+
+            if (s_text != NULL || cache != NULL) {
+                start = startTiming();
+                captureOutput(&func_asm.at(i), [&](FILE *fp) { generateFunctionAssembly(function, fp); });
+                recordPhase(report, "generateAssembly", start, NULL, 0, func_name);
+            }
+
+            if (ll_text != NULL || cache != NULL) {
+                start = startTiming();
+                char *ll = LLVMPrintValueToString(function);
+                func_ir.at(i).assign(ll);
+                LLVMDisposeMessage(ll);
+                recordPhase(report, "printIR", start, NULL, 0, func_name);
+            }
+
+            freeCompilerSession(session);
+
+            if (cache != NULL) {
+                start = startTiming();
+                storeCache(cache, key, func_ir.at(i), func_asm.at(i));
+                recordPhase(report, "cacheStore", start, NULL, 0, func_name);
+            }
+        });
+    }
+    waitForTasks(pool);
+    freeThreadPool(pool);
+    recordPhase(report, "compileFunctions", functions_start, "functions", flist.size());
+
+    if (s_text != NULL) {
+        s_text->clear();
+        captureOutput(s_text, [&](FILE *fp) { generateAssemblyHeader(module_name, fp); });
+        for (int i = 0; i < func_asm.size(); i++) {
+            s_text->append(func_asm.at(i));
+        }
+    }
+
+    // a module prints as its header and declarations followed by each function, separated by
+    // blank lines, so the IR of the functions can be printed separately and concatenated
+    if (ll_text != NULL) {
+        compilerSession *session = createCompilerSession();
+        printIR(ownModule(session, createProgramModule(module_name, session->context)), ll_text);
+        freeCompilerSession(session);
+        for (int i = 0; i < func_ir.size(); i++) {
+            ll_text->append("\n");
+            ll_text->append(func_ir.at(i));
+        }
+    }
+    if (bc_text != NULL) {
+        return convertIRToBitcode(*ll_text, module_name, bc_text, report, diagnostics);
+    }
+    return COMPILE_OK;
+}
+
+/* parses the LLVM IR in 'buffer', textual or bitcode, into a module of 'session' and checks it
+   with the verifier, then that it is in the subset the optimizer and code generator handle (see
+   isSupportedModule()); returns the module, which the caller owns, or NULL if the IR is not valid
+   or not supported (the reason is printed to 'diagnostics', naming the IR 'name'). The parser takes
+   ownership of 'buffer' */
+LLVMModuleRef readIR(compilerSession *session, LLVMMemoryBufferRef buffer, const char *name, FILE *diagnostics) {
+    LLVMModuleRef module;
+    char *message;
+    if (LLVMParseIRInContext(session->context, buffer, &module, &message)) {
+        fprintf(diagnostics, "Error: '%s' is not valid LLVM IR: %s\n", name, message);
+        LLVMDisposeMessage(message);
+        return NULL;
+    }
+    if (LLVMVerifyModule(module, LLVMReturnStatusAction, &message)) {
+        fprintf(diagnostics, "Error: '%s' is not valid LLVM IR: %s", name, message);
+        LLVMDisposeMessage(message);
+        LLVMDisposeModule(module);
+        return NULL;
+    }
+    LLVMDisposeMessage(message);
+    if (!isSupportedModule(module, name, diagnostics)) {
+        LLVMDisposeModule(module);
+        return NULL;
+    }
+    return module;
+}
+
+// replaces the contents of 'll_text' with the textual IR of 'module'
+void printIR(LLVMModuleRef module, std::string *ll_text) {
+    char *ll = LLVMPrintModuleToString(module);
+    ll_text->assign(ll);
+    LLVMDisposeMessage(ll);
+}
+
+// replaces the contents of 'bc_text' with the bitcode of 'module'
+void writeBitcode(LLVMModuleRef module, std::string *bc_text) {
+    LLVMMemoryBufferRef buffer = LLVMWriteBitcodeToMemoryBuffer(module);
+    bc_text->assign(LLVMGetBufferStart(buffer), LLVMGetBufferSize(buffer));
+    LLVMDisposeMemoryBuffer(buffer);
+}
+
+// replaces the contents of 'bc_text' with the bitcode of the textual IR 'll_text', which the
+// compiler printed itself; returns COMPILE_OUTPUT_ERROR, leaving 'bc_text' as it was, if the IR
+// could not be read back (the reason is printed to 'diagnostics')
+compile_status convertIRToBitcode(const std::string &ll_text, const char *module_name, std::string *bc_text,
+                                    timeReport *report, FILE *diagnostics) {
+    timeStamp start = startTiming();
+    compilerSession *session = createCompilerSession();
+
+    // the string's terminating NUL is the one the IR parser expects after the buffer
+    LLVMMemoryBufferRef buffer = LLVMCreateMemoryBufferWithMemoryRange(ll_text.c_str(), ll_text.size(), module_name, 1);
+    LLVMModuleRef module = ownModule(session, readIR(session, buffer, module_name, diagnostics));
+    if (module != NULL) {
+        writeBitcode(module, bc_text);
+    }
+    freeCompilerSession(session);
+    recordPhase(report, "writeBitcode", start);
+    return module != NULL ? COMPILE_OK : COMPILE_OUTPUT_ERROR;
+}
+
+// appends everything 'generate' writes to the stream it is given to 'text'
+void captureOutput(std::string *text, const std::function<void(FILE *)> &generate) {
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *fp = open_memstream(&buf, &len);
+    generate(fp);
+    fclose(fp);
+    text->append(buf, len);
+    free(buf);
+}
@@ -0,0 +1,205 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * driver.h - defines functions that run the full compile pipeline (parse, semantic analysis,
+ * IR generation, optimization and code generation) on one or many miniC programs
+ */
+
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include "compile_cache.h"
+#include "../support/time_report.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/*
+ * Result of compiling a single miniC program
+ */
+typedef enum {
+    COMPILE_OK,
+    COMPILE_PARSE_ERROR, // the file could not be read or contains a syntax error
+    COMPILE_SEMANTIC_ERROR, // the program failed semantic analysis
+    COMPILE_OUTPUT_ERROR // an output could not be produced or its file could not be written
+} compile_status;
+
+/*
+ * Kinds of output a compile can produce, combined with '|'; a compile that emits neither still
+ * runs every phase up to and including optimization
+ */
+#define EMIT_ASM 0x1 // the generated assembly ('.s')
+#define EMIT_LL 0x2 // the optimized LLVM IR ('.ll')
+#define EMIT_BC 0x4 // the optimized LLVM IR as bitcode ('.bc')
+
+/*
+ * The ways a compile can turn a program into unoptimized IR; both give the same IR
+ */
+typedef enum {
+    PIPELINE_AST, // parse to an AST, check it with isValidAST(), then walk it in generateIR() (the default)
+    PIPELINE_SINGLE_PASS // check and lower the program while parsing it, without an AST (see parseToIR())
+} pipelineKind;
+
+/*
+ * Selects the pipeline every later compile uses, in every thread
+ *
+ * Notes:
+ *      The single pass has no AST to split into functions, so it compiles the program as one
+ *      module whatever the number of threads; compiles with a per-function cache (which
+ *      fingerprints each function's AST) always use the AST pipeline.
+ */
+void selectPipeline(pipelineKind kind);
+
+/*
+ * Returns the pipeline selected by selectPipeline()
+ */
+pipelineKind getPipeline();
+
+/*
+ * Params:
+ *      const char *filename: path of the miniC program to compile, or of the LLVM IR of one if
+ *      it ends in '.ll' or '.bc' (see isIRFile())
+ *      const char *ll_path: path the optimized LLVM IR is written to; "-" writes it to stdout,
+ *      and NULL skips printing the IR altogether
+ *      const char *bc_path: same as 'll_path' for the bitcode of the optimized IR
+ *      const char *s_path: path the generated assembly is written to; "-" writes it to stdout,
+ *      and NULL skips code generation
+ *      timeReport *report: if not NULL, the time taken by each phase is recorded in it
+ *      compileCache *cache: if not NULL, the outputs are taken from this cache when it holds
+ *      them, and stored in it otherwise. A per-function cache (see createCompileCache()) is
+ *      looked up for each function instead, and only the functions it misses are compiled
+ *      int num_threads: number of threads the functions of the program are compiled on; less
+ *      than 1 uses one per hardware thread
+ *      FILE *diagnostics: stream the errors found in the program (syntax errors, failed
+ *      semantic checks, invalid IR) are printed to
+ *
+ * Returns:
+ *      COMPILE_OK if every requested output was written, otherwise the stage that failed
+ *
+ * Notes:
+ *      Each call creates (and frees) its own compiler sessions (see "compiler_session.h"), each
+ *      with an LLVM context of its own, so calls made from different threads do not share any
+ *      LLVM state, and each parse has its own parser context (see "parser.h"), so concurrent
+ *      calls run fully in parallel. When 'num_threads' is not 1 and the program defines several
+ *      functions, each function is generated, optimized and turned into assembly in a session of
+ *      its own on a thread pool; the outputs are identical to those of a compile on one thread.
+ *
+ *      The LLVM IR in a '.ll' or '.bc' file is read, checked with LLVM's verifier, then optimized
+ *      and turned into assembly as if it had just been generated; 'cache' and 'num_threads' are
+ *      not used for it. Only IR in the subset the compiler itself generates is accepted (such as
+ *      IR this function wrote, see isSupportedModule()); anything else is a COMPILE_PARSE_ERROR.
+ *      IR the compiler wrote comes back through it unchanged, so a program's bitcode gives the
+ *      same assembly as its source.
+ */
+compile_status compileFile(const char *filename, const char *ll_path, const char *bc_path, const char *s_path,
+                            timeReport *report = NULL, compileCache *cache = NULL, int num_threads = 1,
+                            FILE *diagnostics = stderr);
+
+/*
+ * Params:
+ *      const char *source: text of the miniC program to compile (need not be NUL-terminated)
+ *      size_t len: length of 'source' in bytes
+ *      const char *module_name: name given to the program, e.g. in the '.file' directive
+ *      std::string *ll_text: receives the optimized LLVM IR; if NULL, the IR is not printed
+ *      std::string *bc_text: receives the bitcode of the optimized LLVM IR; if NULL, no bitcode
+ *      is written
+ *      std::string *s_text: receives the generated assembly; if NULL, no code is generated
+ *      timeReport *report: if not NULL, the time taken by each phase is recorded in it
+ *      compileCache *cache: if not NULL, a cache hit returns the outputs without parsing or
+ *      compiling 'source'; successful compiles are stored in it
+ *      int num_threads: number of threads the functions of the program are compiled on (see
+ *      compileFile())
+ *      FILE *diagnostics: stream the errors found in the program are printed to; a compile
+ *      server passes one per request, so each client gets the messages of its own compile
+ *
+ * Returns:
+ *      COMPILE_OK if the requested outputs were produced, otherwise the stage that failed
+ *
+ * Notes:
+ *      Same as compileFile(), but works entirely in memory: no file is read or written. Every
+ *      module, session and AST created along the way is released before returning, so repeated
+ *      calls in one process do not accumulate memory. 'source' is copied once so the scanner
+ *      can read it in place; use compileBuffer() to avoid even that copy.
+ */
+compile_status compileSource(const char *source, size_t len, const char *module_name, std::string *ll_text,
+                                std::string *bc_text, std::string *s_text, timeReport *report = NULL,
+                                compileCache *cache = NULL, int num_threads = 1, FILE *diagnostics = stderr);
+
+/*
+ * Params:
+ *      char *buffer: text of the miniC program to compile, followed by two NUL bytes (for
+ *      example the 'text' of a sourceBuffer from mapSourceFile()). The scanner reads it in
+ *      place without copying it, and writes to it while it runs
+ *      size_t len: length of the program in bytes, not counting the two NUL bytes
+ *      the remaining parameters are the same as those of compileSource()
+ *
+ * Returns:
+ *      COMPILE_OK if the requested outputs were produced, otherwise the stage that failed
+ */
+compile_status compileBuffer(char *buffer, size_t len, const char *module_name, std::string *ll_text,
+                                std::string *bc_text, std::string *s_text, timeReport *report = NULL,
+                                compileCache *cache = NULL, int num_threads = 1, FILE *diagnostics = stderr);
+
+/*
+ * Params:
+ *      std::vector<std::string> &inputs: paths of the miniC programs to compile
+ *      const char *out_dir: directory that receives the outputs, or NULL to write each
+ *      program's outputs next to it
+ *      int emit: the outputs to write (a combination of EMIT_ASM, EMIT_LL and EMIT_BC)
+ *      int num_threads: number of worker threads; less than 1 uses one per hardware thread
+ *      timeReport *report: if not NULL, the phases of every compile are recorded in it
+ *      compileCache *cache: if not NULL, shared by every compile (see compileFile())
+ *
+ * Returns:
+ *      the number of programs that failed to compile
+ *
+ * Notes:
+ *      The outputs of 'dir/name.c' are 'name.ll', 'name.bc' and 'name.s' (placed in 'dir' or
+ *      'out_dir'); an input whose own output would replace it is an error.
+ *      Every program is compiled exactly as compileFile() would compile it, so the outputs are
+ *      identical to those of serial runs. A summary with the aggregate throughput (files/sec)
+ *      is printed to stderr once every job has finished.
+ */
+int compileBatch(std::vector<std::string> &inputs, const char *out_dir, int emit, int num_threads,
+                    timeReport *report = NULL, compileCache *cache = NULL);
+
+/*
+ * Params:
+ *      const char *manifest: path of a text file listing one miniC program per line; blank
+ *      lines and lines starting with '#' are ignored
+ *      std::vector<std::string> &inputs: vector the listed paths are appended to
+ *
+ * Returns:
+ *      TRUE, if the manifest was read successfully
+ *      FALSE, otherwise
+ */
+bool readManifest(const char *manifest, std::vector<std::string> &inputs);
+
+/*
+ * Params:
+ *      const char *list: comma-separated output kinds, each one of "asm", "ll", "bc" or "none"
+ *      (e.g. the value of '--emit=asm,ll')
+ *
+ * Returns:
+ *      the matching combination of EMIT_ASM, EMIT_LL and EMIT_BC, or -1 if 'list' names an unknown kind
+ *      (an error message is printed to stderr)
+ */
+int parseEmitKinds(const char *list);
+
+/*
+ * Params:
+ *      const std::string &input: path of a miniC program, e.g. 'dir/name.c'
+ *      const char *out_dir: directory the output goes in, or NULL for the input's directory
+ *      const char *extension: extension of the output, e.g. ".s"
+ *
+ * Returns:
+ *      'dir/name<extension>', or 'out_dir/name<extension>' if an output directory is given
+ */
+std::string getOutputPath(const std::string &input, const char *out_dir, const char *extension);
+
+/*
+ * Returns TRUE if 'filename' ends in '.ll' or '.bc', which compileFile() reads as LLVM IR rather
+ * than as a miniC program
+ */
+bool isIRFile(const char *filename);
+
+#endif
@@ -0,0 +1,162 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * thread_pool.c - implements a small work-stealing thread pool used to run independent
+ * compile jobs concurrently
+ */
+
+#include "thread_pool.h"
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/* a single worker's queue of pending tasks */
+typedef struct {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+} taskQueue;
+
+struct thread_Pool {
+    std::vector<std::thread> workers;
+    std::vector<taskQueue*> queues; // queues.at(i) belongs to workers.at(i)
+
+    std::mutex lock; // guards every field below
+    std::condition_variable has_work;
+    std::condition_variable all_done;
+    int queued; // tasks sitting in a queue
+    int pending; // tasks submitted but not yet finished
+    int next_queue; // queue that receives the next submitted task
+    bool stopping;
+};
+
+/***************************************** FUNCTION HEADERS *****************************************/
+void runWorker(threadPool *pool, int id);
+bool takeTask(threadPool *pool, int id, std::function<void()> &task);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "thread_pool.h" for details ***********************/
+threadPool *createThreadPool(int num_threads) {
+    if (num_threads < 1) {
+        num_threads = std::thread::hardware_concurrency();
+        if (num_threads < 1) {
+            num_threads = 1;
+        }
+    }
+
+    threadPool *pool = new threadPool();
+    pool->queued = 0;
+    pool->pending = 0;
+    pool->next_queue = 0;
+    pool->stopping = false;
+
+    for (int i = 0; i < num_threads; i++) {
+        pool->queues.push_back(new taskQueue());
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pool->workers.push_back(std::thread(runWorker, pool, i));
+    }
+    return pool;
+}
+
+/*********************** see "thread_pool.h" for details ***********************/
+void submitTask(threadPool *pool, std::function<void()> task) {
+    int target;
+    {
+        std::lock_guard<std::mutex> guard(pool->lock);
+        target = pool->next_queue;
+        pool->next_queue = (pool->next_queue + 1) % pool->queues.size();
+        pool->queued += 1;
+        pool->pending += 1;
+    }
+    {
+        taskQueue *queue = pool->queues.at(target);
+        std::lock_guard<std::mutex> guard(queue->lock);
+        queue->tasks.push_back(task);
+    }
+    pool->has_work.notify_one();
+}
+
+/*********************** see "thread_pool.h" for details ***********************/
+void waitForTasks(threadPool *pool) {
+    std::unique_lock<std::mutex> guard(pool->lock);
+    pool->all_done.wait(guard, [pool] { return pool->pending == 0; });
+}
+
+/*********************** see "thread_pool.h" for details ***********************/
+int getPoolSize(threadPool *pool) {
+    return pool->workers.size();
+}
+
+/*********************** see "thread_pool.h" for details ***********************/
+void freeThreadPool(threadPool *pool) {
+    waitForTasks(pool);
+    {
+        std::lock_guard<std::mutex> guard(pool->lock);
+        pool->stopping = true;
+    }
+    pool->has_work.notify_all();
+
+    for (int i = 0; i < pool->workers.size(); i++) {
+        pool->workers.at(i).join();
+    }
+    for (int i = 0; i < pool->queues.size(); i++) {
+        delete pool->queues.at(i);
+    }
+    delete pool;
+}
+
+/* Takes a task for worker 'id': the newest task of its own queue if there is one, otherwise
+   the oldest task of the first other queue that is non-empty. Returns false if every queue is empty */
+bool takeTask(threadPool *pool, int id, std::function<void()> &task) {
+    int num_queues = pool->queues.size();
+    for (int i = 0; i < num_queues; i++) {
+        taskQueue *queue = pool->queues.at((id + i) % num_queues);
+        std::lock_guard<std::mutex> guard(queue->lock);
+        if (queue->tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = queue->tasks.back();
+            queue->tasks.pop_back();
+        }
+        else {
+            task = queue->tasks.front();
+            queue->tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+/* main loop of each worker thread: runs tasks until the pool is stopped and drained */
+void runWorker(threadPool *pool, int id) {
+    while (true) {
+        std::function<void()> task;
+        if (takeTask(pool, id, task)) {
+            {
+                std::lock_guard<std::mutex> guard(pool->lock);
+                pool->queued -= 1;
+            }
+            task();
+
+            std::lock_guard<std::mutex> guard(pool->lock);
+            pool->pending -= 1;
+            if (pool->pending == 0) {
+                pool->all_done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(pool->lock);
+        if (pool->queued > 0) {
+            continue; // a task was submitted but has not reached its queue yet
+        }
+        if (pool->stopping) {
+            return;
+        }
+        pool->has_work.wait(guard, [pool] { return pool->queued > 0 || pool->stopping; });
+    }
+}
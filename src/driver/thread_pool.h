@@ -0,0 +1,57 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * thread_pool.h - defines a small work-stealing thread pool used to run independent
+ * compile jobs concurrently
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <functional>
+
+struct thread_Pool;
+typedef struct thread_Pool threadPool;
+
+/*
+ * Params:
+ *      int num_threads: the number of worker threads to start; if it is less than 1,
+ *      one worker is started per hardware thread reported by the machine
+ *
+ * Returns:
+ *      a pointer to a newly allocated thread pool whose workers are already running
+ *
+ * Notes:
+ *      Each worker owns a task queue. Workers take tasks from the back of their own
+ *      queue and, once it is empty, steal from the front of the other workers' queues,
+ *      so long-running jobs do not leave the remaining workers idle.
+ */
+threadPool *createThreadPool(int num_threads);
+
+/*
+ * Params:
+ *      threadPool *pool: a pool created by createThreadPool()
+ *      std::function<void()> task: the job to run on one of the pool's workers
+ *
+ * Notes:
+ *      Tasks are distributed round-robin across the worker queues. A task must not
+ *      call waitForTasks() on the pool that is running it.
+ */
+void submitTask(threadPool *pool, std::function<void()> task);
+
+/*
+ * Blocks the calling thread until every task submitted to 'pool' so far has finished
+ */
+void waitForTasks(threadPool *pool);
+
+/*
+ * Returns:
+ *      the number of worker threads owned by 'pool'
+ */
+int getPoolSize(threadPool *pool);
+
+/*
+ * Waits for all outstanding tasks, joins the worker threads and releases the pool
+ */
+void freeThreadPool(threadPool *pool);
+
+#endif
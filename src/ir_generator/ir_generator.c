@@ -4,295 +4,421 @@
  */
 
 #include "ir_generator.h"
+#include "../parser/semantic_analysis.h"
+#include "ssa_builder.h"
 #include <vector>
 #include <string>
-#include <unordered_map>
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 
+/* an if statement or while loop whose body is being generated */
+typedef struct {
+    astIndex node;
+    astIndex body_end; // where the body being generated ends
+    LLVMBasicBlockRef else_BB; // if statement: the block of the else body, until it is reached
+    LLVMBasicBlockRef final; // where the branches join
+    LLVMBasicBlockRef check_BB; // while loop: the block that checks the condition
+} openStatement;
+
 /***************************************** FUNCTION HEADERS *****************************************/
 
-void generateStmtIR(astNode *node, LLVMModuleRef module, std::unordered_map<string, 
-                            LLVMValueRef> &ptr_map, LLVMBuilderRef &builder, LLVMValueRef func);
-                            
-LLVMValueRef generate(astNode *node, LLVMModuleRef module, std::unordered_map<string, 
-                                                    LLVMValueRef> &ptr_map, LLVMBuilderRef builder);
+void generateNodeIR(const flatAST *ast, astIndex root, LLVMModuleRef module, ssaBuilder *ssa, LLVMBuilderRef builder);
+
+void closeStatements(const flatAST *ast, std::vector<openStatement> &open, astIndex node, ssaBuilder *ssa, LLVMBuilderRef builder);
 
-void generateNodeIR(astNode *node, LLVMModuleRef module, std::unordered_map<string, 
-                                    LLVMValueRef> &ptr_map, LLVMBuilderRef builder, LLVMValueRef func);
+LLVMValueRef generate(const flatAST *ast, astIndex root, LLVMModuleRef module, ssaBuilder *ssa, LLVMBuilderRef builder);
 
-void cleanUpIR(LLVMModuleRef module);
+LLVMValueRef buildExpression(const flatAST *ast, astIndex node, LLVMValueRef *operands, LLVMModuleRef module,
+                                ssaBuilder *ssa, LLVMBuilderRef builder);
 
 
 /***************************************** IMPLEMENTATION *****************************************/
 
 /*********************** see "ir_generator.h" for details ***********************/
-LLVMModuleRef generateIR(astNode *root, const char *module_name) {
+LLVMModuleRef generateIR(astNode *root, const char *module_name, LLVMContextRef context) {
+    flatAST *ast = flattenAST(root);
+    resolveVariables(ast, 0);
+    LLVMModuleRef module = generateIR(ast, module_name, context);
+    freeFlatAST(ast);
+    return module;
+}
 
-    // boilerplate module and builder instantiation
-    LLVMModuleRef module = LLVMModuleCreateWithName(module_name);
-    LLVMSetTarget(module, "x86_64-pc-linux-gnu");
+/*********************** see "ir_generator.h" for details ***********************/
+LLVMModuleRef generateIR(const flatAST *ast, const char *module_name, LLVMContextRef context) {
+    LLVMModuleRef module = createProgramModule(module_name, context);
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+
+    // the values of the variables of the function being generated, by slot
+    ssaBuilder *ssa = createSSABuilder(context);
+
+    generateNodeIR(ast, 0, module, ssa, builder);
+    cleanUpIR(module);
+    freeSSABuilder(ssa);
+    LLVMDisposeBuilder(builder);
 
-    LLVMBuilderRef builder = LLVMCreateBuilder();
-    LLVMValueRef func;
+    return module;
+}
+
+/*********************** see "ir_generator.h" for details ***********************/
+LLVMModuleRef generateFunctionIR(astNode *func_node, const char *module_name, LLVMContextRef context) {
+    flatAST *ast = flattenAST(func_node);
+    resolveVariables(ast, 0);
+    LLVMModuleRef module = generateFunctionIR(ast, 0, module_name, context);
+    freeFlatAST(ast);
+    return module;
+}
+
+/*********************** see "ir_generator.h" for details ***********************/
+LLVMModuleRef generateFunctionIR(const flatAST *ast, astIndex func_node, const char *module_name, LLVMContextRef context) {
+    LLVMModuleRef module = createProgramModule(module_name, context);
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
 
-    // used to keep track of which pointers should be used at any given point
-    std::unordered_map<std::string, LLVMValueRef> ptr_map;
+    ssaBuilder *ssa = createSSABuilder(context);
+
+    generateNodeIR(ast, func_node, module, ssa, builder);
+    cleanUpIR(module);
+    freeSSABuilder(ssa);
+    LLVMDisposeBuilder(builder);
+
+    return module;
+}
+
+/*********************** see "ir_generator.h" for details ***********************/
+LLVMModuleRef createProgramModule(const char *module_name, LLVMContextRef context) {
+
+    // boilerplate module instantiation
+    LLVMModuleRef module = LLVMModuleCreateWithNameInContext(module_name, context);
+    LLVMSetTarget(module, "x86_64-pc-linux-gnu");
 
      // extern print declaration
-    LLVMTypeRef print_param_types[] = { LLVMInt32Type() };
-    LLVMTypeRef print_func_type = LLVMFunctionType(LLVMVoidType(), print_param_types, 1, 0);
+    LLVMTypeRef print_param_types[] = { LLVMInt32TypeInContext(context) };
+    LLVMTypeRef print_func_type = LLVMFunctionType(LLVMVoidTypeInContext(context), print_param_types, 1, 0);
     LLVMValueRef extern_print = LLVMAddFunction(module, "print", print_func_type);
     LLVMSetLinkage(extern_print, LLVMExternalLinkage);
 
     // extern read declaration
     LLVMTypeRef read_param_types[] = { };
-    LLVMTypeRef read_func_type = LLVMFunctionType(LLVMInt32Type(), read_param_types, 0, 0);
+    LLVMTypeRef read_func_type = LLVMFunctionType(LLVMInt32TypeInContext(context), read_param_types, 0, 0);
     LLVMValueRef extern_read = LLVMAddFunction(module, "read", read_func_type);
     LLVMSetLinkage(extern_read, LLVMExternalLinkage);
 
-    generateNodeIR(root, module, ptr_map, builder, func);
-    cleanUpIR(module);
-    LLVMDisposeBuilder(builder);
-    
     return module;
 }
-/* outermost level of recursion: initializes the 'program' and 'function' nodes and passes off 
-   generic 'ast_stmt' nodes */
-void generateNodeIR(astNode *node, LLVMModuleRef module, std::unordered_map<string, LLVMValueRef> &ptr_map, LLVMBuilderRef builder, LLVMValueRef func) {
-    switch (node->type) {
-        case ast_prog: {
-            generateNodeIR(node->prog.func, module, ptr_map, builder, func);
-            break;
-        }
-
-        // due to miniC constraints, this case should only be hit when we encounter the definition
-        // of the main, user-defined function
-        case ast_func: {
-            LLVMTypeRef param_types[] = {};
-            int num_params = 0;
-            if (node->func.param != NULL) {
-                param_types[0] = LLVMInt32Type();
-                num_params = 1;
-            }
 
-            LLVMTypeRef func_type = LLVMFunctionType(LLVMInt32Type(), param_types, num_params, 0);
-            func = LLVMAddFunction(module, node->func.name, func_type);
-            LLVMBasicBlockRef func_block = LLVMAppendBasicBlock(func, "");
-            LLVMPositionBuilderAtEnd(builder, func_block);
+/*********************** see "ir_generator.h" for details ***********************/
+LLVMValueRef getUserFunction(LLVMModuleRef module, const char *name, bool has_param) {
+    LLVMValueRef func = LLVMGetNamedFunction(module, name);
+    if (func != NULL) {
+        return func;
+    }
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMTypeRef param_types[] = { LLVMInt32TypeInContext(context) };
+    LLVMTypeRef func_type = LLVMFunctionType(LLVMInt32TypeInContext(context), param_types, has_param ? 1 : 0, 0);
+    return LLVMAddFunction(module, name, func_type);
+}
 
-            // a function parameter serves as a variable declaration and an indirect store of the passed parameter
-            // into the declared variable
-            if (num_params == 1) {
-                LLVMValueRef param = LLVMBuildAlloca(builder, LLVMInt32Type(), node->func.param->var.name);
-                LLVMSetAlignment(param, 4);
+/* generates the IR of the subtree of 'root' (the program or a function) in a single pass over its
+   nodes: they are in preorder, so the statements are reached in the order a traversal of the tree
+   visits them. Instead of recursing into the body of an if statement or while loop, the statement
+   waits on the 'open' stack for its body to end, and its branches are closed there */
+void generateNodeIR(const flatAST *ast, astIndex root, LLVMModuleRef module, ssaBuilder *ssa, LLVMBuilderRef builder) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMValueRef func = NULL;
+    std::vector<openStatement> open;
+    open.reserve(AST_STACK_CAPACITY);
+
+    astIndex end = getNextNode(ast, root);
+    astIndex node = root;
+    while (node < end) {
+        closeStatements(ast, open, node, ssa, builder);
+
+        switch (ast->kinds[node]) {
+            case flat_prog: {
+                // declare every function up front so that they appear in the module in source order,
+                // whatever order they are called in
+                std::vector<astIndex> flist;
+                getFunctions(ast, flist);
+                for (int i = 0; i < flist.size(); i++) {
+                    getUserFunction(module, getName(ast->data[flist.at(i)]), ast->kinds[flist.at(i) + 1] == flat_var);
+                }
+                node++;
+                break;
+            }
+            // the externs are declared with the module
+            case flat_extern: {
+                node++;
+                break;
+            }
 
-                std::pair<string, LLVMValueRef> ptr_entry (node->func.param->var.name, param);
-                ptr_map.insert(ptr_entry);
-                LLVMBuildStore(builder, LLVMGetParam(func, 0), param);
+            // hit when we encounter the definition of a user-defined function
+            case flat_func: {
+                astIndex body = node + 1;
+                int num_params = ast->kinds[body] == flat_var ? 1 : 0;
+                if (func != NULL) {
+                    finishSSAFunction(ssa);
+                }
+                func = getUserFunction(module, getName(ast->data[node]), num_params == 1);
+                startSSAFunction(ssa); // variables are local to the function that declares them
+
+                LLVMBasicBlockRef func_block = LLVMAppendBasicBlockInContext(context, func, "");
+                LLVMPositionBuilderAtEnd(builder, func_block);
+                sealBlock(ssa, func_block);
+
+                // a function parameter serves as a variable declaration whose value is the passed parameter
+                if (num_params == 1) {
+                    LLVMValueRef param = LLVMGetParam(func, 0);
+                    LLVMSetValueName2(param, getName(ast->data[body]), strlen(getName(ast->data[body])));
+                    writeVariable(ssa, ast->slots[body], func_block, param);
+                    body = getNextNode(ast, body);
+                }
+                node = body;
+                break;
             }
-            
+            // the statements of a block follow it
+            case flat_block: {
+                node++;
+                break;
+            }
+            // a declared variable holds 0 until it is assigned; the slots of a function are
+            // numbered in the order their declarations are reached, so a new variable takes the
+            // next one, while a declaration repeated in the same scope reuses the slot of the first
+            case flat_decl: {
+                writeVariable(ssa, ast->slots[node], LLVMGetInsertBlock(builder), LLVMConstInt(LLVMInt32TypeInContext(context), 0, 1));
+                node++;
+                break;
+            }
+            // an assignment gives the variable the value of the expression from here on
+            case flat_asgn: {
+                astIndex lhs = node + 1;
+                LLVMValueRef value = generate(ast, getNextNode(ast, lhs), module, ssa, builder);
+                writeVariable(ssa, ast->slots[lhs], LLVMGetInsertBlock(builder), value);
+                node = getNextNode(ast, node);
+                break;
+            }
+            // create if/else basic blocks, position builder accordingly; the if body comes next.
+            // The bodies can only be entered from the condition, so their blocks are sealed now
+            case flat_if: {
+                astIndex if_body = getNextNode(ast, node + 1);
+                astIndex else_body = getNextNode(ast, if_body); // the end of the if statement if there is no else body
+                LLVMValueRef cond = generate(ast, node + 1, module, ssa, builder);
+                LLVMBasicBlockRef cond_BB = LLVMGetInsertBlock(builder);
+                LLVMBasicBlockRef if_BB = LLVMAppendBasicBlockInContext(context, func, "");
+                LLVMBasicBlockRef else_BB = NULL;
+                LLVMBasicBlockRef final;
+                addPredecessor(ssa, if_BB, cond_BB);
+                sealBlock(ssa, if_BB);
+
+                if (else_body < getNextNode(ast, node)) {
+                    else_BB = LLVMAppendBasicBlockInContext(context, func, "");
+                    final = LLVMAppendBasicBlockInContext(context, func, "");
+                    LLVMBuildCondBr(builder, cond, if_BB, else_BB);
+                    addPredecessor(ssa, else_BB, cond_BB);
+                    sealBlock(ssa, else_BB);
+                }
+                else {
+                    final = LLVMAppendBasicBlockInContext(context, func, "");
+                    LLVMBuildCondBr(builder, cond, if_BB, final);
+                    addPredecessor(ssa, final, cond_BB);
+                }
+                LLVMPositionBuilderAtEnd(builder, if_BB);
+                open.push_back({node, else_body, else_BB, final, NULL});
+                node = if_body;
+                break;
+            }
+            // create while block; the body comes next. The check is reached again from the end of
+            // the body, so it is only sealed once the body has been generated
+            case flat_while: {
+                // need this 'condition checking' block in order to imitate looping
+                LLVMBasicBlockRef check_BB = LLVMAppendBasicBlockInContext(context, func, "");
+
+                LLVMBasicBlockRef while_body = LLVMAppendBasicBlockInContext(context, func, "");
+                LLVMBasicBlockRef final = LLVMAppendBasicBlockInContext(context, func, "");
+
+                LLVMBuildBr(builder, check_BB);
+                addPredecessor(ssa, check_BB, LLVMGetInsertBlock(builder));
+                LLVMPositionBuilderAtEnd(builder, check_BB);
+
+                LLVMValueRef cond = generate(ast, node + 1, module, ssa, builder);
+                LLVMBuildCondBr(builder, cond, while_body, final);
+                addPredecessor(ssa, while_body, check_BB);
+                sealBlock(ssa, while_body);
+                addPredecessor(ssa, final, check_BB);
+                sealBlock(ssa, final);
+
+                LLVMPositionBuilderAtEnd(builder, while_body);
+                open.push_back({node, getNextNode(ast, node), NULL, final, check_BB});
+                node = getNextNode(ast, node + 1);
+                break;
+            }
+            // create a call instruction
+            case flat_call: {
+                generate(ast, node, module, ssa, builder);
+                node = getNextNode(ast, node);
+                break;
+            }
+            // create a return instruction
+            case flat_ret: {
+                LLVMValueRef ret_val = generate(ast, node + 1, module, ssa, builder);
+                LLVMBuildRet(builder, ret_val);
+                markReturned(ssa, LLVMGetInsertBlock(builder));
+                node = getNextNode(ast, node);
+                break;
+            }
+            default: {
+                fprintf(stderr, "Error: Invalid node type encountered in IR generation\n");
+                exit(1);
+            }
+        }
+    }
+    closeStatements(ast, open, end, ssa, builder);
+    if (func != NULL) {
+        finishSSAFunction(ssa);
+    }
+}
 
-            generateNodeIR(node->func.body, module, ptr_map, builder, func);
-            break;
+/* closes the branches of the statements on top of 'open' whose body ends at or before 'node': a
+   while loop branches back to its check, and an if body to the join block, or, if the statement
+   has an else body, the else body is started instead. Each block branched to is sealed once its
+   last predecessor is in */
+void closeStatements(const flatAST *ast, std::vector<openStatement> &open, astIndex node, ssaBuilder *ssa, LLVMBuilderRef builder) {
+    while (!open.empty() && open.back().body_end <= node) {
+        openStatement &stmt = open.back();
+        LLVMBasicBlockRef body_BB = LLVMGetInsertBlock(builder);
+        if (stmt.check_BB != NULL) {
+            LLVMBuildBr(builder, stmt.check_BB);
+            addPredecessor(ssa, stmt.check_BB, body_BB);
+            sealBlock(ssa, stmt.check_BB);
+            LLVMPositionBuilderAtEnd(builder, stmt.final);
+            open.pop_back();
         }
-        case ast_stmt: {
-            generateStmtIR(node, module, ptr_map, builder, func);
-            break;
+        else if (stmt.else_BB != NULL) {
+            LLVMBuildBr(builder, stmt.final);
+            addPredecessor(ssa, stmt.final, body_BB);
+            LLVMPositionBuilderAtEnd(builder, stmt.else_BB);
+            stmt.else_BB = NULL;
+            stmt.body_end = getNextNode(ast, stmt.node);
         }
-        default: {
-            fprintf(stderr, "Error: Invalid node type encountered in IR generation\n");
-            exit(1);
-
+        else {
+            LLVMBuildBr(builder, stmt.final);
+            addPredecessor(ssa, stmt.final, body_BB);
+            sealBlock(ssa, stmt.final);
+            LLVMPositionBuilderAtEnd(builder, stmt.final);
+            open.pop_back();
         }
     }
-
 }
 
-/* takes an 'ast_stmt' node as parameter and generates the corresponding LLVM IR associated with statement 
-   type (statements must be one of ast_block, ast_decl, ast_asgn, ast_if, ast_while, ast_call, or ast_ret )*/
-void generateStmtIR(astNode *node, LLVMModuleRef module, std::unordered_map<string, LLVMValueRef> &ptr_map, LLVMBuilderRef &builder, LLVMValueRef func) {
-
-	switch (node->stmt.type) {
-        
-        // handle each statement within the block statement as a separate node
-		case ast_block: {
-			vector<astNode*> *slist = node->stmt.block.stmt_list;
-			for (int i = 0; i < slist->size(); i++) {
-                
-				generateNodeIR(slist->at(i), module, ptr_map, builder, func);
-			}
-			break;
-		}
-        // allocate memory for a pointer when a variable is declared
-		case ast_decl: {
-			LLVMValueRef decl = LLVMBuildAlloca(builder, LLVMInt32Type(), node->stmt.decl.name);
-            LLVMSetAlignment(decl, 4);
-            std::pair<string, LLVMValueRef> ptr_entry (node->stmt.decl.name, decl);
-            ptr_map.insert(ptr_entry);
-			break;
-		}
-        // build a store instruction for a variable assignment
-		case ast_asgn: {
-            LLVMBuildStore(builder, generate(node->stmt.asgn.rhs, module, ptr_map, builder), ptr_map.at(node->stmt.asgn.lhs->var.name));
-			break;
-
-		}
-        // create if/else basic blocks, position builder accordingly
-		case ast_if: {
-            LLVMValueRef cond = generate(node->stmt.ifn.cond, module, ptr_map, builder);
-            LLVMBasicBlockRef if_BB = LLVMAppendBasicBlock(func, "");
-            LLVMBasicBlockRef final;
-
-            if (node->stmt.ifn.else_body != NULL) {
-                LLVMBasicBlockRef else_BB = LLVMAppendBasicBlock(func, "");
-                final = LLVMAppendBasicBlock(func, "");
-
-                LLVMBuildCondBr(builder, cond, if_BB, else_BB);
-                LLVMPositionBuilderAtEnd(builder, if_BB);
-                generateNodeIR(node->stmt.ifn.if_body, module, ptr_map, builder, func);
-                LLVMBuildBr(builder, final);
-
-                LLVMPositionBuilderAtEnd(builder, else_BB);
-                generateNodeIR(node->stmt.ifn.else_body, module, ptr_map, builder, func);
-                LLVMBuildBr(builder, final);
-
-            }
-            else {
-                final = LLVMAppendBasicBlock(func, "");
-                LLVMBuildCondBr(builder, cond, if_BB, final);
-                LLVMPositionBuilderAtEnd(builder, if_BB);
-                generateNodeIR(node->stmt.ifn.if_body, module, ptr_map, builder, func);
-                LLVMBuildBr(builder, final);
+/* builds the instructions of the expression rooted at 'root' and returns its value. Its nodes are
+   visited in preorder, and each one waits on the 'pending' stack until the values of its operands
+   are in, which is at the end of its subtree; the instructions therefore come out in the same
+   order as when each operand is generated in turn, left to right */
+LLVMValueRef generate(const flatAST *ast, astIndex root, LLVMModuleRef module, ssaBuilder *ssa, LLVMBuilderRef builder) {
+    std::vector<astIndex> pending;
+    std::vector<LLVMValueRef> values; // the values of the operands generated so far
+    pending.reserve(AST_STACK_CAPACITY);
+    values.reserve(AST_STACK_CAPACITY);
+
+    astIndex end = getNextNode(ast, root);
+    for (astIndex node = root; node < end; node++) {
+        // a function of the program is declared in this module when its call is reached, before
+        // its argument is generated
+        if (ast->kinds[node] == flat_call && ast->data[node] != NAME_PRINT && ast->data[node] != NAME_READ) {
+            getUserFunction(module, getName(ast->data[node]), ast->sizes[node] > 1);
+        }
+        pending.push_back(node);
+        while (!pending.empty() && getNextNode(ast, pending.back()) == node + 1) {
+            astIndex expr = pending.back();
+            pending.pop_back();
+            int num_operands = 0;
+            if (ast->sizes[expr] > 1) {
+                num_operands = ast->kinds[expr] == flat_bexpr || ast->kinds[expr] == flat_rexpr ? 2 : 1;
             }
-            LLVMPositionBuilderAtEnd(builder, final);
-			break;
-		}
-        // create while block
-		case ast_while: {
-            // need this 'condition checking' block in order to imitate looping
-            LLVMBasicBlockRef check_BB = LLVMAppendBasicBlock(func, ""); 
-
-            LLVMBasicBlockRef while_body = LLVMAppendBasicBlock(func, "");
-            LLVMBasicBlockRef final = LLVMAppendBasicBlock(func, "");
-
-            LLVMBuildBr(builder, check_BB);
-            LLVMPositionBuilderAtEnd(builder, check_BB);
-
-            LLVMValueRef cond = generate(node->stmt.whilen.cond, module, ptr_map, builder);
-            LLVMBuildCondBr(builder, cond, while_body, final);
-
-            LLVMPositionBuilderAtEnd(builder, while_body);
-            generateNodeIR(node->stmt.whilen.body, module, ptr_map, builder, func);
-            LLVMBuildBr(builder, check_BB);
-
-            LLVMPositionBuilderAtEnd(builder, final);
-
-			break;
-		}
-
-        // create a call instruction
-		case ast_call: {
-            generate(node, module, ptr_map, builder);
-			break;
-		}
-        // create a return instruction
-		case ast_ret: {
-            LLVMValueRef ret_val = generate(node->stmt.ret.expr, module, ptr_map, builder);
-            LLVMBuildRet(builder, ret_val);
-			break;
-		}
-	}
+            LLVMValueRef value = buildExpression(ast, expr, values.data() + values.size() - num_operands, module, ssa, builder);
+            values.resize(values.size() - num_operands);
+            values.push_back(value);
+        }
+    }
+    return values.back();
 }
 
-/* innermost level of recursion: builds instructions for arithmetic expressions, comparisons, 
-   loads, and stores */
-LLVMValueRef generate(astNode *node, LLVMModuleRef module, std::unordered_map<string, LLVMValueRef> &ptr_map, LLVMBuilderRef builder) {
-    switch (node->type) {
+/* builds the instruction of a single expression node (arithmetic expressions, comparisons, calls
+   and variables) from the values of its operands, and returns its value */
+LLVMValueRef buildExpression(const flatAST *ast, astIndex node, LLVMValueRef *operands, LLVMModuleRef module, ssaBuilder *ssa, LLVMBuilderRef builder) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    switch (ast->kinds[node]) {
         // arithmetic expressions
-        case ast_bexpr: {
-            LLVMValueRef lhs = generate(node->bexpr.lhs, module, ptr_map, builder);
-            LLVMValueRef rhs = generate(node->bexpr.rhs, module, ptr_map, builder);
-            if (node->bexpr.op == mul) {
-                return LLVMBuildMul(builder, lhs, rhs, "");
+        case flat_bexpr: {
+            if (ast->data[node] == mul) {
+                return LLVMBuildMul(builder, operands[0], operands[1], "");
             }
-            else if (node->bexpr.op == add) {
-                return LLVMBuildAdd(builder, lhs, rhs, "");
+            else if (ast->data[node] == add) {
+                return LLVMBuildAdd(builder, operands[0], operands[1], "");
             }
-            else if (node->bexpr.op == sub) {
-                return LLVMBuildSub(builder, lhs, rhs, "");
+            else if (ast->data[node] == sub) {
+                return LLVMBuildSub(builder, operands[0], operands[1], "");
             }
             else {
-                return LLVMBuildSDiv(builder, lhs, rhs, "");
+                return LLVMBuildSDiv(builder, operands[0], operands[1], "");
             }
         }
         // handles unary minus expressions by the subtracting the value from zero
-        case ast_uexpr: {
-            LLVMValueRef expr = generate(node->uexpr.expr, module, ptr_map, builder);
-            if (node->uexpr.op == uminus) {
-                LLVMValueRef zero = LLVMConstInt(LLVMInt32Type(), 0, 1);
-                return LLVMBuildSub(builder, zero, expr, "");
-            }
+        case flat_uexpr: {
+            LLVMValueRef zero = LLVMConstInt(LLVMInt32TypeInContext(context), 0, 1);
+            return LLVMBuildSub(builder, zero, operands[0], "");
         }
         // comparison expressions
-        case ast_rexpr: {
-            LLVMValueRef lhs = generate(node->rexpr.lhs, module, ptr_map, builder);
-            LLVMValueRef rhs = generate(node->rexpr.rhs, module, ptr_map, builder);
-            if (node->rexpr.op == lt) {
-                return LLVMBuildICmp(builder, LLVMIntSLT, lhs, rhs, "");
+        case flat_rexpr: {
+            if (ast->data[node] == lt) {
+                return LLVMBuildICmp(builder, LLVMIntSLT, operands[0], operands[1], "");
             }
-            else if (node->rexpr.op == gt) {
-                return LLVMBuildICmp(builder, LLVMIntSGT, lhs, rhs, "");
+            else if (ast->data[node] == gt) {
+                return LLVMBuildICmp(builder, LLVMIntSGT, operands[0], operands[1], "");
             }
-            else if (node->rexpr.op == le) {
-                return LLVMBuildICmp(builder, LLVMIntSLE, lhs, rhs, "");
+            else if (ast->data[node] == le) {
+                return LLVMBuildICmp(builder, LLVMIntSLE, operands[0], operands[1], "");
             }
-            else if (node->rexpr.op == ge) {
-                return LLVMBuildICmp(builder, LLVMIntSGE, lhs, rhs, "");
+            else if (ast->data[node] == ge) {
+                return LLVMBuildICmp(builder, LLVMIntSGE, operands[0], operands[1], "");
             }
             else {
-                return LLVMBuildICmp(builder, LLVMIntEQ, lhs, rhs, "");
+                return LLVMBuildICmp(builder, LLVMIntEQ, operands[0], operands[1], "");
             }
-            break;
-
         }
         // special edge case: since a 'call_stmt' is parsed as an expression, call 
         // instructions are built here
-        case ast_stmt: {
+        case flat_call: {
 
-                // note: no need to check for 'ast_stmt->type' since the only time this function gets called
-                // on an ast_stmt is after verifying it is a call_stmt
+                // functions defined in the program are declared in this module on first use (see generate())
+                if (ast->data[node] != NAME_PRINT && ast->data[node] != NAME_READ) {
+                    LLVMValueRef fn = getUserFunction(module, getName(ast->data[node]), ast->sizes[node] > 1);
+                    int num_params = ast->sizes[node] > 1 ? 1 : 0;
+                    return LLVMBuildCall2(builder, LLVMGlobalGetValueType(fn), fn, operands, num_params, "");
+                }
 
-                // if called function takes no parameters, it must be 'read()', otherwise it is 'print()'
-                if (node->stmt.call.param == NULL) {
+                // otherwise, if called function takes no parameters, it must be 'read()', otherwise it is 'print()'
+                if (ast->sizes[node] == 1) {
                     LLVMValueRef fn = LLVMGetNamedFunction(module, "read");
                     LLVMTypeRef read_param_types[] = {};
-                    LLVMTypeRef read_func_type = LLVMFunctionType(LLVMInt32Type(), read_param_types, 0, 0);
+                    LLVMTypeRef read_func_type = LLVMFunctionType(LLVMInt32TypeInContext(context), read_param_types, 0, 0);
                     return LLVMBuildCall2(builder, read_func_type, fn, NULL, 0, "");
                 }
                 else {
                     LLVMValueRef fn = LLVMGetNamedFunction(module, "print");
                     
-                    LLVMTypeRef print_param_types[] = { LLVMInt32Type() };
-                    LLVMTypeRef print_func_type = LLVMFunctionType(LLVMVoidType(), print_param_types, 1, 0);
-                    
-                    LLVMValueRef *param = (LLVMValueRef *)malloc(sizeof(LLVMValueRef));
-                    param[0] = generate(node->stmt.call.param, module, ptr_map, builder);
-                    LLVMValueRef call = LLVMBuildCall2(builder, print_func_type, fn, param, 1, "");
-                    free(param);
-                    return call;
+                    LLVMTypeRef print_param_types[] = { LLVMInt32TypeInContext(context) };
+                    LLVMTypeRef print_func_type = LLVMFunctionType(LLVMVoidTypeInContext(context), print_param_types, 1, 0);
+                    return LLVMBuildCall2(builder, print_func_type, fn, operands, 1, "");
                 }
             
         }
         // create constant integer LLVMValueRef
-        case ast_cnst: {
-            return LLVMConstInt(LLVMInt32Type(), node->cnst.value, 1);
+        case flat_cnst: {
+            return LLVMConstInt(LLVMInt32TypeInContext(context), ast->data[node], 1);
         }
-        // build load instructions when encountering a variable
-        case ast_var: {
-            LLVMValueRef ptr = ptr_map.at(node->var.name);
-            return LLVMBuildLoad2(builder, LLVMInt32Type(), ptr, "");
-            
+        // a variable is the value it was last given on the way to this block
+        case flat_var: {
+            return readVariable(ssa, ast->slots[node], LLVMGetInsertBlock(builder));
         }
         default: {
             fprintf(stderr, "Error: Invalid node type encountered in IR generator\n");
@@ -301,8 +427,7 @@ LLVMValueRef generate(astNode *node, LLVMModuleRef module, std::unordered_map<st
     }
 }
 
-/* simple cleanup function called after the initial IR has been generated; this eliminates any code that 
-   it is guaranteed to be unreachable (i.e. it comes after a return statement in a basic block) */
+/*********************** see "ir_generator.h" for details ***********************/
 void cleanUpIR(LLVMModuleRef module) {
     for (LLVMValueRef function =  LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
         for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function); basicBlock; basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
@@ -8,6 +8,7 @@
 #define IR_GENERATOR_H
 
 #include "../ast/ast.h"
+#include "../ast/flat_ast.h"
 #include <llvm-c/Core.h>
 
 
@@ -18,6 +19,10 @@
  *      
  *      const char* module_name: a string that will be assigned internally as 
  *      the name of the output LLVMModule
+ *
+ *      LLVMContextRef context: the LLVM context that will own the output module
+ *      and every type and constant created for it. Compiles that run on different
+ *      threads must each use their own context.
  * 
  * Returns:
  *      an LLVMModuleRef that contains unoptimized LLVM IR code corresponding
@@ -29,7 +34,73 @@
  *      The function assumes that the program is semantically correct (i.e. it does 
  *      not perform any validation checks on the AST). 
  */
-LLVMModuleRef generateIR(astNode *root, const char *module_name);
+LLVMModuleRef generateIR(astNode *root, const char *module_name, LLVMContextRef context);
+
+/*
+ * Same as above for a program in flat form (see "flat_ast.h"), whose nodes are visited in the
+ * order they are stored; this is the one the compiler itself uses
+ */
+LLVMModuleRef generateIR(const flatAST *ast, const char *module_name, LLVMContextRef context);
+
+/*
+ * Params: 
+ *      astNode *func_node: an 'ast_func' node of a semantically valid miniC program
+ *      
+ *      const char* module_name: name of the output LLVMModule
+ *
+ *      LLVMContextRef context: the LLVM context that will own the output module
+ * 
+ * Returns:
+ *      an LLVMModuleRef that contains the unoptimized LLVM IR of the function, along with
+ *      declarations of 'print', 'read' and every function it calls
+ * 
+ * Notes: 
+ *      Lets each function of a program be compiled on its own (and, with one context per
+ *      function, on its own thread). The function is generated exactly as generateIR()
+ *      generates it as part of the whole program.
+ */
+LLVMModuleRef generateFunctionIR(astNode *func_node, const char *module_name, LLVMContextRef context);
+
+/*
+ * Same as above for the 'flat_func' node 'func_node' of a program in flat form
+ */
+LLVMModuleRef generateFunctionIR(const flatAST *ast, astIndex func_node, const char *module_name, LLVMContextRef context);
+
+/*
+ * Params: 
+ *      const char* module_name: name of the output LLVMModule
+ *
+ *      LLVMContextRef context: the LLVM context that will own the output module
+ * 
+ * Returns:
+ *      a module holding only the declarations of the extern 'print' and 'read' functions
+ *      that every miniC program starts with; generateIR() and generateFunctionIR() add the
+ *      program's functions to such a module
+ */
+LLVMModuleRef createProgramModule(const char *module_name, LLVMContextRef context);
+
+/*
+ * Params:
+ *      LLVMModuleRef module: a module of a miniC program
+ *      const char *name: name of a function defined in the program
+ *      bool has_param: whether the function takes a parameter
+ *
+ * Returns:
+ *      the function 'name', declared in 'module' first if it is not there yet; functions
+ *      defined in a miniC program return an int and take at most one int
+ */
+LLVMValueRef getUserFunction(LLVMModuleRef module, const char *name, bool has_param);
+
+/*
+ * Params:
+ *      LLVMModuleRef module: a module holding freshly generated IR
+ *
+ * Notes:
+ *      Simple cleanup called after the initial IR has been generated; this eliminates any code
+ *      that is guaranteed to be unreachable (i.e. it comes after a return statement in a
+ *      basic block)
+ */
+void cleanUpIR(LLVMModuleRef module);
 
 
 #endif
@@ -0,0 +1,440 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * lowering.c - implements the steps of the single-pass compile, which emit the LLVM IR of a
+ * miniC program from the parser's rules
+ */
+
+#include "lowering.h"
+#include "ir_generator.h"
+#include "ssa_builder.h"
+#include "../parser/symbol_table.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* blocks of an if statement being lowered; the blocks after its body are only created once
+   it is known whether it has an else body */
+typedef struct {
+    LLVMBasicBlockRef cond_block; // block that ends with the branch on the condition
+    LLVMValueRef cond;
+    LLVMBasicBlockRef if_BB;
+    LLVMBasicBlockRef else_BB; // NULL if there is no else body (yet)
+    LLVMBasicBlockRef final;
+} ifBlocks;
+
+/* blocks of a while loop being lowered */
+typedef struct {
+    LLVMBasicBlockRef check_BB;
+    LLVMBasicBlockRef while_body;
+    LLVMBasicBlockRef final;
+} whileBlocks;
+
+/* stand-in declarations of a function that is called before it is defined, one for the calls
+   without an argument and one for those with one; they are replaced by the function once it
+   is defined */
+typedef struct {
+    LLVMValueRef stand_in[2];
+} forwardCalls;
+
+struct lowering_State {
+    LLVMModuleRef module;
+    LLVMBuilderRef builder;
+    LLVMTypeRef int_type;
+    LLVMValueRef func; // function being lowered
+    bool module_taken; // finishLowering() returned the module
+    std::string error; // the first semantic error found; once set, nothing more is lowered
+
+    // as in isValidAST(): the variables declared in each function/block in scope
+    symbolTable symbols;
+    // as in generateIR(): the values of the variables of the function being lowered, by slot
+    ssaBuilder *ssa;
+
+    std::unordered_map<nameId, bool> functions; // functions defined so far -> whether they take a parameter
+    std::unordered_map<nameId, forwardCalls> forward_calls; // called but not defined yet
+    std::vector<nameId> forward_order; // the functions in 'forward_calls', in the order first called
+
+    std::vector<ifBlocks> open_ifs;
+    std::vector<whileBlocks> open_whiles;
+};
+
+
+/***************************************** FUNCTION HEADERS *****************************************/
+void recordError(loweringState *state, const char *format, nameId name);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "lowering.h" for details ***********************/
+loweringState *createLowering(const char *module_name, LLVMContextRef context) {
+    loweringState *state = new loweringState();
+    state->module = createProgramModule(module_name, context);
+    state->builder = LLVMCreateBuilderInContext(context);
+    state->int_type = LLVMInt32TypeInContext(context);
+    state->func = NULL;
+    state->ssa = createSSABuilder(context);
+    state->module_taken = false;
+    state->functions[NAME_PRINT] = true;
+    state->functions[NAME_READ] = false;
+    return state;
+}
+
+/*********************** see "lowering.h" for details ***********************/
+LLVMModuleRef finishLowering(loweringState *state, FILE *diagnostics) {
+    for (int i = 0; i < state->forward_order.size(); i++) {
+        if (state->forward_calls.count(state->forward_order.at(i))) {
+            recordError(state, "Error: call to undefined function '%s'\n", state->forward_order.at(i));
+        }
+    }
+    if (!state->error.empty()) {
+        fputs(state->error.c_str(), diagnostics);
+        return NULL;
+    }
+    cleanUpIR(state->module);
+    state->module_taken = true;
+    return state->module;
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void freeLowering(loweringState *state) {
+    LLVMDisposeBuilder(state->builder);
+    freeSSABuilder(state->ssa);
+    if (!state->module_taken) {
+        LLVMDisposeModule(state->module);
+    }
+    delete state;
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerFunctionStart(loweringState *state, nameId name, bool has_param, nameId param) {
+    if (state->functions.count(name)) {
+        recordError(state, "Error: function '%s' is defined more than once\n", name);
+    }
+    if (!state->error.empty()) {
+        return;
+    }
+    state->functions[name] = has_param;
+
+    // functions are added to the module as they are defined, so they appear in source order
+    // just as when generateIR() declares them all up front; calls made to this one before its
+    // definition are pointed at it now
+    state->func = getUserFunction(state->module, getName(name), has_param);
+    std::unordered_map<nameId, forwardCalls>::iterator forward = state->forward_calls.find(name);
+    if (forward != state->forward_calls.end()) {
+        if (forward->second.stand_in[has_param ? 0 : 1] != NULL) {
+            recordError(state, "Error: function '%s' called with the wrong number of arguments\n", name);
+            return;
+        }
+        LLVMValueRef stand_in = forward->second.stand_in[has_param ? 1 : 0];
+        LLVMReplaceAllUsesWith(stand_in, state->func);
+        LLVMDeleteFunction(stand_in);
+        state->forward_calls.erase(forward);
+    }
+
+    startSSAFunction(state->ssa);
+    startFunctionScope(&state->symbols);
+    LLVMBasicBlockRef func_block = LLVMAppendBasicBlockInContext(LLVMGetModuleContext(state->module), state->func, "");
+    LLVMPositionBuilderAtEnd(state->builder, func_block);
+    sealBlock(state->ssa, func_block);
+
+    // the parameter is declared like a variable, whose value is the one passed
+    if (has_param) {
+        LLVMValueRef value = LLVMGetParam(state->func, 0);
+        LLVMSetValueName2(value, getName(param), strlen(getName(param)));
+        writeVariable(state->ssa, declareName(&state->symbols, param), func_block, value);
+    }
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerFunctionEnd(loweringState *state) {
+    if (!state->error.empty()) {
+        return;
+    }
+    closeScope(&state->symbols);
+    finishSSAFunction(state->ssa);
+    state->func = NULL;
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerBlockStart(loweringState *state) {
+    if (!state->error.empty()) {
+        return;
+    }
+    openScope(&state->symbols);
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerBlockEnd(loweringState *state) {
+    if (!state->error.empty()) {
+        return;
+    }
+    closeScope(&state->symbols);
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerDecl(loweringState *state, nameId name) {
+    if (!state->error.empty()) {
+        return;
+    }
+    writeVariable(state->ssa, declareName(&state->symbols, name), LLVMGetInsertBlock(state->builder),
+        LLVMConstInt(state->int_type, 0, 1));
+}
+
+/*********************** see "lowering.h" for details ***********************/
+LLVMValueRef lowerVar(loweringState *state, nameId name) {
+    int32_t slot = lowerTarget(state, name);
+    if (slot < 0) {
+        return NULL;
+    }
+    return readVariable(state->ssa, slot, LLVMGetInsertBlock(state->builder));
+}
+
+/*********************** see "lowering.h" for details ***********************/
+int32_t lowerTarget(loweringState *state, nameId name) {
+    if (!state->error.empty()) {
+        return -1;
+    }
+    int32_t slot = lookupName(&state->symbols, name);
+    if (slot < 0) {
+        recordError(state, "Error: variable '%s' used before declared\n", name);
+    }
+    return slot;
+}
+
+/*********************** see "lowering.h" for details ***********************/
+LLVMValueRef lowerConst(loweringState *state, int value) {
+    return LLVMConstInt(state->int_type, value, 1);
+}
+
+/*********************** see "lowering.h" for details ***********************/
+LLVMValueRef lowerNegate(loweringState *state, LLVMValueRef value) {
+    if (!state->error.empty()) {
+        return NULL;
+    }
+    return LLVMBuildSub(state->builder, LLVMConstInt(state->int_type, 0, 1), value, "");
+}
+
+/*********************** see "lowering.h" for details ***********************/
+LLVMValueRef lowerBinary(loweringState *state, op_type op, LLVMValueRef lhs, LLVMValueRef rhs) {
+    if (!state->error.empty()) {
+        return NULL;
+    }
+    if (op == mul) {
+        return LLVMBuildMul(state->builder, lhs, rhs, "");
+    }
+    else if (op == add) {
+        return LLVMBuildAdd(state->builder, lhs, rhs, "");
+    }
+    else if (op == sub) {
+        return LLVMBuildSub(state->builder, lhs, rhs, "");
+    }
+    else {
+        return LLVMBuildSDiv(state->builder, lhs, rhs, "");
+    }
+}
+
+/*********************** see "lowering.h" for details ***********************/
+LLVMValueRef lowerCompare(loweringState *state, rop_type op, LLVMValueRef lhs, LLVMValueRef rhs) {
+    if (!state->error.empty()) {
+        return NULL;
+    }
+    if (op == lt) {
+        return LLVMBuildICmp(state->builder, LLVMIntSLT, lhs, rhs, "");
+    }
+    else if (op == gt) {
+        return LLVMBuildICmp(state->builder, LLVMIntSGT, lhs, rhs, "");
+    }
+    else if (op == le) {
+        return LLVMBuildICmp(state->builder, LLVMIntSLE, lhs, rhs, "");
+    }
+    else if (op == ge) {
+        return LLVMBuildICmp(state->builder, LLVMIntSGE, lhs, rhs, "");
+    }
+    else {
+        return LLVMBuildICmp(state->builder, LLVMIntEQ, lhs, rhs, "");
+    }
+}
+
+/*********************** see "lowering.h" for details ***********************/
+LLVMValueRef lowerCall(loweringState *state, nameId name, LLVMValueRef arg) {
+    if (!state->error.empty()) {
+        return NULL;
+    }
+    LLVMContextRef context = LLVMGetModuleContext(state->module);
+    LLVMValueRef param[] = { arg };
+    int num_params = arg != NULL ? 1 : 0;
+
+    if (name == NAME_READ) {
+        LLVMTypeRef read_func_type = LLVMFunctionType(state->int_type, NULL, 0, 0);
+        return LLVMBuildCall2(state->builder, read_func_type, LLVMGetNamedFunction(state->module, "read"), NULL, 0, "");
+    }
+    if (name == NAME_PRINT) {
+        LLVMTypeRef print_param_types[] = { state->int_type };
+        LLVMTypeRef print_func_type = LLVMFunctionType(LLVMVoidTypeInContext(context), print_param_types, 1, 0);
+        return LLVMBuildCall2(state->builder, print_func_type, LLVMGetNamedFunction(state->module, "print"), param, 1, "");
+    }
+
+    LLVMValueRef fn;
+    std::unordered_map<nameId, bool>::iterator callee = state->functions.find(name);
+    if (callee != state->functions.end()) {
+        if (callee->second != (arg != NULL)) {
+            recordError(state, "Error: function '%s' called with the wrong number of arguments\n", name);
+            return NULL;
+        }
+        fn = LLVMGetNamedFunction(state->module, getName(name));
+    }
+    else {
+        // not defined yet: the call goes to an unnamed stand-in until it is
+        forwardCalls &forward = state->forward_calls[name];
+        if (forward.stand_in[0] == NULL && forward.stand_in[1] == NULL) {
+            state->forward_order.push_back(name);
+        }
+        if (forward.stand_in[num_params] == NULL) {
+            LLVMTypeRef param_types[] = { state->int_type };
+            forward.stand_in[num_params] = LLVMAddFunction(state->module, "",
+                LLVMFunctionType(state->int_type, param_types, num_params, 0));
+        }
+        fn = forward.stand_in[num_params];
+    }
+    return LLVMBuildCall2(state->builder, LLVMGlobalGetValueType(fn), fn, param, num_params, "");
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerAssign(loweringState *state, int32_t target, LLVMValueRef value) {
+    if (!state->error.empty()) {
+        return;
+    }
+    writeVariable(state->ssa, target, LLVMGetInsertBlock(state->builder), value);
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerReturn(loweringState *state, LLVMValueRef value) {
+    if (!state->error.empty()) {
+        return;
+    }
+    LLVMBuildRet(state->builder, value);
+    markReturned(state->ssa, LLVMGetInsertBlock(state->builder));
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerIfStart(loweringState *state, LLVMValueRef cond) {
+    if (!state->error.empty()) {
+        return;
+    }
+    ifBlocks blocks;
+    blocks.cond_block = LLVMGetInsertBlock(state->builder);
+    blocks.cond = cond;
+    blocks.if_BB = LLVMAppendBasicBlockInContext(LLVMGetModuleContext(state->module), state->func, "");
+    blocks.else_BB = NULL;
+    blocks.final = NULL;
+    state->open_ifs.push_back(blocks);
+    addPredecessor(state->ssa, blocks.if_BB, blocks.cond_block);
+    sealBlock(state->ssa, blocks.if_BB);
+
+    // the branch on the condition is added once its targets exist
+    LLVMPositionBuilderAtEnd(state->builder, blocks.if_BB);
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerElse(loweringState *state) {
+    if (!state->error.empty()) {
+        return;
+    }
+    ifBlocks &blocks = state->open_ifs.back();
+    LLVMContextRef context = LLVMGetModuleContext(state->module);
+    LLVMBasicBlockRef body_end = LLVMGetInsertBlock(state->builder);
+
+    // generateIR() creates these before the if body's blocks, so they are moved up to match
+    blocks.else_BB = LLVMAppendBasicBlockInContext(context, state->func, "");
+    blocks.final = LLVMAppendBasicBlockInContext(context, state->func, "");
+    LLVMMoveBasicBlockAfter(blocks.else_BB, blocks.if_BB);
+    LLVMMoveBasicBlockAfter(blocks.final, blocks.else_BB);
+
+    LLVMPositionBuilderAtEnd(state->builder, blocks.cond_block);
+    LLVMBuildCondBr(state->builder, blocks.cond, blocks.if_BB, blocks.else_BB);
+    LLVMPositionBuilderAtEnd(state->builder, body_end);
+    LLVMBuildBr(state->builder, blocks.final);
+    addPredecessor(state->ssa, blocks.else_BB, blocks.cond_block);
+    sealBlock(state->ssa, blocks.else_BB);
+    addPredecessor(state->ssa, blocks.final, body_end);
+    LLVMPositionBuilderAtEnd(state->builder, blocks.else_BB);
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerIfEnd(loweringState *state) {
+    if (!state->error.empty()) {
+        return;
+    }
+    ifBlocks blocks = state->open_ifs.back();
+    state->open_ifs.pop_back();
+
+    LLVMBasicBlockRef body_end = LLVMGetInsertBlock(state->builder);
+    if (blocks.else_BB == NULL) {
+        blocks.final = LLVMAppendBasicBlockInContext(LLVMGetModuleContext(state->module), state->func, "");
+        LLVMMoveBasicBlockAfter(blocks.final, blocks.if_BB);
+
+        LLVMPositionBuilderAtEnd(state->builder, blocks.cond_block);
+        LLVMBuildCondBr(state->builder, blocks.cond, blocks.if_BB, blocks.final);
+        addPredecessor(state->ssa, blocks.final, blocks.cond_block);
+        LLVMPositionBuilderAtEnd(state->builder, body_end);
+    }
+    LLVMBuildBr(state->builder, blocks.final);
+    addPredecessor(state->ssa, blocks.final, body_end);
+    sealBlock(state->ssa, blocks.final);
+    LLVMPositionBuilderAtEnd(state->builder, blocks.final);
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerWhileStart(loweringState *state) {
+    if (!state->error.empty()) {
+        return;
+    }
+    LLVMContextRef context = LLVMGetModuleContext(state->module);
+    whileBlocks blocks;
+    blocks.check_BB = LLVMAppendBasicBlockInContext(context, state->func, "");
+    blocks.while_body = LLVMAppendBasicBlockInContext(context, state->func, "");
+    blocks.final = LLVMAppendBasicBlockInContext(context, state->func, "");
+    state->open_whiles.push_back(blocks);
+
+    LLVMBuildBr(state->builder, blocks.check_BB);
+    addPredecessor(state->ssa, blocks.check_BB, LLVMGetInsertBlock(state->builder));
+    LLVMPositionBuilderAtEnd(state->builder, blocks.check_BB);
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerWhileBody(loweringState *state, LLVMValueRef cond) {
+    if (!state->error.empty()) {
+        return;
+    }
+    whileBlocks &blocks = state->open_whiles.back();
+    LLVMBuildCondBr(state->builder, cond, blocks.while_body, blocks.final);
+    addPredecessor(state->ssa, blocks.while_body, blocks.check_BB);
+    sealBlock(state->ssa, blocks.while_body);
+    addPredecessor(state->ssa, blocks.final, blocks.check_BB);
+    sealBlock(state->ssa, blocks.final);
+    LLVMPositionBuilderAtEnd(state->builder, blocks.while_body);
+}
+
+/*********************** see "lowering.h" for details ***********************/
+void lowerWhileEnd(loweringState *state) {
+    if (!state->error.empty()) {
+        return;
+    }
+    whileBlocks blocks = state->open_whiles.back();
+    state->open_whiles.pop_back();
+    LLVMBuildBr(state->builder, blocks.check_BB);
+    addPredecessor(state->ssa, blocks.check_BB, LLVMGetInsertBlock(state->builder));
+    sealBlock(state->ssa, blocks.check_BB);
+    LLVMPositionBuilderAtEnd(state->builder, blocks.final);
+}
+
+/* keeps the error 'format' (with the name 'name' in it) if it is the first one found */
+void recordError(loweringState *state, const char *format, nameId name) {
+    if (!state->error.empty()) {
+        return;
+    }
+    char message[256];
+    snprintf(message, sizeof(message), format, getName(name));
+    state->error = message;
+}
@@ -0,0 +1,131 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * lowering.h - defines the steps of the single-pass compile, in which the parser's rules check
+ * a miniC program and emit its LLVM IR as they are reduced, without ever building an AST
+ */
+
+#ifndef LOWERING_H
+#define LOWERING_H
+
+#include "../ast/ast.h"
+#include "../support/name_table.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <llvm-c/Core.h>
+
+struct lowering_State;
+typedef struct lowering_State loweringState;
+
+/*
+ * Params:
+ *      const char *module_name: name of the output LLVMModule
+ *      LLVMContextRef context: the LLVM context that will own the output module
+ *
+ * Returns:
+ *      a pointer to a newly allocated lowering state, holding a module with the declarations of
+ *      'print' and 'read' (see createProgramModule())
+ *
+ * Notes:
+ *      The parser calls the functions below from its rules, in the order the rules are reduced,
+ *      which is the order generateIR() visits the AST in. Each of them emits exactly the
+ *      instructions and blocks generateIR() emits for the same construct, so the finished
+ *      module is the same as generateIR() would give for the program's AST. The checks of
+ *      isValidAST() are made along the way, with the same error messages. Once one fails, the
+ *      later steps do nothing, so the parse can go on to the end and a syntax error further
+ *      down is reported rather than the semantic one, as when the AST is checked after it is
+ *      parsed; finishLowering() reports the semantic error.
+ */
+loweringState *createLowering(const char *module_name, LLVMContextRef context);
+
+/*
+ * Params:
+ *      loweringState *state: a lowering state whose whole program has been lowered
+ *      FILE *diagnostics: stream the semantic error is reported to, if there is one
+ *
+ * Returns:
+ *      the unoptimized module of the program, which the caller now owns, or NULL if the
+ *      program is not semantically valid (the first error found is printed to 'diagnostics')
+ *
+ * Notes:
+ *      Calls to functions that are never defined are only found here. The state still has to
+ *      be freed.
+ */
+LLVMModuleRef finishLowering(loweringState *state, FILE *diagnostics = stderr);
+
+/*
+ * Frees 'state', along with its module unless finishLowering() returned it
+ */
+void freeLowering(loweringState *state);
+
+/*
+ * Starts the definition of the function 'name', which takes the parameter 'param' if
+ * 'has_param' is TRUE
+ */
+void lowerFunctionStart(loweringState *state, nameId name, bool has_param, nameId param);
+
+/*
+ * Ends the definition of the function started last
+ */
+void lowerFunctionEnd(loweringState *state);
+
+/*
+ * Opens and closes the scope of a block statement nested in a function's body
+ */
+void lowerBlockStart(loweringState *state);
+void lowerBlockEnd(loweringState *state);
+
+/*
+ * Declares the variable 'name' in the innermost scope
+ */
+void lowerDecl(loweringState *state, nameId name);
+
+/*
+ * Returns the value of the variable 'name', which must be declared in an open scope
+ */
+LLVMValueRef lowerVar(loweringState *state, nameId name);
+
+/*
+ * Returns the slot of the variable 'name', for assigning to it, or -1 if it is not declared
+ */
+int32_t lowerTarget(loweringState *state, nameId name);
+
+/*
+ * Return the value of a constant, of '-value', of 'lhs op rhs' and of the comparison
+ * 'lhs op rhs'
+ */
+LLVMValueRef lowerConst(loweringState *state, int value);
+LLVMValueRef lowerNegate(loweringState *state, LLVMValueRef value);
+LLVMValueRef lowerBinary(loweringState *state, op_type op, LLVMValueRef lhs, LLVMValueRef rhs);
+LLVMValueRef lowerCompare(loweringState *state, rop_type op, LLVMValueRef lhs, LLVMValueRef rhs);
+
+/*
+ * Returns the value of a call to the function 'name' (NAME_PRINT, NAME_READ or a function of
+ * the program) with the argument 'arg', or without one if 'arg' is NULL; the function may be
+ * defined further down
+ */
+LLVMValueRef lowerCall(loweringState *state, nameId name, LLVMValueRef arg);
+
+/*
+ * Assign 'value' to the variable in the slot 'target' (from lowerTarget()), and return 'value'
+ * from the function
+ */
+void lowerAssign(loweringState *state, int32_t target, LLVMValueRef value);
+void lowerReturn(loweringState *state, LLVMValueRef value);
+
+/*
+ * An if statement is lowered by lowerIfStart() once its condition 'cond' is reduced, then
+ * lowerElse() once its body is (only if it has an else body), and lowerIfEnd() at its end
+ */
+void lowerIfStart(loweringState *state, LLVMValueRef cond);
+void lowerElse(loweringState *state);
+void lowerIfEnd(loweringState *state);
+
+/*
+ * A while loop is lowered by lowerWhileStart() before its condition is reduced, then
+ * lowerWhileBody() with the condition 'cond', and lowerWhileEnd() after its body
+ */
+void lowerWhileStart(loweringState *state);
+void lowerWhileBody(loweringState *state, LLVMValueRef cond);
+void lowerWhileEnd(loweringState *state);
+
+#endif
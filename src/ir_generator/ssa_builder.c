@@ -0,0 +1,297 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * ssa_builder.c - implements the direct construction of SSA form for the IR generator and the
+ * single-pass lowering
+ */
+
+#include "ssa_builder.h"
+#include <stddef.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* a block of the function being built */
+typedef struct {
+    LLVMBasicBlockRef block;
+    std::vector<int> preds; // ids of the predecessors, in the order they were added
+    bool sealed; // every predecessor is known
+    bool returned; // the block ends with a return
+    LLVMValueRef last_phi; // new phis go after it, so they stay in the order they are created
+    std::vector<std::pair<int32_t, LLVMValueRef>> incomplete; // (slot, phi) created before sealing
+} ssaBlock;
+
+/* a phi whose operands are yet to be read from the predecessors of its block */
+typedef struct {
+    LLVMValueRef phi;
+    int block;
+    int32_t slot;
+} pendingPhi;
+
+struct ssa_Builder {
+    LLVMBuilderRef phi_builder;
+    LLVMTypeRef int_type;
+    LLVMValueRef zero;
+    std::vector<ssaBlock> blocks;
+    std::unordered_map<LLVMBasicBlockRef, int> block_ids; // index of each block in 'blocks'
+    std::unordered_map<uint64_t, LLVMValueRef> defs; // (block id, slot) -> value at its end
+    std::vector<LLVMValueRef> phis; // every phi created for the function, in order
+    std::vector<pendingPhi> pending;
+    std::vector<int> path; // blocks passed by the current lookup
+};
+
+/***************************************** FUNCTION HEADERS *****************************************/
+int getBlockId(ssaBuilder *ssa, LLVMBasicBlockRef block);
+uint64_t getDefKey(int block, int32_t slot);
+LLVMValueRef lookBack(ssaBuilder *ssa, int32_t slot, int block);
+LLVMValueRef createPhi(ssaBuilder *ssa, int block);
+void completePhis(ssaBuilder *ssa);
+LLVMValueRef getTrivialValue(ssaBuilder *ssa, std::unordered_map<LLVMValueRef, LLVMValueRef> &replaced, LLVMValueRef phi);
+LLVMValueRef getReplacement(std::unordered_map<LLVMValueRef, LLVMValueRef> &replaced, LLVMValueRef value);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "ssa_builder.h" for details ***********************/
+ssaBuilder *createSSABuilder(LLVMContextRef context) {
+    ssaBuilder *ssa = new ssaBuilder();
+    ssa->phi_builder = LLVMCreateBuilderInContext(context);
+    ssa->int_type = LLVMInt32TypeInContext(context);
+    ssa->zero = LLVMConstInt(ssa->int_type, 0, 1);
+    return ssa;
+}
+
+/*********************** see "ssa_builder.h" for details ***********************/
+void freeSSABuilder(ssaBuilder *ssa) {
+    LLVMDisposeBuilder(ssa->phi_builder);
+    delete ssa;
+}
+
+/*********************** see "ssa_builder.h" for details ***********************/
+void startSSAFunction(ssaBuilder *ssa) {
+    ssa->blocks.clear();
+    ssa->block_ids.clear();
+    ssa->defs.clear();
+    ssa->phis.clear();
+    ssa->pending.clear();
+}
+
+/*********************** see "ssa_builder.h" for details ***********************/
+void finishSSAFunction(ssaBuilder *ssa) {
+    // a trivial phi is only recorded as replaced while the others are checked, and every use is
+    // rewritten once at the end: replacing each one as it is found would move the uses gathered
+    // by a chain of them (such as the checks of nested loops) once per link
+    std::unordered_map<LLVMValueRef, LLVMValueRef> replaced;
+    std::vector<LLVMValueRef> worklist(ssa->phis.rbegin(), ssa->phis.rend());
+    bool removing = true;
+    while (removing) {
+        while (!worklist.empty()) {
+            LLVMValueRef phi = worklist.back();
+            worklist.pop_back();
+            if (replaced.count(phi)) {
+                continue;
+            }
+            LLVMValueRef same = getTrivialValue(ssa, replaced, phi);
+            if (same == NULL) {
+                continue;
+            }
+            replaced[phi] = same;
+
+            // removing it may have left the phis that use it with a single other value
+            for (LLVMUseRef use = LLVMGetFirstUse(phi); use; use = LLVMGetNextUse(use)) {
+                LLVMValueRef user = LLVMGetUser(use);
+                if (user != phi && LLVMIsAPHINode(user)) {
+                    worklist.push_back(user);
+                }
+            }
+        }
+
+        // a phi that only uses a removed phi through one it replaced is not reached above, so
+        // the remaining phis are checked again until none of them is trivial
+        removing = false;
+        for (int i = 0; i < ssa->phis.size(); i++) {
+            LLVMValueRef phi = ssa->phis.at(i);
+            if (!replaced.count(phi) && getTrivialValue(ssa, replaced, phi) != NULL) {
+                worklist.push_back(phi);
+                removing = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < ssa->phis.size(); i++) {
+        LLVMValueRef phi = ssa->phis.at(i);
+        if (replaced.count(phi)) {
+            LLVMReplaceAllUsesWith(phi, getReplacement(replaced, phi));
+        }
+    }
+    for (int i = 0; i < ssa->phis.size(); i++) {
+        if (replaced.count(ssa->phis.at(i))) {
+            LLVMInstructionEraseFromParent(ssa->phis.at(i));
+        }
+    }
+    startSSAFunction(ssa);
+}
+
+/*********************** see "ssa_builder.h" for details ***********************/
+void addPredecessor(ssaBuilder *ssa, LLVMBasicBlockRef block, LLVMBasicBlockRef pred) {
+    int pred_id = getBlockId(ssa, pred);
+    if (ssa->blocks.at(pred_id).returned) {
+        return;
+    }
+    int id = getBlockId(ssa, block);
+    ssa->blocks.at(id).preds.push_back(pred_id);
+}
+
+/*********************** see "ssa_builder.h" for details ***********************/
+void sealBlock(ssaBuilder *ssa, LLVMBasicBlockRef block) {
+    int id = getBlockId(ssa, block);
+    ssaBlock &sealed = ssa->blocks.at(id);
+    sealed.sealed = true;
+    for (int i = 0; i < sealed.incomplete.size(); i++) {
+        pendingPhi pending = {sealed.incomplete.at(i).second, id, sealed.incomplete.at(i).first};
+        ssa->pending.push_back(pending);
+    }
+    sealed.incomplete.clear();
+    completePhis(ssa);
+}
+
+/*********************** see "ssa_builder.h" for details ***********************/
+void markReturned(ssaBuilder *ssa, LLVMBasicBlockRef block) {
+    ssa->blocks.at(getBlockId(ssa, block)).returned = true;
+}
+
+/*********************** see "ssa_builder.h" for details ***********************/
+void writeVariable(ssaBuilder *ssa, int32_t slot, LLVMBasicBlockRef block, LLVMValueRef value) {
+    ssa->defs[getDefKey(getBlockId(ssa, block), slot)] = value;
+}
+
+/*********************** see "ssa_builder.h" for details ***********************/
+LLVMValueRef readVariable(ssaBuilder *ssa, int32_t slot, LLVMBasicBlockRef block) {
+    LLVMValueRef value = lookBack(ssa, slot, getBlockId(ssa, block));
+    completePhis(ssa);
+    return value;
+}
+
+/* returns the index of 'block' in 'ssa->blocks', adding it (unsealed, without predecessors)
+   if it is new */
+int getBlockId(ssaBuilder *ssa, LLVMBasicBlockRef block) {
+    std::pair<std::unordered_map<LLVMBasicBlockRef, int>::iterator, bool> entry = ssa->block_ids.insert(
+        std::pair<LLVMBasicBlockRef, int>(block, ssa->blocks.size()));
+    if (entry.second) {
+        ssaBlock added;
+        added.block = block;
+        added.sealed = false;
+        added.returned = false;
+        added.last_phi = NULL;
+        ssa->blocks.push_back(added);
+    }
+    return entry.first->second;
+}
+
+/* returns the key of the definition of 'slot' in the block with id 'block' in 'ssa->defs' */
+uint64_t getDefKey(int block, int32_t slot) {
+    return ((uint64_t)(uint32_t)block << 32) | (uint32_t)slot;
+}
+
+/* returns the value of 'slot' at the end of the block with id 'block': its definition in the
+   block, or else the one reached by following single predecessors back, or a new phi where a
+   block has several predecessors (whose operands are left on 'ssa->pending') or is not sealed
+   yet. The value is recorded as the definition in every block passed */
+LLVMValueRef lookBack(ssaBuilder *ssa, int32_t slot, int block) {
+    LLVMValueRef value;
+    ssa->path.clear();
+    while (true) {
+        std::unordered_map<uint64_t, LLVMValueRef>::iterator def = ssa->defs.find(getDefKey(block, slot));
+        if (def != ssa->defs.end()) {
+            value = def->second;
+            break;
+        }
+        ssa->path.push_back(block);
+        ssaBlock &current = ssa->blocks.at(block);
+        if (!current.sealed) {
+            value = createPhi(ssa, block);
+            current.incomplete.push_back(std::pair<int32_t, LLVMValueRef>(slot, value));
+            break;
+        }
+        if (current.preds.empty()) {
+            value = ssa->zero;
+            break;
+        }
+        if (current.preds.size() == 1) {
+            block = current.preds.at(0);
+            continue;
+        }
+        value = createPhi(ssa, block);
+        pendingPhi pending = {value, block, slot};
+        ssa->pending.push_back(pending);
+        break;
+    }
+    for (int i = 0; i < ssa->path.size(); i++) {
+        ssa->defs[getDefKey(ssa->path.at(i), slot)] = value;
+    }
+    return value;
+}
+
+/* adds an empty phi after the other phis at the start of the block with id 'block' */
+LLVMValueRef createPhi(ssaBuilder *ssa, int block) {
+    ssaBlock &current = ssa->blocks.at(block);
+    LLVMValueRef next = current.last_phi != NULL ? LLVMGetNextInstruction(current.last_phi)
+                                                 : LLVMGetFirstInstruction(current.block);
+    if (next != NULL) {
+        LLVMPositionBuilderBefore(ssa->phi_builder, next);
+    }
+    else {
+        LLVMPositionBuilderAtEnd(ssa->phi_builder, current.block);
+    }
+    LLVMValueRef phi = LLVMBuildPhi(ssa->phi_builder, ssa->int_type, "");
+    current.last_phi = phi;
+    ssa->phis.push_back(phi);
+    return phi;
+}
+
+/* fills in the operands of the phis on 'ssa->pending', one per predecessor of their block;
+   reading them may create more phis, which are completed in turn */
+void completePhis(ssaBuilder *ssa) {
+    while (!ssa->pending.empty()) {
+        pendingPhi pending = ssa->pending.back();
+        ssa->pending.pop_back();
+        for (int i = 0; i < ssa->blocks.at(pending.block).preds.size(); i++) {
+            int pred = ssa->blocks.at(pending.block).preds.at(i);
+            LLVMValueRef value = lookBack(ssa, pending.slot, pred);
+            LLVMBasicBlockRef pred_block = ssa->blocks.at(pred).block;
+            LLVMAddIncoming(pending.phi, &value, &pred_block, 1);
+        }
+    }
+}
+
+/* returns the only value other than itself that 'phi' merges, once the phis in 'replaced' are
+   replaced, or 0 if it merges nothing but itself (it is then only reached from code that is
+   never run); returns NULL if it merges more than one value */
+LLVMValueRef getTrivialValue(ssaBuilder *ssa, std::unordered_map<LLVMValueRef, LLVMValueRef> &replaced, LLVMValueRef phi) {
+    LLVMValueRef same = NULL;
+    for (unsigned i = 0; i < LLVMCountIncoming(phi); i++) {
+        LLVMValueRef value = getReplacement(replaced, LLVMGetIncomingValue(phi, i));
+        if (value == phi || value == same) {
+            continue;
+        }
+        if (same != NULL) {
+            return NULL;
+        }
+        same = value;
+    }
+    return same != NULL ? same : ssa->zero;
+}
+
+/* returns what 'value' ends up replaced by, following the chain of phis in 'replaced', which is
+   shortened on the way */
+LLVMValueRef getReplacement(std::unordered_map<LLVMValueRef, LLVMValueRef> &replaced, LLVMValueRef value) {
+    LLVMValueRef found = value;
+    std::unordered_map<LLVMValueRef, LLVMValueRef>::iterator entry;
+    while ((entry = replaced.find(found)) != replaced.end()) {
+        found = entry->second;
+    }
+    while ((entry = replaced.find(value)) != replaced.end() && entry->second != found) {
+        value = entry->second;
+        entry->second = found;
+    }
+    return found;
+}
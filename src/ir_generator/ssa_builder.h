@@ -0,0 +1,90 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * ssa_builder.h - defines the direct construction of SSA form used by the IR generator and the
+ * single-pass lowering: every variable of a miniC function lives in SSA values, and phi nodes are
+ * placed at the blocks where definitions meet as the blocks are generated, following Braun et
+ * al., "Simple and Efficient Construction of Static Single Assignment Form" (CC 2013)
+ */
+
+#ifndef SSA_BUILDER_H
+#define SSA_BUILDER_H
+
+#include <stdint.h>
+#include <llvm-c/Core.h>
+
+struct ssa_Builder;
+typedef struct ssa_Builder ssaBuilder;
+
+/*
+ * Params:
+ *      LLVMContextRef context: the context of the module being generated
+ *
+ * Returns:
+ *      a pointer to a newly allocated builder, to be freed with freeSSABuilder()
+ *
+ * Notes:
+ *      Variables are identified by their slot (see "parser/symbol_table.h"). A function is built
+ *      between startSSAFunction() and finishSSAFunction(). As its blocks are generated, the
+ *      caller reports the edges between them with addPredecessor(), and seals each block with
+ *      sealBlock() once all of its predecessors are known. An assignment is recorded with
+ *      writeVariable(), and a use of a variable gets its value from readVariable(), which looks
+ *      back through the predecessors of the block for the definitions that reach it. Where more
+ *      than one does, a phi node is added to the start of the block; in a block that is not
+ *      sealed yet, the phi's operands are only filled in once it is.
+ */
+ssaBuilder *createSSABuilder(LLVMContextRef context);
+
+/*
+ * Frees 'ssa'
+ */
+void freeSSABuilder(ssaBuilder *ssa);
+
+/*
+ * Starts a new function, forgetting every block and definition of the previous one
+ */
+void startSSAFunction(ssaBuilder *ssa);
+
+/*
+ * Ends the function: every block must be sealed. Phi nodes that turned out to merge a single
+ * value (or only themselves) are replaced by that value and removed, along with the phis that
+ * become redundant as a result, so only the phis that merge different values remain.
+ */
+void finishSSAFunction(ssaBuilder *ssa);
+
+/*
+ * Records the edge from 'pred' to 'block'. Blocks must be given their predecessors in the same
+ * order as the phi nodes' operands are to be. An edge from a block that has returned (see
+ * markReturned()) is ignored, since the branch that follows the return is removed by
+ * cleanUpIR().
+ */
+void addPredecessor(ssaBuilder *ssa, LLVMBasicBlockRef block, LLVMBasicBlockRef pred);
+
+/*
+ * Records that every predecessor of 'block' is known, and completes the phis of 'block' that
+ * were created before it was
+ */
+void sealBlock(ssaBuilder *ssa, LLVMBasicBlockRef block);
+
+/*
+ * Records that 'block' ends with a return; what follows the return in it is never run
+ */
+void markReturned(ssaBuilder *ssa, LLVMBasicBlockRef block);
+
+/*
+ * Records that the variable 'slot' holds 'value' from here to the end of 'block' (or to the
+ * next writeVariable() for it)
+ */
+void writeVariable(ssaBuilder *ssa, int32_t slot, LLVMBasicBlockRef block, LLVMValueRef value);
+
+/*
+ * Returns the value of the variable 'slot' at the end of 'block' so far. A variable that is
+ * read where no definition reaches (only in code that is never run) reads as 0.
+ *
+ * Notes:
+ *      Looks back through the predecessors with a loop and a worklist rather than recursion,
+ *      so chains of blocks as long as the nesting of the program are fine. The value found is
+ *      remembered in every block passed, so each block is passed at most once per variable.
+ */
+LLVMValueRef readVariable(ssaBuilder *ssa, int32_t slot, LLVMBasicBlockRef block);
+
+#endif
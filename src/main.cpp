@@ -3,44 +3,286 @@
  * main.c - entry point for the entire compiler, defines required 'main' function
  */
 
-#include "ast/ast.h"
-#include "code_generator/code_generator.h"
-#include "ir_generator/ir_generator.h"
-#include "optimizer/optimizer.h"
-#include "parser/semantic_analysis.h"
-#include <unordered_map>
+#include "driver/driver.h"
+#include "driver/compile_server.h"
+#include "driver/compile_cache.h"
+#include "support/time_report.h"
+#include "parser/scanner.h"
+#include <string>
+#include <vector>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
-#include <llvm-c/Core.h>
-#include <llvm-c/IRReader.h>
-#include <llvm-c/Types.h>
 
-/****************** FUNCTION HEADERS ******************/
-extern astNode *parse(const char*);
-//extern void generateAssembly(LLVMModuleRef module);
-
-/* Takes the filepath of a miniC program as input */
+/* Usage: ./compile [options] [-o file] [-j threads] [--server socket] (miniC-file | IR-file)
+ *        ./compile --batch [options] [-j threads] [--manifest file] [--out-dir dir] [miniC-file ...]
+ *        ./compile --serve socket [-j threads]
+ *
+ * Options:
+ *        -S                     only write the assembly (same as --emit=asm)
+ *        --emit=kinds           comma-separated outputs to write: asm, ll (textual IR), bc (bitcode)
+ *                               or none (default asm,ll); the IR is only printed if it is asked for
+ *        -o file                write the assembly (or the only output requested) to 'file' instead
+ *                               of 'func.s'; '-' writes it to stdout. The IR goes next to it as a
+ *                               '.ll' or '.bc' file
+ *        -ftime-report          print the time taken by each compile phase to stderr
+ *        -ftime-trace=file      write the compile phases to 'file' as Chrome trace-event JSON
+ *        -fmem-report           print the bytes and allocations of each compile phase and the peak
+ *                               resident set size to stderr
+ *        -fmem-report=file      write the same report to 'file' as JSON
+ *        --cache dir            reuse the outputs of earlier compiles of the same source from 'dir'
+ *        --cache-size megabytes evict the least recently used cache entries beyond this size
+ *        --cache-stats          print the cache's hit and miss statistics to stderr
+ *        --incremental          cache the outputs of each function rather than of the whole
+ *                               program, so only changed functions are rebuilt; needs a cache
+ *        --scanner=kind         tokenize with the hand-written scanner ('hand', the default) or
+ *                               the flex one ('flex'); both produce the same tokens, so a compile
+ *                               server always uses the scanner it was started with
+ *        --single-pass          check and lower the program to IR while parsing it instead of
+ *                               building and walking an AST; the output is the same, but the
+ *                               program is compiled as one module (no '-j') and '--incremental'
+ *                               still builds the AST. A compile server uses the pipeline it was
+ *                               started with
+ *
+ * An input ending in '.ll' or '.bc' is read as the LLVM IR (textual or bitcode) of a miniC program,
+ * such as one written with '--emit=ll' or '--emit=bc', and is optimized and compiled from there.
+ *
+ * A single-file compile of a miniC program is sent to the compile server listening on 'socket' when '--server' is
+ * given or the MINIC_COMPILE_SERVER environment variable is set; if no server answers, the file
+ * is compiled in-process as usual. The server uses its own cache, so '--cache' has no effect on a
+ * compile it serves, and a compile that asks for '--cache-stats' is always done in-process. The MINIC_CACHE_DIR environment variable enables the cache
+ * when '--cache' is not given. In a single-file compile, '-j' sets the number of threads the
+ * program's functions are compiled on (one per hardware thread by default).
+ */
 int main(int argc, char** argv) {
-	if (argc == 1) {
+	std::vector<std::string> inputs;
+	bool batch = false;
+	const char *serve_socket = NULL;
+	const char *server_socket = getenv(COMPILE_SERVER_ENV);
+	std::vector<std::string> server_options;
+	bool time_report = false;
+	const char *trace_file = NULL;
+	bool mem_report = false;
+	const char *mem_report_file = NULL;
+	const char *out_dir = NULL;
+	int num_threads = 0;
+	const char *cache_dir = getenv(COMPILE_CACHE_ENV);
+	long cache_size = COMPILE_CACHE_DEFAULT_SIZE;
+	bool cache_stats = false;
+	bool cache_option = false;
+	bool incremental = false;
+	int emit = EMIT_ASM | EMIT_LL;
+	const char *output = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--batch") == 0) {
+			batch = true;
+		}
+		else if (strcmp(argv[i], "--serve") == 0 && has_value) {
+			serve_socket = argv[++i];
+		}
+		else if (strcmp(argv[i], "--server") == 0 && has_value) {
+			server_socket = argv[++i];
+		}
+		else if (strcmp(argv[i], "-S") == 0) {
+			emit = EMIT_ASM;
+		}
+		else if (strncmp(argv[i], "--emit=", strlen("--emit=")) == 0) {
+			emit = parseEmitKinds(argv[i] + strlen("--emit="));
+			if (emit < 0) {
+				return 2;
+			}
+		}
+		else if (!batch && strcmp(argv[i], "-o") == 0 && has_value) {
+			output = argv[++i];
+		}
+		else if (strcmp(argv[i], "-ftime-report") == 0) {
+			time_report = true;
+			server_options.push_back(argv[i]);
+		}
+		else if (strncmp(argv[i], "-ftime-trace=", strlen("-ftime-trace=")) == 0) {
+			trace_file = argv[i] + strlen("-ftime-trace=");
+		}
+		else if (strcmp(argv[i], "-fmem-report") == 0) {
+			mem_report = true;
+		}
+		else if (strncmp(argv[i], "-fmem-report=", strlen("-fmem-report=")) == 0) {
+			mem_report = true;
+			mem_report_file = argv[i] + strlen("-fmem-report=");
+		}
+		else if (strcmp(argv[i], "--cache") == 0 && has_value) {
+			cache_dir = argv[++i];
+			cache_option = true;
+		}
+		else if (strcmp(argv[i], "--cache-size") == 0 && has_value) {
+			cache_size = atol(argv[++i]) * 1024 * 1024;
+		}
+		else if (strcmp(argv[i], "--cache-stats") == 0) {
+			cache_stats = true;
+		}
+		else if (strcmp(argv[i], "--incremental") == 0) {
+			incremental = true;
+		}
+		else if (strcmp(argv[i], "--scanner=hand") == 0) {
+			selectScanner(SCANNER_HAND);
+		}
+		else if (strcmp(argv[i], "--scanner=flex") == 0) {
+			selectScanner(SCANNER_FLEX);
+		}
+		else if (strcmp(argv[i], "--single-pass") == 0) {
+			selectPipeline(PIPELINE_SINGLE_PASS);
+		}
+		else if (strcmp(argv[i], "-j") == 0 && has_value) {
+			num_threads = atoi(argv[++i]);
+		}
+		else if (batch && strcmp(argv[i], "--manifest") == 0 && has_value) {
+			if (!readManifest(argv[++i], inputs)) {
+				return 2;
+			}
+		}
+		else if (batch && strcmp(argv[i], "--out-dir") == 0 && has_value) {
+			out_dir = argv[++i];
+		}
+		else if (argv[i][0] == '-') {
+			fprintf(stderr, "Error: unknown or incomplete option '%s'\n", argv[i]);
+			return 2;
+		}
+		else {
+			inputs.push_back(argv[i]);
+		}
+	}
+
+	if (serve_socket == NULL && inputs.empty()) {
 		fprintf(stderr, "Missing argument: miniC program filepath\n");
 		return 1;
 	}
-	else if (argc > 2) {
+	else if (!batch && inputs.size() > 1) {
 		fprintf(stderr, "Error: too many arguments provided\n");
 		return 2;
 	}
-	const char *filename = argv[1];
-	astNode *root = parse(filename);
-	if (!isValidAST(root)) {
-		freeNode(root);
-		return 3;
+
+	const char *ll_path = (emit & EMIT_LL) ? "func.ll" : NULL;
+	const char *bc_path = (emit & EMIT_BC) ? "func.bc" : NULL;
+	const char *s_path = (emit & EMIT_ASM) ? "func.s" : NULL;
+	std::string derived_ll_path;
+	std::string derived_bc_path;
+	if (output != NULL && emit == EMIT_LL) {
+		ll_path = output;
+	}
+	else if (output != NULL && emit == EMIT_BC) {
+		bc_path = output;
 	}
-	LLVMModuleRef module = generateIR(root, filename);
-	optimize(module);
+	else if (output != NULL && emit == EMIT_ASM) {
+		s_path = output;
+	}
+	else if (output != NULL && emit != 0) {
+		// the assembly goes to 'output', and the IR next to it
+		derived_ll_path = getOutputPath(output, NULL, ".ll");
+		derived_bc_path = getOutputPath(output, NULL, ".bc");
+		if (!(emit & EMIT_ASM) || strcmp(output, "-") == 0 || derived_ll_path == output || derived_bc_path == output) {
+			fprintf(stderr, "Error: '-o %s' cannot hold both the assembly and the IR; use -S or --emit\n", output);
+			return 2;
+		}
+		s_path = output;
+		ll_path = (emit & EMIT_LL) ? derived_ll_path.c_str() : NULL;
+		bc_path = (emit & EMIT_BC) ? derived_bc_path.c_str() : NULL;
+	}
+	std::string emit_option = "--emit=";
+	emit_option += (emit & EMIT_ASM) ? ((emit & EMIT_LL) ? "asm,ll" : "asm") : ((emit & EMIT_LL) ? "ll" : "none");
+	server_options.push_back(emit_option);
 
-	LLVMPrintModuleToFile(module, "func.ll", NULL);
-	generateAssembly(module);
-	freeNode(root);
+	// none of the current options change the generated code; any that do must be added to
+	// 'cache_options' so their outputs are cached separately
+	compileCache *cache = NULL;
+	std::string cache_options;
+	if (cache_dir != NULL && cache_dir[0] != '\0') {
+		cache = createCompileCache(cache_dir, cache_size, cache_options, incremental);
+		if (cache == NULL) {
+			return 2;
+		}
+	}
+	else if (incremental) {
+		fprintf(stderr, "Error: --incremental needs a cache directory (--cache or %s)\n", COMPILE_CACHE_ENV);
+		return 2;
+	}
+
+	if (serve_socket != NULL) {
+		int status = runCompileServer(serve_socket, num_threads, cache);
+		if (cache != NULL) {
+			if (cache_stats) {
+				printCacheStats(cache, stderr);
+			}
+			freeCompileCache(cache);
+		}
+		return status;
+	}
 
+	// traces, memory reports, cache statistics, incremental compiles, bitcode and IR inputs are only
+	// handled in-process
+	if (!batch && server_socket != NULL && server_socket[0] != '\0' && trace_file == NULL && !mem_report && !cache_stats
+			&& !incremental && !(emit & EMIT_BC) && !isIRFile(inputs.at(0).c_str())) {
+		compile_status status;
+		if (compileOnServer(server_socket, inputs.at(0).c_str(), server_options, ll_path, s_path, &status)) {
+			// the server compiles through its own cache (the one it was started with), if any
+			if (cache != NULL) {
+				if (cache_option) {
+					fprintf(stderr, "Note: '%s' was compiled on the server, so --cache was not used\n", inputs.at(0).c_str());
+				}
+				freeCompileCache(cache);
+			}
+			return status == COMPILE_OK ? 0 : 3;
+		}
+	}
+
+	timeReport *report = NULL;
+	if (time_report || trace_file != NULL || mem_report) {
+		report = createTimeReport();
+	}
+	if (mem_report) {
+		enableMemoryAccounting();
+	}
+
+	bool failed;
+	if (batch) {
+		failed = compileBatch(inputs, out_dir, emit, num_threads, report, cache) != 0;
+	}
+	else {
+		failed = compileFile(inputs.at(0).c_str(), ll_path, bc_path, s_path, report, cache, num_threads) != COMPILE_OK;
+	}
+
+	if (report != NULL) {
+		if (time_report) {
+			printTimeReport(report, stderr);
+		}
+		if (trace_file != NULL && !writeChromeTrace(report, trace_file)) {
+			failed = true;
+		}
+		if (mem_report && mem_report_file == NULL) {
+			printMemoryReport(report, stderr);
+		}
+		if (mem_report_file != NULL && !writeMemoryReport(report, mem_report_file)) {
+			failed = true;
+		}
+		freeTimeReport(report);
+	}
+
+	if (cache != NULL) {
+		if (incremental) {
+			long reused;
+			long rebuilt;
+			getFunctionCounts(cache, &reused, &rebuilt);
+			fprintf(stderr, "Incremental compile: %ld function(s) reused, %ld rebuilt\n", reused, rebuilt);
+		}
+		if (cache_stats) {
+			printCacheStats(cache, stderr);
+		}
+		freeCompileCache(cache);
+	}
+
+	if (failed) {
+		return 3;
+	}
 	return 0;
 }
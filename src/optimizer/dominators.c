@@ -0,0 +1,131 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * dominators.c - computes the dominator tree and dominance frontiers of an LLVM function
+ */
+
+#include "dominators.h"
+#include <utility>
+
+/***************************************** FUNCTION HEADERS *****************************************/
+void orderBlocks(dominatorTree *tree, LLVMValueRef function);
+int intersect(dominatorTree *tree, int first, int second);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "dominators.h" for details ***********************/
+dominatorTree *buildDominatorTree(LLVMValueRef function) {
+    dominatorTree *tree = new dominatorTree();
+    orderBlocks(tree, function);
+    int num_blocks = tree->blocks.size();
+
+    // predecessors, counting only the edges from reachable blocks
+    tree->preds.resize(num_blocks);
+    for (int i = 0; i < num_blocks; i++) {
+        LLVMValueRef terminator = LLVMGetBasicBlockTerminator(tree->blocks.at(i));
+        for (unsigned j = 0; j < LLVMGetNumSuccessors(terminator); j++) {
+            tree->preds.at(tree->ids.at(LLVMGetSuccessor(terminator, j))).push_back(i);
+        }
+    }
+
+    // immediate dominators: in reverse postorder every block but the entry has a predecessor that
+    // comes before it, so each sweep refines them from the ones already found until none changes
+    tree->idoms.assign(num_blocks, -1);
+    tree->idoms.at(0) = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 1; i < num_blocks; i++) {
+            int idom = -1;
+            for (int j = 0; j < tree->preds.at(i).size(); j++) {
+                int pred = tree->preds.at(i).at(j);
+                if (tree->idoms.at(pred) == -1) {
+                    continue;
+                }
+                idom = idom == -1 ? pred : intersect(tree, pred, idom);
+            }
+            if (tree->idoms.at(i) != idom) {
+                tree->idoms.at(i) = idom;
+                changed = true;
+            }
+        }
+    }
+    tree->children.resize(num_blocks);
+    for (int i = 1; i < num_blocks; i++) {
+        tree->children.at(tree->idoms.at(i)).push_back(i);
+    }
+
+    // a join block is in the frontier of each block that dominates one of its predecessors but
+    // not the join itself: those on the way up the tree from each predecessor to its idom
+    tree->frontiers.resize(num_blocks);
+    for (int i = 0; i < num_blocks; i++) {
+        if (tree->preds.at(i).size() < 2) {
+            continue;
+        }
+        for (int j = 0; j < tree->preds.at(i).size(); j++) {
+            int runner = tree->preds.at(i).at(j);
+            while (runner != tree->idoms.at(i)) {
+                std::vector<int> &frontier = tree->frontiers.at(runner);
+                if (!frontier.empty() && frontier.back() == i) {
+                    break; // reached from an earlier predecessor, as is the rest of the way up
+                }
+                frontier.push_back(i);
+                runner = tree->idoms.at(runner);
+            }
+        }
+    }
+    return tree;
+}
+
+/*********************** see "dominators.h" for details ***********************/
+void freeDominatorTree(dominatorTree *tree) {
+    delete tree;
+}
+
+/* fills in 'tree->blocks' with the blocks of 'function' reachable from its entry, in reverse
+   postorder, and 'tree->ids' with their numbers; the depth-first search keeps its own stack of
+   the blocks being visited and the next successor of each to follow */
+void orderBlocks(dominatorTree *tree, LLVMValueRef function) {
+    std::vector<LLVMBasicBlockRef> postorder;
+    std::unordered_map<LLVMBasicBlockRef, bool> visited;
+    std::vector<std::pair<LLVMBasicBlockRef, unsigned>> stack;
+
+    LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(function);
+    visited[entry] = true;
+    stack.push_back(std::pair<LLVMBasicBlockRef, unsigned>(entry, 0));
+    while (!stack.empty()) {
+        LLVMBasicBlockRef bb = stack.back().first;
+        LLVMValueRef terminator = LLVMGetBasicBlockTerminator(bb);
+        unsigned next = stack.back().second;
+        if (next == LLVMGetNumSuccessors(terminator)) {
+            postorder.push_back(bb);
+            stack.pop_back();
+            continue;
+        }
+        stack.back().second += 1;
+        LLVMBasicBlockRef successor = LLVMGetSuccessor(terminator, next);
+        if (!visited[successor]) {
+            visited[successor] = true;
+            stack.push_back(std::pair<LLVMBasicBlockRef, unsigned>(successor, 0));
+        }
+    }
+
+    tree->blocks.assign(postorder.rbegin(), postorder.rend());
+    for (int i = 0; i < tree->blocks.size(); i++) {
+        tree->ids[tree->blocks.at(i)] = i;
+    }
+}
+
+/* returns the nearest common dominator of the blocks 'first' and 'second', walking up the idoms
+   found so far; a dominator always comes earlier in reverse postorder */
+int intersect(dominatorTree *tree, int first, int second) {
+    while (first != second) {
+        while (first > second) {
+            first = tree->idoms.at(first);
+        }
+        while (second > first) {
+            second = tree->idoms.at(second);
+        }
+    }
+    return first;
+}
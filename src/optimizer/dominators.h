@@ -0,0 +1,47 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * dominators.h - defines the dominator tree and dominance frontiers of an LLVM function, computed
+ * with the iterative algorithm of Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+ */
+
+#ifndef DOMINATORS_H
+#define DOMINATORS_H
+
+#include <unordered_map>
+#include <vector>
+#include <llvm-c/Core.h>
+
+/*
+ * The dominator tree of a function. Blocks are numbered by their position in reverse postorder
+ * from the entry block, which is 0; blocks that cannot be reached from the entry are left out.
+ */
+typedef struct {
+    std::vector<LLVMBasicBlockRef> blocks; // the reachable blocks, in reverse postorder
+    std::unordered_map<LLVMBasicBlockRef, int> ids; // number of each reachable block
+    std::vector<std::vector<int>> preds; // reachable predecessors of each block, once per edge
+    std::vector<int> idoms; // immediate dominator of each block; the entry is its own
+    std::vector<std::vector<int>> children; // blocks each block immediately dominates
+    std::vector<std::vector<int>> frontiers; // dominance frontier of each block, without repeats
+} dominatorTree;
+
+/*
+ * Params:
+ *      LLVMValueRef function: a function with a body, each of whose blocks ends with a terminator
+ *
+ * Returns:
+ *      a pointer to a newly allocated dominatorTree of 'function', to be freed with
+ *      freeDominatorTree()
+ *
+ * Notes:
+ *      The blocks are ordered without recursion, so the depth of nesting is only bounded by
+ *      memory. The tree describes the function as it is when it is built and is not updated
+ *      when blocks are added or removed.
+ */
+dominatorTree *buildDominatorTree(LLVMValueRef function);
+
+/*
+ * Frees 'tree'
+ */
+void freeDominatorTree(dominatorTree *tree);
+
+#endif
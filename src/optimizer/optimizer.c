@@ -5,17 +5,23 @@
  */
 
 #include "optimizer.h"
+#include "dominators.h"
 #include <stdio.h>
+#include <string>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <deque>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 #include <llvm-c/Core.h>
 
 using namespace std;
 
 /***************************************** FUNCTION HEADERS *****************************************/
+bool isPromotable(LLVMValueRef alloca);
+bool isRemovable(LLVMValueRef inst);
 void removeKills(LLVMValueRef inst, std::unordered_set<LLVMValueRef> &inst_set);
 void addKills(LLVMValueRef inst, LLVMBasicBlockRef bb, std::unordered_set<LLVMValueRef> &stores, 
 					std::unordered_map<LLVMBasicBlockRef, std::unordered_set<LLVMValueRef>> &KILL_set);
@@ -27,8 +33,243 @@ std::unordered_set<LLVMValueRef> set_difference(std::unordered_set<LLVMValueRef>
 /***************************************** IMPLEMENTATION *****************************************/
 
 /*********************** see "optimizer.h" for details ***********************/
-bool eliminateCommonSubExpressions(LLVMValueRef function) {
-	bool is_changed = false; 
+bool promoteAllocas(LLVMValueRef function, int *num_changed) {
+	int changed = 0;
+
+	std::vector<LLVMValueRef> allocas;
+	std::unordered_map<LLVMValueRef, int> alloca_ids;
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		for (LLVMValueRef instruction = LLVMGetFirstInstruction(bb); instruction; instruction = LLVMGetNextInstruction(instruction)) {
+			if (LLVMIsAAllocaInst(instruction) && isPromotable(instruction)) {
+				alloca_ids[instruction] = allocas.size();
+				allocas.push_back(instruction);
+			}
+		}
+	}
+	if (allocas.empty()) {
+		if (num_changed != NULL) {
+			*num_changed = 0;
+		}
+		return false;
+	}
+	int num_allocas = allocas.size();
+	dominatorTree *tree = buildDominatorTree(function);
+	int num_blocks = tree->blocks.size();
+
+	// the blocks that store to each alloca, and those it is live into: the ones that load it before
+	// storing to it, and, going back from them, the predecessors that do not store to it
+	std::vector<std::vector<bool>> def_blocks(num_allocas, std::vector<bool>(num_blocks, false));
+	std::vector<std::vector<bool>> live_in(num_allocas, std::vector<bool>(num_blocks, false));
+	std::vector<std::vector<int>> live_worklists(num_allocas);
+	std::vector<std::vector<int>> def_worklists(num_allocas);
+	std::vector<int> accessed_in(num_allocas, -1); // last block each alloca was accessed in
+	for (int b = 0; b < num_blocks; b++) {
+		for (LLVMValueRef instruction = LLVMGetFirstInstruction(tree->blocks.at(b)); instruction; instruction = LLVMGetNextInstruction(instruction)) {
+			bool is_load = LLVMIsALoadInst(instruction);
+			if (!is_load && !LLVMIsAStoreInst(instruction)) {
+				continue;
+			}
+			std::unordered_map<LLVMValueRef, int>::iterator found = alloca_ids.find(LLVMGetOperand(instruction, is_load ? 0 : 1));
+			if (found == alloca_ids.end()) {
+				continue;
+			}
+			int a = found->second;
+			if (is_load && accessed_in.at(a) != b) {
+				live_in.at(a).at(b) = true;
+				live_worklists.at(a).push_back(b);
+			}
+			if (!is_load && !def_blocks.at(a).at(b)) {
+				def_blocks.at(a).at(b) = true;
+				def_worklists.at(a).push_back(b);
+			}
+			accessed_in.at(a) = b;
+		}
+	}
+
+	// place a phi for each alloca at the iterated dominance frontier of the blocks that store to it,
+	// only where it is live, so none of them is dead
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(LLVMGetTypeContext(LLVMTypeOf(function)));
+	std::vector<std::vector<std::pair<int, LLVMValueRef>>> block_phis(num_blocks);
+	for (int a = 0; a < num_allocas; a++) {
+		std::vector<int> &live_worklist = live_worklists.at(a);
+		while (!live_worklist.empty()) {
+			int b = live_worklist.back();
+			live_worklist.pop_back();
+			for (int i = 0; i < tree->preds.at(b).size(); i++) {
+				int pred = tree->preds.at(b).at(i);
+				if (!def_blocks.at(a).at(pred) && !live_in.at(a).at(pred)) {
+					live_in.at(a).at(pred) = true;
+					live_worklist.push_back(pred);
+				}
+			}
+		}
+
+		std::vector<bool> has_phi(num_blocks, false);
+		std::vector<int> &def_worklist = def_worklists.at(a);
+		while (!def_worklist.empty()) {
+			int b = def_worklist.back();
+			def_worklist.pop_back();
+			for (int i = 0; i < tree->frontiers.at(b).size(); i++) {
+				int join = tree->frontiers.at(b).at(i);
+				if (has_phi.at(join) || !live_in.at(a).at(join)) {
+					continue;
+				}
+				has_phi.at(join) = true;
+
+				// the phis of each alloca follow those of the allocas before it
+				LLVMBasicBlockRef join_block = tree->blocks.at(join);
+				if (block_phis.at(join).empty()) {
+					LLVMPositionBuilderBefore(builder, LLVMGetFirstInstruction(join_block));
+				}
+				else {
+					LLVMPositionBuilderBefore(builder, LLVMGetNextInstruction(block_phis.at(join).back().second));
+				}
+				LLVMValueRef phi = LLVMBuildPhi(builder, LLVMGetAllocatedType(allocas.at(a)), "");
+				block_phis.at(join).push_back(std::pair<int, LLVMValueRef>(a, phi));
+				if (!def_blocks.at(a).at(join)) {
+					def_worklist.push_back(join);
+				}
+			}
+		}
+	}
+	LLVMDisposeBuilder(builder);
+
+	// rename: walk the dominator tree keeping the value each alloca holds, which is its latest
+	// store or phi in a dominating block; loads become that value and the stores go away. Each
+	// block is pushed again to be left, when the values it defined are popped
+	std::vector<std::vector<LLVMValueRef>> values(num_allocas);
+	std::vector<int> defined; // allocas whose values were pushed, in order
+	std::vector<size_t> defined_before(num_blocks);
+	std::vector<std::pair<int, bool>> stack; // (block, whether it is being left)
+	stack.push_back(std::pair<int, bool>(0, false));
+	while (!stack.empty()) {
+		int b = stack.back().first;
+		bool leaving = stack.back().second;
+		stack.pop_back();
+		if (leaving) {
+			while (defined.size() > defined_before.at(b)) {
+				values.at(defined.back()).pop_back();
+				defined.pop_back();
+			}
+			continue;
+		}
+		defined_before.at(b) = defined.size();
+		for (int i = 0; i < block_phis.at(b).size(); i++) {
+			values.at(block_phis.at(b).at(i).first).push_back(block_phis.at(b).at(i).second);
+			defined.push_back(block_phis.at(b).at(i).first);
+		}
+
+		LLVMBasicBlockRef bb = tree->blocks.at(b);
+		LLVMValueRef instruction = LLVMGetFirstInstruction(bb);
+		while (instruction != NULL) {
+			LLVMValueRef next = LLVMGetNextInstruction(instruction);
+			bool is_load = LLVMIsALoadInst(instruction);
+			if (is_load || LLVMIsAStoreInst(instruction)) {
+				std::unordered_map<LLVMValueRef, int>::iterator found = alloca_ids.find(LLVMGetOperand(instruction, is_load ? 0 : 1));
+				if (found != alloca_ids.end()) {
+					int a = found->second;
+					if (is_load) {
+						// a variable read before it is ever assigned is 0, as in the IR generator
+						LLVMValueRef value = values.at(a).empty() ? LLVMConstInt(LLVMTypeOf(instruction), 0, 1) : values.at(a).back();
+						LLVMReplaceAllUsesWith(instruction, value);
+					}
+					else {
+						values.at(a).push_back(LLVMGetOperand(instruction, 0));
+						defined.push_back(a);
+					}
+					changed += 1;
+					LLVMInstructionEraseFromParent(instruction);
+				}
+			}
+			instruction = next;
+		}
+
+		// each edge gives the phis of its successor the values the allocas hold at its end
+		LLVMValueRef terminator = LLVMGetBasicBlockTerminator(bb);
+		for (unsigned i = 0; i < LLVMGetNumSuccessors(terminator); i++) {
+			std::vector<std::pair<int, LLVMValueRef>> &phis = block_phis.at(tree->ids.at(LLVMGetSuccessor(terminator, i)));
+			for (int j = 0; j < phis.size(); j++) {
+				int a = phis.at(j).first;
+				LLVMValueRef value = values.at(a).empty() ? LLVMConstInt(LLVMGetAllocatedType(allocas.at(a)), 0, 1) : values.at(a).back();
+				LLVMAddIncoming(phis.at(j).second, &value, &bb, 1);
+			}
+		}
+
+		stack.push_back(std::pair<int, bool>(b, true));
+		for (int i = tree->children.at(b).size() - 1; i >= 0; i--) {
+			stack.push_back(std::pair<int, bool>(tree->children.at(b).at(i), false));
+		}
+	}
+
+	// the blocks that are never reached still load and store the allocas, and branch to blocks
+	// that may have phis now
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		if (tree->ids.count(bb)) {
+			continue;
+		}
+		LLVMValueRef instruction = LLVMGetFirstInstruction(bb);
+		while (instruction != NULL) {
+			LLVMValueRef next = LLVMGetNextInstruction(instruction);
+			bool is_load = LLVMIsALoadInst(instruction);
+			if ((is_load || LLVMIsAStoreInst(instruction)) && alloca_ids.count(LLVMGetOperand(instruction, is_load ? 0 : 1))) {
+				if (is_load) {
+					LLVMReplaceAllUsesWith(instruction, LLVMConstInt(LLVMTypeOf(instruction), 0, 1));
+				}
+				changed += 1;
+				LLVMInstructionEraseFromParent(instruction);
+			}
+			instruction = next;
+		}
+		LLVMValueRef terminator = LLVMGetBasicBlockTerminator(bb);
+		for (unsigned i = 0; terminator != NULL && i < LLVMGetNumSuccessors(terminator); i++) {
+			std::unordered_map<LLVMBasicBlockRef, int>::iterator successor = tree->ids.find(LLVMGetSuccessor(terminator, i));
+			if (successor == tree->ids.end()) {
+				continue;
+			}
+			std::vector<std::pair<int, LLVMValueRef>> &phis = block_phis.at(successor->second);
+			for (int j = 0; j < phis.size(); j++) {
+				LLVMValueRef value = LLVMConstInt(LLVMGetAllocatedType(allocas.at(phis.at(j).first)), 0, 1);
+				LLVMAddIncoming(phis.at(j).second, &value, &bb, 1);
+			}
+		}
+	}
+
+	for (int a = 0; a < num_allocas; a++) {
+		changed += 1;
+		LLVMInstructionEraseFromParent(allocas.at(a));
+	}
+	freeDominatorTree(tree);
+
+	if (num_changed != NULL) {
+		*num_changed = changed;
+	}
+	return changed > 0;
+}
+
+// returns true if 'alloca' holds a 32-bit integer that is only ever loaded or stored to, so its
+// address never escapes and every access to it is known
+bool isPromotable(LLVMValueRef alloca) {
+	LLVMTypeRef type = LLVMGetAllocatedType(alloca);
+	if (LLVMGetTypeKind(type) != LLVMIntegerTypeKind || LLVMGetIntTypeWidth(type) != 32) {
+		return false;
+	}
+	for (LLVMUseRef use = LLVMGetFirstUse(alloca); use; use = LLVMGetNextUse(use)) {
+		LLVMValueRef user = LLVMGetUser(use);
+		if (LLVMIsALoadInst(user) && LLVMTypeOf(user) == type) {
+			continue;
+		}
+		if (LLVMIsAStoreInst(user) && LLVMGetOperand(user, 1) == alloca && LLVMGetOperand(user, 0) != alloca
+				&& LLVMTypeOf(LLVMGetOperand(user, 0)) == type) {
+			continue;
+		}
+		return false;
+	}
+	return true;
+}
+
+/*********************** see "optimizer.h" for details ***********************/
+bool eliminateCommonSubExpressions(LLVMValueRef function, int *num_changed) {
+	int changed = 0;
 	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
 
 		// loop over all pairs of instructions
@@ -36,8 +277,8 @@ bool eliminateCommonSubExpressions(LLVMValueRef function) {
 			
 			LLVMOpcode first_inst_op = LLVMGetInstructionOpcode(first_inst);
 
-			// ignore 'lloca' instructions
-			if (LLVMIsAAllocaInst(first_inst)) {
+			// ignore 'alloca' instructions, and instructions whose effects go beyond the value they produce
+			if (LLVMIsAAllocaInst(first_inst) || LLVMIsAStoreInst(first_inst) || LLVMIsACallInst(first_inst) || LLVMIsATerminatorInst(first_inst)) {
 				continue;
 			}
 			int num_operands = LLVMGetNumOperands(first_inst);
@@ -69,7 +310,7 @@ bool eliminateCommonSubExpressions(LLVMValueRef function) {
 
 				bool can_replace = true;
 
-				// check if all operands are the same
+				// check if all operands are the same (and, for phi nodes, the blocks they come from)
 				for (int i = 0; i < num_operands; i++) {
 					if (LLVMGetOperand(first_inst, i) != LLVMGetOperand(second_inst, i)) {
 						
@@ -77,10 +318,15 @@ bool eliminateCommonSubExpressions(LLVMValueRef function) {
 
 						break;
 					}
+					if (first_inst_op == LLVMPHI && LLVMGetIncomingBlock(first_inst, i) != LLVMGetIncomingBlock(second_inst, i)) {
+						can_replace = false;
+						break;
+					}
 				}
-				// if so, replace all uses of the second instruction with the first instruction
-				if (can_replace) {
-					is_changed = true;
+				// if so, replace all uses of the second instruction with the first instruction (an instruction
+				// without uses has already been replaced and is left for dead code elimination)
+				if (can_replace && LLVMGetFirstUse(second_inst) != NULL) {
+					changed += 1;
 					LLVMReplaceAllUsesWith(second_inst, first_inst);
 
 				}
@@ -88,44 +334,86 @@ bool eliminateCommonSubExpressions(LLVMValueRef function) {
 			}
 		}
 	}
-	return is_changed;
+	if (num_changed != NULL) {
+		*num_changed = changed;
+	}
+	return changed > 0;
 }
 
 /*********************** see "optimizer.h" for details ***********************/
-bool eliminateDeadCode(LLVMValueRef function) {
-	bool is_changed = false;
+bool eliminateDeadCode(LLVMValueRef function, int *num_changed) {
+	int changed = 0;
+
+	// instructions without uses, in order; erasing one may leave its operands without uses, and
+	// they are removed in the same pass rather than one per fixpoint iteration of the chain
+	std::vector<LLVMValueRef> worklist;
+	std::unordered_set<LLVMValueRef> queued;
 	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
-		LLVMValueRef curr_instruction = LLVMGetFirstInstruction(bb);
-		while (curr_instruction) {
-			// these four instruction types can never be deleted because they might have indirect consequences
-			if (LLVMIsAStoreInst(curr_instruction) || LLVMIsACallInst(curr_instruction) || LLVMIsAAllocaInst(curr_instruction) || LLVMIsATerminatorInst(curr_instruction)) {
-				curr_instruction = LLVMGetNextInstruction(curr_instruction);
-				continue;
-			}
-			LLVMUseRef use = LLVMGetFirstUse(curr_instruction);
-			// check if the instruction is ever used
-			if (use == NULL) {
-				is_changed = true;
-				LLVMValueRef next_instruction = LLVMGetNextInstruction(curr_instruction);
-				LLVMInstructionEraseFromParent(curr_instruction);
-				curr_instruction = next_instruction;
+		for (LLVMValueRef instruction = LLVMGetFirstInstruction(bb); instruction; instruction = LLVMGetNextInstruction(instruction)) {
+			if (isRemovable(instruction) && LLVMGetFirstUse(instruction) == NULL) {
+				worklist.push_back(instruction);
+				queued.insert(instruction);
 			}
-			else {
-				curr_instruction = LLVMGetNextInstruction(curr_instruction);
+		}
+	}
+	for (int i = 0; i < worklist.size(); i++) {
+		LLVMValueRef instruction = worklist.at(i);
+		std::vector<LLVMValueRef> operands;
+		for (int j = 0; j < LLVMGetNumOperands(instruction); j++) {
+			operands.push_back(LLVMGetOperand(instruction, j));
+		}
+		changed += 1;
+		LLVMInstructionEraseFromParent(instruction);
+
+		for (int j = 0; j < operands.size(); j++) {
+			LLVMValueRef op = operands.at(j);
+			if (LLVMIsAInstruction(op) && isRemovable(op) && LLVMGetFirstUse(op) == NULL && queued.insert(op).second) {
+				worklist.push_back(op);
 			}
 		}
 	}
-	return is_changed;
+	if (num_changed != NULL) {
+		*num_changed = changed;
+	}
+	return changed > 0;
+}
+
+// returns true unless 'inst' is one of the four instruction types that can never be deleted because they might
+// have indirect consequences
+bool isRemovable(LLVMValueRef inst) {
+	return !(LLVMIsAStoreInst(inst) || LLVMIsACallInst(inst) || LLVMIsAAllocaInst(inst) || LLVMIsATerminatorInst(inst));
 }
 
 /*********************** see "optimizer.h" for details ***********************/
-bool foldConstants(LLVMValueRef function) {
-	bool is_changed = false;
+bool foldConstants(LLVMValueRef function, int *num_changed) {
+	int changed = 0;
 	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
 		for (LLVMValueRef instruction = LLVMGetFirstInstruction(bb); instruction; instruction = LLVMGetNextInstruction(instruction)) {
 			LLVMOpcode opcode = LLVMGetInstructionOpcode(instruction);
 
-			// constant folding is only possible with multiplication, addition, or subtraction
+			// a phi node that merges the same constant from every predecessor (or itself, around a
+			// loop that never changes it) is that constant
+			if (opcode == LLVMPHI) {
+				LLVMValueRef same = NULL;
+				bool is_all_same = true;
+				for (unsigned i = 0; i < LLVMCountIncoming(instruction); i++) {
+					LLVMValueRef incoming = LLVMGetIncomingValue(instruction, i);
+					if (incoming == instruction) {
+						continue;
+					}
+					if (!LLVMIsAConstantInt(incoming) || (same != NULL && incoming != same)) {
+						is_all_same = false;
+						break;
+					}
+					same = incoming;
+				}
+				if (is_all_same && same != NULL && LLVMGetFirstUse(instruction) != NULL) {
+					changed += 1;
+					LLVMReplaceAllUsesWith(instruction, same);
+				}
+			}
+
+			// otherwise, constant folding is only possible with multiplication, addition, or subtraction
 			if (opcode == LLVMMul || opcode == LLVMAdd || opcode == LLVMSub) {
 				int num_operands = LLVMGetNumOperands(instruction);
 				bool is_all_const = true;
@@ -147,18 +435,21 @@ bool foldConstants(LLVMValueRef function) {
 				else {
 					new_instruction = LLVMConstSub(LLVMGetOperand(instruction, 0), LLVMGetOperand(instruction, 1));
 				}
-				is_changed = true;
+				changed += 1;
 				LLVMReplaceAllUsesWith(instruction, new_instruction); // insert new instruction in place of old
 			}
 		}
 	}
-	return is_changed;
+	if (num_changed != NULL) {
+		*num_changed = changed;
+	}
+	return changed > 0;
 }
 
 /*********************** see "optimizer.h" for details ***********************/
-bool propagateConstants(LLVMValueRef function) {
+bool propagateConstants(LLVMValueRef function, int *num_changed) {
 
-	bool is_changed = false;
+	int changed = 0;
 
 	std::unordered_set<LLVMValueRef> stores; // keep track of all store instructions
 	std::unordered_map<LLVMBasicBlockRef, std::unordered_set<LLVMValueRef>> GEN_set; 
@@ -209,24 +500,40 @@ bool propagateConstants(LLVMValueRef function) {
 	}
 	OUT_set = GEN_set;
 
-	bool change = true;
-	while (change) {
-		change = false;
-		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
-			// update IN set to contain the union of OUT sets corresponding to the current basic block's predecessors
-			for (std::unordered_set<LLVMBasicBlockRef>::iterator iter = pred_map.at(bb).begin(); iter != pred_map.at(bb).end(); iter++) {
-				IN_set.at(bb).insert(OUT_set.at(*iter).begin(), OUT_set.at(*iter).end());
-			}
-
-			// OUT[bb] = union(GEN[bb], IN[bb] - KILL[bb])
-			std::unordered_set<LLVMValueRef> oldout = OUT_set.at(bb);
-			OUT_set.at(bb) = set_union(GEN_set.at(bb), set_difference(IN_set.at(bb), KILL_set.at(bb)));
+	// iterate to a fixpoint with a worklist: a block is visited again only when the OUT set of one
+	// of its predecessors changed. The join block of a nested if or loop comes after the blocks that
+	// branch to it, so sweeping over every block until nothing changes would take one sweep per
+	// level of nesting
+	std::deque<LLVMBasicBlockRef> worklist;
+	std::unordered_set<LLVMBasicBlockRef> in_worklist;
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		worklist.push_back(bb);
+		in_worklist.insert(bb);
+	}
+	while (!worklist.empty()) {
+		LLVMBasicBlockRef bb = worklist.front();
+		worklist.pop_front();
+		in_worklist.erase(bb);
+
+		// update IN set to contain the union of OUT sets corresponding to the current basic block's predecessors
+		for (std::unordered_set<LLVMBasicBlockRef>::iterator iter = pred_map.at(bb).begin(); iter != pred_map.at(bb).end(); iter++) {
+			IN_set.at(bb).insert(OUT_set.at(*iter).begin(), OUT_set.at(*iter).end());
+		}
 
-			// keep looping if OUT set continues to change
-			if (OUT_set.at(bb) != oldout) {
-				change = true;
+		// OUT[bb] = union(GEN[bb], IN[bb] - KILL[bb])
+		std::unordered_set<LLVMValueRef> oldout = OUT_set.at(bb);
+		OUT_set.at(bb) = set_union(GEN_set.at(bb), set_difference(IN_set.at(bb), KILL_set.at(bb)));
+
+		// the successors have to be visited again if the OUT set changed
+		if (OUT_set.at(bb) != oldout) {
+			LLVMValueRef terminator = LLVMGetBasicBlockTerminator(bb);
+			for (int i = 0; i < LLVMGetNumSuccessors(terminator); i++) {
+				LLVMBasicBlockRef successor = LLVMGetSuccessor(terminator, i);
+				if (in_worklist.insert(successor).second) {
+					worklist.push_back(successor);
+				}
 			}
-		} 
+		}
 	}
 
 	// search for load instructions that can be replaced
@@ -278,8 +585,8 @@ bool propagateConstants(LLVMValueRef function) {
 
 				if (can_replace) {
 					to_delete.insert(instruction);
-					LLVMReplaceAllUsesWith(instruction, LLVMConstInt(LLVMInt32Type(), const_val, 1));
-					is_changed = true;
+					LLVMReplaceAllUsesWith(instruction, LLVMConstInt(LLVMTypeOf(instruction), const_val, 1));
+					changed += 1;
 				}
 				
 
@@ -296,7 +603,10 @@ bool propagateConstants(LLVMValueRef function) {
 			iter = next;
 		}
 	}
-	return is_changed;
+	if (num_changed != NULL) {
+		*num_changed = changed;
+	}
+	return changed > 0;
 }
 
 // simple helper function that returns the union of two unordered sets
@@ -375,26 +685,76 @@ void addKills(LLVMValueRef inst, LLVMBasicBlockRef bb, std::unordered_set<LLVMVa
 }
 
 
+// the passes run by each fixpoint iteration of 'optimizeFunction()', in order
+typedef bool (*optimizationPass)(LLVMValueRef function, int *num_changed);
+static const struct {
+	const char *name;
+	optimizationPass run;
+} OPT_PASSES[] = {
+	{ "promoteAllocas", promoteAllocas },
+	{ "propagateConstants", propagateConstants },
+	{ "eliminateCommonSubExpressions", eliminateCommonSubExpressions },
+	{ "foldConstants", foldConstants },
+	{ "eliminateDeadCode", eliminateDeadCode },
+};
+
 /*********************** see "optimizer.h" for details ***********************/
-void optimizeFunction(LLVMValueRef function){
+void optimizeFunction(LLVMValueRef function, timeReport *report){
+	std::string func_phase;
+	timeStamp func_start;
+	if (report != NULL) {
+		size_t name_len;
+		func_phase = std::string("optimize/") + LLVMGetValueName2(function, &name_len);
+		func_start = startTiming();
+	}
+
+	int iterations = 0;
 	bool optimizing = true;
 	while (optimizing) {
-		bool CP = propagateConstants(function);
-		bool CSE = eliminateCommonSubExpressions(function);
-		bool CF = foldConstants(function);
-		bool DC = eliminateDeadCode(function);
-		optimizing = CP || CSE || CF || DC;
+		optimizing = false;
+		iterations += 1;
+
+		std::string iter_phase;
+		timeStamp iter_start;
+		if (report != NULL) {
+			iter_phase = func_phase + "/iteration " + std::to_string(iterations);
+			iter_start = startTiming();
+		}
+
+		// every pass runs in every iteration, even after an earlier one has made a change
+		for (int i = 0; i < sizeof(OPT_PASSES) / sizeof(OPT_PASSES[0]); i++) {
+			timeStamp pass_start;
+			if (report != NULL) {
+				pass_start = startTiming();
+			}
+			int num_changed;
+			if (OPT_PASSES[i].run(function, &num_changed)) {
+				optimizing = true;
+			}
+			if (report != NULL) {
+				recordPhase(report, (iter_phase + "/" + OPT_PASSES[i].name).c_str(), pass_start, "changed", num_changed);
+			}
+		}
+		if (report != NULL) {
+			recordPhase(report, iter_phase.c_str(), iter_start);
+		}
+	}
+	if (report != NULL) {
+		recordPhase(report, func_phase.c_str(), func_start, "fixpoint iterations", iterations);
 	}
-	
 }
 
 /*********************** see "optimizer.h" for details ***********************/
-void optimize(LLVMModuleRef module){
+void optimize(LLVMModuleRef module, timeReport *report){
 	for (LLVMValueRef function = LLVMGetFirstFunction(module); 
 			function; 
 			function = LLVMGetNextFunction(function)) {
 
-		optimizeFunction(function);
+		// skip the extern declarations, which have no body to optimize
+		if (LLVMIsDeclaration(function)) {
+			continue;
+		}
+		optimizeFunction(function, report);
 		
  	}
 	
@@ -8,6 +8,7 @@
 #ifndef OPTIMIZER_H
 #define OPTIMIZER_H
 
+#include "../support/time_report.h"
 #include <llvm-c/Core.h>
 #include <stdbool.h>
 
@@ -20,30 +21,58 @@
  *      the single main function.  
  *
  *      For each of the functions below, it is assumed that the 'LLVMValueRef function' being passed belongs to 
- *      a valid LLVM module, produced by the IR Generator.
+ *      a valid LLVM module, produced by the IR Generator. The IR Generator keeps variables in SSA values
+ *      joined by phi nodes, so 'promoteAllocas()' only finds work in modules whose variables are still
+ *      in memory (such as IR read from a file), and 'propagateConstants()' only in the allocas it could
+ *      not promote.
+ *
+ *      Each of the five optimization passes also takes an optional 'int *num_changed'; when it is not NULL,
+ *      it receives the number of instructions the pass replaced or removed.
  */
 
 
+ /*
+  * Returns:
+  *     TRUE, if any allocas were promoted to SSA values
+  *     FALSE, otherwise
+  *
+  * Notes:
+  *     Promotes every 32-bit integer alloca that is only loaded and stored to (which in miniC is all of
+  *     them) to SSA values: phi nodes are placed at the iterated dominance frontier of the blocks that
+  *     store to it, only where the alloca is live, and the loads are replaced by the value stored last on
+  *     the way down the dominator tree (see "dominators.h"). A load with no store before it reads 0, as a
+  *     declared variable starts at 0 in the IR Generator. The other passes then see through variables
+  *     that hold values other than constants.
+  */
+bool promoteAllocas(LLVMValueRef function, int *num_changed = NULL);
+
  /*
   * Returns:
   *     TRUE, if any common subexpressions were successfully eliminated
   *     FALSE, otherwise
+  *
+  * Notes:
+  *     Two phi nodes are only the same expression if they merge the same values from the same blocks.
   */
-bool eliminateCommonSubExpressions(LLVMValueRef function);
+bool eliminateCommonSubExpressions(LLVMValueRef function, int *num_changed = NULL);
 
  /*
   * Returns:
   *     TRUE, if any constants were successfully folded
   *     FALSE, otherwise
+  *
+  * Notes:
+  *     Besides arithmetic on constants, a phi node whose incoming values are all the same constant
+  *     is replaced by that constant.
   */
-bool foldConstants(LLVMValueRef function);
+bool foldConstants(LLVMValueRef function, int *num_changed = NULL);
 
  /*
   * Returns:
   *     TRUE, if any constants were successfully propagated
   *     FALSE, otherwise
   */
-bool propagateConstants(LLVMValueRef function);
+bool propagateConstants(LLVMValueRef function, int *num_changed = NULL);
 
 
  /*
@@ -51,7 +80,7 @@ bool propagateConstants(LLVMValueRef function);
   *     TRUE, if any dead code was successfully eliminated
   *     FALSE, otherwise
   */
-bool eliminateDeadCode(LLVMValueRef function);
+bool eliminateDeadCode(LLVMValueRef function, int *num_changed = NULL);
 
 
  /*
@@ -59,11 +88,14 @@ bool eliminateDeadCode(LLVMValueRef function);
   *     VOID
   *
   * Notes:
-  *     This function calls all four of the above optimizations in a loop until reaching an iteration
+  *     This function calls all five of the above optimizations, in order, in a loop until reaching an iteration
   *     in which they all return false. In effect, this ensures that all optimization procedures are 
   *     performed as many times as needed in order achieve maximal optimization.
+  *
+  *     If 'report' is not NULL, the time taken by each pass in each iteration, the number of instructions
+  *     each pass changed and the number of fixpoint iterations are recorded in it.
   */
-void optimizeFunction(LLVMValueRef function);
+void optimizeFunction(LLVMValueRef function, timeReport *report = NULL);
 
  /*
   * Returns:
@@ -72,8 +104,8 @@ void optimizeFunction(LLVMValueRef function);
   * Notes:
   *     This function calls 'optimizeFunction()' on each function present within the module. For 
   *     the purposes of a miniC program, it will only call 'optimizeFunction()' once for the single
-  *     user-defined function.
+  *     user-defined function. 'report' is passed on to each call of 'optimizeFunction()'.
   */
-void optimize(LLVMModuleRef module);
+void optimize(LLVMModuleRef module, timeReport *report = NULL);
 
 #endif
\ No newline at end of file
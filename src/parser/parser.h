@@ -0,0 +1,95 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * parser.h - defines the entry points of the miniC parser generated from "parser.y". The
+ * parser and both scanners keep the state of a parse in a context object of its own, so any
+ * number of parses may run at the same time on different threads. The parser either builds
+ * the program's AST or, in the single-pass mode, lowers it straight to LLVM IR.
+ */
+
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "../ast/flat_ast.h"
+#include "../ir_generator/lowering.h"
+#include "scanner.h"
+#include <stdio.h>
+#include <llvm-c/Core.h>
+
+/*
+ * Everything a single parse works on; parse() creates one for each call, and the generated
+ * parser passes it to the scanner and to every rule
+ */
+typedef struct {
+    scannerKind scanner; // the scanner of this parse, chosen by getScanner() when it starts
+    miniScanner hand_scanner; // state of the hand-written scanner, if it is the one in use
+    void *flex_scanner; // state of the flex scanner (a yyscan_t), if it is the one in use
+    flatAST *tree; // the AST being built, or NULL when lowering
+    loweringState *lower; // the IR being emitted when lowering, otherwise NULL
+    FILE *diagnostics; // stream the syntax errors of this parse are reported to
+} parserContext;
+
+/*
+ * The value of a rule: where its subtree starts in the AST being built, or, when lowering,
+ * the value of an expression, the name of a function's parameter or the slot of an assigned
+ * variable
+ */
+typedef union {
+    astIndex node;
+    LLVMValueRef value;
+    nameId name;
+    int32_t slot;
+} ruleValue;
+
+/*
+ * Params:
+ *      const char *filename: path of a miniC program
+ *
+ * Returns:
+ *      a newly allocated flat AST of the program (to be freed with freeFlatAST()), or NULL
+ *      if the file could not be read or contains a syntax error
+ *
+ * Notes:
+ *      Safe to call from several threads at once; identifiers are interned in the
+ *      process-wide name table (see "name_table.h"), which is shared by every parse.
+ */
+flatAST *parse(const char *filename);
+
+/*
+ * Same as above, but reads the miniC program from an open stream (which is left open). The
+ * scanners read their input in place, so the whole stream is read before parsing.
+ */
+flatAST *parse(FILE *fp);
+
+/*
+ * Same as above, but scans the miniC program in place from 'buffer', which holds 'len' bytes
+ * of source followed by two NUL bytes. The source is not copied; the flex scanner writes to
+ * 'buffer' while it runs, so it must be writable and not shared with another parse. Syntax
+ * errors are printed to 'diagnostics'.
+ */
+flatAST *parse(char *buffer, size_t len, FILE *diagnostics = stderr);
+
+/*
+ * Params:
+ *      char *buffer, size_t len: the miniC program, as for parse() above
+ *      const char *module_name: name of the output LLVMModule
+ *      LLVMContextRef context: the LLVM context that will own the output module
+ *      bool *semantic_error: set to TRUE if NULL is returned because the program is not
+ *      semantically valid, and to FALSE otherwise
+ *      FILE *diagnostics: stream the syntax or semantic error is reported to
+ *
+ * Returns:
+ *      the unoptimized LLVM IR of the program, the same module generateIR() gives for the AST
+ *      parse() builds, or NULL if the program contains a syntax error or fails the checks of
+ *      isValidAST()
+ *
+ * Notes:
+ *      Single pass: each rule checks and emits the IR of its construct as it is reduced (see
+ *      "lowering.h"), so no AST is built or walked. The checks and their error messages are
+ *      those of isValidAST(), and a program with a syntax error is only reported as such;
+ *      a program with several semantic errors may have a different one reported first. Safe
+ *      to call from several threads at once, with a context per thread.
+ */
+LLVMModuleRef parseToIR(char *buffer, size_t len, const char *module_name, LLVMContextRef context,
+                        bool *semantic_error, FILE *diagnostics = stderr);
+
+#endif
@@ -2,31 +2,55 @@
  * Dartmouth CS57, Spring 2023
  * parser.y - parses the tokenized "mini_c" input program according to the
  * grammar defined in the 'RULES' section below and builds its corresponding
- * abstract syntax tree. 
+ * abstract syntax tree, in flat form (see "ast/flat_ast.h"), or, in the single-pass
+ * mode, lowers it straight to LLVM IR (see "ir_generator/lowering.h").
  */
 
 /******************** DEFINITIONS ********************/
 %{
-	#include "ast/ast.h"
+	#include "parser/parser.h"
+	#include "support/source_buffer.h"
 	#include <stdio.h>
-	
-	extern int yylex();
-	extern int yylex_destroy();
-	extern int yywrap();
-	astNode *root;
-	astNode *parse(const char *filename);
-	int yyerror(const char *);
-	extern FILE *yyin;
+
+	/* the flex scanner, which reads straight from a buffer in memory (defined in lex.yy.c);
+	   its state is a yyscan_t, kept in the parser context */
+	typedef struct yy_buffer_state *YY_BUFFER_STATE;
+	extern int flexLex(tokenValue *value, void *scanner);
+	extern int yylex_init(void **scanner);
+	extern int yylex_destroy(void *scanner);
+	extern YY_BUFFER_STATE yy_scan_buffer(char *base, size_t size, void *scanner);
+	extern void yy_delete_buffer(YY_BUFFER_STATE buffer, void *scanner);
+
+	/* value of an optional child that is absent, and of an absent parameter when lowering */
+	#define NO_NODE ((astIndex)-1)
+	#define NO_NAME ((nameId)-1)
+
+	/* whether the parse lowers the program to IR rather than building its AST */
+	#define LOWERING (context->lower != NULL)
+
+	int runParser(parserContext *context, char *buffer, size_t len);
+
+	/* the parser's stacks start small and double on the heap as they fill up; bison's default
+	   limit of 10000 entries would reject programs nested a few thousand levels deep */
+	#define YYMAXDEPTH 10000000
 %}
 
+/* the parser is reentrant: its stacks are local to yyparse(), and the rest of the state of a
+   parse is in the context passed to yyparse(), yylex() and yyerror(). Each rule adds its node
+   to 'context->tree' once its children are added, and its value is where the node's subtree
+   starts (see addFlatNode()). When lowering, each rule emits the IR of its construct instead,
+   and the value of an expression is its LLVM value; the actions in the middle of rules set up
+   the blocks of a function, if or while before the statements in them are reduced */
+%define api.pure full
+%param {parserContext *context}
+
 %union {
 	int ival;
-	char *sval;
-	astNode *node;
-	vector<astNode*> *nodeVec;
+	nameId id;
+	ruleValue rule;
 }
 
-%token <sval> IDENTIFIER 
+%token <id> IDENTIFIER 
 %token <ival> NUM 
 %token IF WHILE INT VOID EXTERN RETURN PRINT READ '=' '(' ')' '{' '}' ';'
 %nonassoc IFX
@@ -35,140 +59,320 @@
 %left '+' '-'
 %left '*' '/'
 %nonassoc UMINUS
-%type <nodeVec> stmts var_decls
-%type <node> stmt call_stmt return_stmt block_stmt decl asgn_stmt while_loop
-%type <node> extern_print extern_read def_params function_def
-%type <node> term expr condition
+%type <rule> program stmts var_decls function_defs
+%type <rule> stmt call_stmt return_stmt block_stmt decl asgn_stmt asgn_target while_loop if_head
+%type <rule> extern_print extern_read def_params function_def
+%type <rule> term expr condition
+
+%code {
+	int yylex(YYSTYPE *lval, parserContext *context);
+	int yyerror(parserContext *context, const char *message);
+}
 
 %start program
 
 /******************** RULES ********************/
 %%
 /* mini_c programs start with mandatory declarations of "print" and "read" functions
-   followed by the primary function definition */
-program : extern_print extern_read function_def {root = createProg($1, $2, $3);}
-		| extern_read extern_print function_def {root = createProg($2, $1, $3);}
+   followed by one or more function definitions */
+program : extern_print extern_read function_defs {
+	if (!LOWERING) $$.node = addFlatNode(context->tree, flat_prog, 0, $1.node);
+}
+		| extern_read extern_print function_defs {
+	if (!LOWERING) $$.node = addFlatNode(context->tree, flat_prog, 0, $1.node);
+}
+
+/* function definitions are kept in source order */
+function_defs : function_defs function_def {$$ = $1;}
+			  | function_def {$$ = $1;}
 
-extern_print : EXTERN VOID PRINT '(' INT ')' ';' {$$ = createExtern("print");}
+extern_print : EXTERN VOID PRINT '(' INT ')' ';' {
+	if (!LOWERING) $$.node = addFlatLeaf(context->tree, flat_extern, NAME_PRINT);
+}
 
-extern_read : EXTERN INT READ '(' ')' ';' {$$ = createExtern("read");}
+extern_read : EXTERN INT READ '(' ')' ';' {
+	if (!LOWERING) $$.node = addFlatLeaf(context->tree, flat_extern, NAME_READ);
+}
 
-/* main function definition followed by a curly-brace-separated block statment */
-function_def : INT IDENTIFIER '(' def_params ')' '{' block_stmt '}' {
-	$$ = createFunc($2, $4, $7);
-	free($2);
+/* function definition followed by a curly-brace-separated block statment */
+function_def : INT IDENTIFIER '(' def_params ')' {
+	if (LOWERING) lowerFunctionStart(context->lower, $2, $4.name != NO_NAME, $4.name);
+}
+			   '{' block_stmt '}' {
+	if (LOWERING) lowerFunctionEnd(context->lower);
+	else $$.node = addFlatNode(context->tree, flat_func, $2, $4.node != NO_NODE ? $4.node : $8.node);
 }
 
-/* main function can have at most one parameter */
+/* functions can have at most one parameter */
 def_params : INT IDENTIFIER {
-	$$ = createVar($2);
-	free($2);
-}
-		   | {$$ = NULL;}
-
-/* block statements contain a vector of variable declarations followed by a
-   vector of statements */
-block_stmt : var_decls stmts {
-	vector<astNode*> *block = $1;
-	// combine 'var_decls' and 'stmts' vectors
-	for (int i = 0; i < $2->size(); i++) {
-		block->push_back($2->at(i));
-	}
-	$$ = createBlock(block);
-	delete $2;
-} 
-		   | stmts {$$ = createBlock($1);}
+	if (LOWERING) $$.name = $2;
+	else $$.node = addFlatLeaf(context->tree, flat_var, $2);
+}
+		   | {
+	if (LOWERING) $$.name = NO_NAME;
+	else $$.node = NO_NODE;
+}
+
+/* block statements contain variable declarations followed by statements, all of which
+   are children of the block */
+block_stmt : var_decls stmts {if (!LOWERING) $$.node = addFlatNode(context->tree, flat_block, 0, $1.node);}
+		   | stmts {if (!LOWERING) $$.node = addFlatNode(context->tree, flat_block, 0, $1.node);}
 
 /* allows for any number of subsequent variable declarations */
-var_decls : var_decls decl {
-	$$ = $1;
-	$$->push_back($2);
-} 		  
-		  | decl {
-	$$ = new vector<astNode*>();
-	$$->push_back($1);
-}
+var_decls : var_decls decl {$$ = $1;}
+		  | decl {$$ = $1;}
 
 decl : INT IDENTIFIER ';' {
-	$$ = createDecl($2);
-	free($2);
+	if (LOWERING) lowerDecl(context->lower, $2);
+	else $$.node = addFlatLeaf(context->tree, flat_decl, $2);
 }
 
 /* miniC programs are composed of a series of 'stmt' rules as defined below*/
-stmts : stmts stmt {
-	$$ = $1;
-	$$->push_back($2);
-}
-	  | stmt {
-	$$ = new vector<astNode*>();
-	$$->push_back($1);
-}
+stmts : stmts stmt {$$ = $1;}
+	  | stmt {$$ = $1;}
 
 /* a statement in miniC must be one of the following */
 stmt : asgn_stmt {$$ = $1;}
-	 | IF '(' condition ')' stmt %prec IFX {$$ = createIf($3, $5);}
-	 | IF '(' condition ')' stmt ELSE stmt {$$ = createIf($3, $5, $7);}
+	 | if_head stmt %prec IFX {
+		 if (LOWERING) lowerIfEnd(context->lower);
+		 else $$.node = addFlatNode(context->tree, flat_if, 0, $1.node);
+	 }
+	 | if_head stmt ELSE {if (LOWERING) lowerElse(context->lower);} stmt {
+		 if (LOWERING) lowerIfEnd(context->lower);
+		 else $$.node = addFlatNode(context->tree, flat_if, 0, $1.node);
+	 }
 	 | while_loop {$$ = $1;}
-	 | '{' block_stmt '}' {$$ = $2;}
+	 | '{' {if (LOWERING) lowerBlockStart(context->lower);} block_stmt '}' {
+		 if (LOWERING) lowerBlockEnd(context->lower);
+		 else $$ = $3;
+	 }
 	 | call_stmt ';' {$$ = $1;}
 	 | return_stmt {$$ = $1;}
 
+/* the condition of an if statement is reduced on its own, so that the branch on it can be
+   emitted before the body is */
+if_head : IF '(' condition ')' {
+	if (LOWERING) lowerIfStart(context->lower, $3.value);
+	else $$ = $3;
+}
+
 /* most basic component - either an integer or variable name*/
 term : IDENTIFIER {
-	$$ = createVar($1);
-	free($1);
-}	 
-	 | NUM {$$ = createCnst($1);}
+	if (LOWERING) $$.value = lowerVar(context->lower, $1);
+	else $$.node = addFlatLeaf(context->tree, flat_var, $1);
+}
+	 | NUM {
+		 if (LOWERING) $$.value = lowerConst(context->lower, $1);
+		 else $$.node = addFlatLeaf(context->tree, flat_cnst, $1);
+	 }
 	 | '-' IDENTIFIER %prec UMINUS {
-		 $$ = createUExpr(createVar($2), uminus);
+		 if (LOWERING) $$.value = lowerNegate(context->lower, lowerVar(context->lower, $2));
+		 else $$.node = addFlatNode(context->tree, flat_uexpr, uminus, addFlatLeaf(context->tree, flat_var, $2));
 	 }
 	 | '-' NUM {
-		 $$ = createUExpr(createCnst($2), uminus);
+		 if (LOWERING) $$.value = lowerNegate(context->lower, lowerConst(context->lower, $2));
+		 else $$.node = addFlatNode(context->tree, flat_uexpr, uminus, addFlatLeaf(context->tree, flat_cnst, $2));
 	 }
 
 /* arithmetic operations and function calls */
 expr : term {$$ = $1;}
-	 | term '+' term {$$ = createBExpr($1, $3, add);}
-	 | term '-' term {$$ = createBExpr($1, $3, sub);}
-	 | term '*' term {$$ = createBExpr($1, $3, mul);}
-	 | term '/' term {$$ = createBExpr($1, $3, divide);}
+	 | term '+' term {
+		 if (LOWERING) $$.value = lowerBinary(context->lower, add, $1.value, $3.value);
+		 else $$.node = addFlatNode(context->tree, flat_bexpr, add, $1.node);
+	 }
+	 | term '-' term {
+		 if (LOWERING) $$.value = lowerBinary(context->lower, sub, $1.value, $3.value);
+		 else $$.node = addFlatNode(context->tree, flat_bexpr, sub, $1.node);
+	 }
+	 | term '*' term {
+		 if (LOWERING) $$.value = lowerBinary(context->lower, mul, $1.value, $3.value);
+		 else $$.node = addFlatNode(context->tree, flat_bexpr, mul, $1.node);
+	 }
+	 | term '/' term {
+		 if (LOWERING) $$.value = lowerBinary(context->lower, divide, $1.value, $3.value);
+		 else $$.node = addFlatNode(context->tree, flat_bexpr, divide, $1.node);
+	 }
 	 | call_stmt  {$$ = $1;}
 
 /* boolean expressions (should only be used inside IF and WHILE statements)*/
-condition : term '<' term {$$ = createRExpr($1, $3, lt);}
-		  | term '>' term {$$ = createRExpr($1, $3, gt); }
-		  | term EQ term {$$ = createRExpr($1, $3, eq);}
-		  | term LEQ term {$$ = createRExpr($1, $3, le);}
-		  | term GEQ term {$$ = createRExpr($1, $3, ge);}
+condition : term '<' term {
+	if (LOWERING) $$.value = lowerCompare(context->lower, lt, $1.value, $3.value);
+	else $$.node = addFlatNode(context->tree, flat_rexpr, lt, $1.node);
+}
+		  | term '>' term {
+	if (LOWERING) $$.value = lowerCompare(context->lower, gt, $1.value, $3.value);
+	else $$.node = addFlatNode(context->tree, flat_rexpr, gt, $1.node);
+}
+		  | term EQ term {
+	if (LOWERING) $$.value = lowerCompare(context->lower, eq, $1.value, $3.value);
+	else $$.node = addFlatNode(context->tree, flat_rexpr, eq, $1.node);
+}
+		  | term LEQ term {
+	if (LOWERING) $$.value = lowerCompare(context->lower, le, $1.value, $3.value);
+	else $$.node = addFlatNode(context->tree, flat_rexpr, le, $1.node);
+}
+		  | term GEQ term {
+	if (LOWERING) $$.value = lowerCompare(context->lower, ge, $1.value, $3.value);
+	else $$.node = addFlatNode(context->tree, flat_rexpr, ge, $1.node);
+}
 
-asgn_stmt : IDENTIFIER '=' expr ';' {
-	astNode *varNode = createVar($1);
-	free($1);
-	$$ = createAsgn(varNode, $3);
+asgn_stmt : asgn_target '=' expr ';' {
+	if (LOWERING) lowerAssign(context->lower, $1.slot, $3.value);
+	else $$.node = addFlatNode(context->tree, flat_asgn, 0, $1.node);
 }
 
-while_loop : WHILE '(' condition ')' stmt {$$ = createWhile($3, $5);}
+/* the assigned variable is reduced on its own, so that its node comes before the expression's */
+asgn_target : IDENTIFIER {
+	if (LOWERING) $$.slot = lowerTarget(context->lower, $1);
+	else $$.node = addFlatLeaf(context->tree, flat_var, $1);
+}
 
-/* 'print' requires a parameter value, 'read' does not */
-call_stmt : PRINT '(' term ')' {$$ = createCall("print", $3);}
-		  | READ '(' ')' {$$ = createCall("read", NULL);}
+/* the loop's blocks are created before its condition is reduced, and the branch on the
+   condition emitted before its body is */
+while_loop : WHILE '(' {if (LOWERING) lowerWhileStart(context->lower);}
+			 condition ')' {if (LOWERING) lowerWhileBody(context->lower, $4.value);}
+			 stmt {
+	if (LOWERING) lowerWhileEnd(context->lower);
+	else $$.node = addFlatNode(context->tree, flat_while, 0, $4.node);
+}
 
-return_stmt : RETURN '(' term ')' ';' {$$ = createRet($3);}	
-			| RETURN term ';' {$$ = createRet($2);}	
+/* 'print' requires a parameter value, 'read' does not; calls to functions defined in
+   the program pass the single argument their definition takes, if any */
+call_stmt : PRINT '(' term ')' {
+	if (LOWERING) $$.value = lowerCall(context->lower, NAME_PRINT, $3.value);
+	else $$.node = addFlatNode(context->tree, flat_call, NAME_PRINT, $3.node);
+}
+		  | READ '(' ')' {
+	if (LOWERING) $$.value = lowerCall(context->lower, NAME_READ, NULL);
+	else $$.node = addFlatLeaf(context->tree, flat_call, NAME_READ);
+}
+		  | IDENTIFIER '(' term ')' {
+	if (LOWERING) $$.value = lowerCall(context->lower, $1, $3.value);
+	else $$.node = addFlatNode(context->tree, flat_call, $1, $3.node);
+}
+		  | IDENTIFIER '(' ')' {
+	if (LOWERING) $$.value = lowerCall(context->lower, $1, NULL);
+	else $$.node = addFlatLeaf(context->tree, flat_call, $1);
+}
+
+return_stmt : RETURN '(' term ')' ';' {
+	if (LOWERING) lowerReturn(context->lower, $3.value);
+	else $$.node = addFlatNode(context->tree, flat_ret, 0, $3.node);
+}
+			| RETURN term ';' {
+	if (LOWERING) lowerReturn(context->lower, $2.value);
+	else $$.node = addFlatNode(context->tree, flat_ret, 0, $2.node);
+}
 %%
 
-/* takes the filename of a miniC program as parameter and returns the root node of 
-   a fully constructed AST corresponding to the program*/ 
-astNode *parse(const char *filename) {
-	yyin = fopen(filename, "r");
-	yyparse();
-	fclose(yyin);
-	yylex_destroy();
-	return root;
+/*********************** see "parser.h" for details ***********************/
+flatAST *parse(const char *filename) {
+	sourceBuffer *source = mapSourceFile(filename);
+	if (source == NULL) {
+		return NULL;
+	}
+	flatAST *res = parse(source->text, source->len);
+	freeSourceBuffer(source);
+	return res;
+}
+
+/*********************** see "parser.h" for details ***********************/
+flatAST *parse(FILE *fp) {
+	string contents;
+	char block[4096];
+	size_t read;
+	while ((read = fread(block, 1, sizeof(block), fp)) > 0) {
+		contents.append(block, read);
+	}
+	if (ferror(fp)) {
+		fprintf(stderr, "Error: unable to read the program\n");
+		return NULL;
+	}
+	sourceBuffer *source = copySourceBuffer(contents.data(), contents.size());
+	flatAST *res = parse(source->text, source->len);
+	freeSourceBuffer(source);
+	return res;
+}
+
+/*********************** see "parser.h" for details ***********************/
+flatAST *parse(char *buffer, size_t len, FILE *diagnostics) {
+	parserContext context;
+	context.tree = createFlatAST();
+	context.lower = NULL;
+	context.diagnostics = diagnostics;
+	if (runParser(&context, buffer, len) != 0) {
+		freeFlatAST(context.tree);
+		return NULL;
+	}
+	finishFlatAST(context.tree);
+	return context.tree;
+}
+
+/*********************** see "parser.h" for details ***********************/
+LLVMModuleRef parseToIR(char *buffer, size_t len, const char *module_name, LLVMContextRef llvm_context,
+						bool *semantic_error, FILE *diagnostics) {
+	parserContext context;
+	context.tree = NULL;
+	context.lower = createLowering(module_name, llvm_context);
+	context.diagnostics = diagnostics;
+	LLVMModuleRef module = NULL;
+	*semantic_error = false;
+	if (runParser(&context, buffer, len) == 0) {
+		module = finishLowering(context.lower, diagnostics);
+		*semantic_error = module == NULL;
+	}
+	freeLowering(context.lower);
+	return module;
+}
+
+/* scans and parses the program in 'buffer' (as for parse()) with the scanner selected by
+   getScanner(), running the rules on the 'tree' or 'lower' of 'context'; returns the status
+   of yyparse(), which is 0 if the whole program was parsed */
+int runParser(parserContext *context, char *buffer, size_t len) {
+	context->scanner = getScanner();
+	context->flex_scanner = NULL;
+	YY_BUFFER_STATE state = NULL;
+	if (context->scanner == SCANNER_FLEX) {
+		if (yylex_init(&context->flex_scanner) != 0) {
+			fprintf(context->diagnostics, "Error: unable to create the scanner\n");
+			return 1;
+		}
+		state = yy_scan_buffer(buffer, len + 2, context->flex_scanner);
+		if (state == NULL) {
+			fprintf(context->diagnostics, "Error: source buffer is not followed by two NUL bytes\n");
+			yylex_destroy(context->flex_scanner);
+			return 1;
+		}
+	}
+	else {
+		initScanner(&context->hand_scanner, buffer, len);
+	}
+
+	int status = yyparse(context);
+	if (context->scanner == SCANNER_FLEX) {
+		yy_delete_buffer(state, context->flex_scanner);
+		yylex_destroy(context->flex_scanner);
+	}
+	return status;
+}
+
+/* hands the parser the next token from the scanner of the parse 'context' belongs to.
+   Identifiers are interned here, so every later phase compares names by ID */
+int yylex(YYSTYPE *lval, parserContext *context) {
+	tokenValue value;
+	int token = context->scanner == SCANNER_FLEX ? flexLex(&value, context->flex_scanner)
+		: scanToken(&context->hand_scanner, &value);
+	if (token == NUM) {
+		lval->ival = value.ival;
+	}
+	else if (token == IDENTIFIER) {
+		lval->id = internName(value.view.text, value.view.len);
+	}
+	return token;
 }
 
-/* catches errors while parsing */
-int yyerror(const char *message){
-	fprintf(stderr, "%s\n", message);
+/* catches errors while parsing, reporting them to the stream of the parse */
+int yyerror(parserContext *context, const char *message){
+	fprintf(context->diagnostics, "%s\n", message);
 	return 1;
 }
@@ -0,0 +1,201 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * scanner.c - implements the hand-written miniC scanner
+ */
+
+#include "scanner.h"
+#include "parser.h"
+#include "../y.tab.h"
+#include <string.h>
+#include <limits.h>
+#include <atomic>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// classes of characters, combined in CHAR_CLASS
+#define CHAR_SPACE 0x1 // skipped between tokens (the characters "tokenizer.l" names explicitly)
+#define CHAR_LETTER 0x2 // starts an identifier or keyword
+#define CHAR_IDENT 0x4 // continues an identifier or keyword
+#define CHAR_DIGIT 0x8
+#define CHAR_SINGLE 0x10 // a token by itself
+#define CHAR_RELOP 0x20 // a token by itself, or the start of a two-character operator ending in '='
+
+static unsigned char CHAR_CLASS[256];
+
+static std::atomic<scannerKind> selected_scanner(SCANNER_HAND);
+
+/***************************************** FUNCTION HEADERS *****************************************/
+bool initCharClasses();
+const char *skipSpace(const char *cur, const char *end);
+int getKeyword(const char *text, int len);
+
+// filled in before main() runs, so scanners in any thread can read it
+static bool char_classes_ready = initCharClasses();
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "scanner.h" for details ***********************/
+void selectScanner(scannerKind kind) {
+    selected_scanner.store(kind, std::memory_order_relaxed);
+}
+
+/*********************** see "scanner.h" for details ***********************/
+scannerKind getScanner() {
+    return selected_scanner.load(std::memory_order_relaxed);
+}
+
+/*********************** see "scanner.h" for details ***********************/
+void initScanner(miniScanner *scanner, const char *text, size_t len) {
+    scanner->cur = text;
+    scanner->end = text + len;
+}
+
+/*********************** see "scanner.h" for details ***********************/
+int scanToken(miniScanner *scanner, tokenValue *value) {
+    const char *cur = scanner->cur;
+    const char *end = scanner->end;
+    int token = 0;
+
+    while (token == 0) {
+        cur = skipSpace(cur, end);
+        if (cur >= end) {
+            break;
+        }
+
+        const char *start = cur;
+        unsigned char c = *cur++;
+        unsigned char char_class = CHAR_CLASS[c];
+
+        if (char_class & CHAR_LETTER) {
+            while (cur < end && (CHAR_CLASS[(unsigned char)*cur] & CHAR_IDENT)) {
+                cur++;
+            }
+            token = getKeyword(start, cur - start);
+            if (token == IDENTIFIER) {
+                value->view.text = start;
+                value->view.len = cur - start;
+            }
+        }
+        else if (char_class & CHAR_DIGIT) {
+            // atoi() is strtol() truncated to an int, and strtol() saturates at LONG_MAX
+            long number = c - '0';
+            while (cur < end && (CHAR_CLASS[(unsigned char)*cur] & CHAR_DIGIT)) {
+                int digit = *cur++ - '0';
+                number = number > (LONG_MAX - digit) / 10 ? LONG_MAX : number * 10 + digit;
+            }
+            value->ival = (int)number;
+            token = NUM;
+        }
+        else if (char_class & CHAR_RELOP) {
+            token = c;
+            if (cur < end && *cur == '=') {
+                cur++;
+                token = c == '=' ? EQ : c == '>' ? GEQ : LEQ;
+            }
+        }
+        else if (char_class & CHAR_SINGLE) {
+            token = c;
+        }
+        // any other character starts no token and is skipped
+    }
+
+    scanner->cur = cur;
+    return token;
+}
+
+// fills CHAR_CLASS; returns true so that it can initialize a static
+bool initCharClasses() {
+    for (int c = 'a'; c <= 'z'; c++) {
+        CHAR_CLASS[c] |= CHAR_LETTER | CHAR_IDENT;
+        CHAR_CLASS[c - 'a' + 'A'] |= CHAR_LETTER | CHAR_IDENT;
+    }
+    for (int c = '0'; c <= '9'; c++) {
+        CHAR_CLASS[c] |= CHAR_DIGIT | CHAR_IDENT;
+    }
+    CHAR_CLASS['_'] |= CHAR_IDENT;
+
+    const char *singles = "-+*/(){};";
+    for (int i = 0; singles[i] != '\0'; i++) {
+        CHAR_CLASS[(unsigned char)singles[i]] |= CHAR_SINGLE;
+    }
+    CHAR_CLASS['='] |= CHAR_RELOP;
+    CHAR_CLASS['<'] |= CHAR_RELOP;
+    CHAR_CLASS['>'] |= CHAR_RELOP;
+
+    CHAR_CLASS[' '] |= CHAR_SPACE;
+    CHAR_CLASS['\t'] |= CHAR_SPACE;
+    CHAR_CLASS['\n'] |= CHAR_SPACE;
+    CHAR_CLASS['\r'] |= CHAR_SPACE;
+    return true;
+}
+
+/* returns the first character at or after 'cur' that is not whitespace, or 'end' */
+const char *skipSpace(const char *cur, const char *end) {
+#ifdef __SSE2__
+    // only whole 16-byte blocks inside the source are loaded, so this never reads past 'end'
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    while (end - cur >= 16 && (CHAR_CLASS[(unsigned char)*cur] & CHAR_SPACE)) {
+        __m128i block = _mm_loadu_si128((const __m128i *)cur);
+        __m128i is_space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+                                        _mm_or_si128(_mm_cmpeq_epi8(block, newline), _mm_cmpeq_epi8(block, carriage_return)));
+        unsigned mask = _mm_movemask_epi8(is_space);
+        if (mask != 0xffff) {
+            return cur + __builtin_ctz(~mask);
+        }
+        cur += 16;
+    }
+#endif
+    while (cur < end && (CHAR_CLASS[(unsigned char)*cur] & CHAR_SPACE)) {
+        cur++;
+    }
+    return cur;
+}
+
+/* returns the keyword token spelled by the 'len' characters at 'text', or IDENTIFIER */
+int getKeyword(const char *text, int len) {
+    switch (len) {
+        case 2:
+            if (memcmp(text, "if", 2) == 0) {
+                return IF;
+            }
+            break;
+        case 3:
+            if (memcmp(text, "int", 3) == 0) {
+                return INT;
+            }
+            break;
+        case 4:
+            if (memcmp(text, "else", 4) == 0) {
+                return ELSE;
+            }
+            if (memcmp(text, "void", 4) == 0) {
+                return VOID;
+            }
+            if (memcmp(text, "read", 4) == 0) {
+                return READ;
+            }
+            break;
+        case 5:
+            if (memcmp(text, "while", 5) == 0) {
+                return WHILE;
+            }
+            if (memcmp(text, "print", 5) == 0) {
+                return PRINT;
+            }
+            break;
+        case 6:
+            if (memcmp(text, "extern", 6) == 0) {
+                return EXTERN;
+            }
+            if (memcmp(text, "return", 6) == 0) {
+                return RETURN;
+            }
+            break;
+    }
+    return IDENTIFIER;
+}
@@ -0,0 +1,81 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * scanner.h - defines a hand-written scanner for miniC that tokenizes a program in place, as an
+ * alternative to the flex scanner generated from "tokenizer.l". Both produce the same tokens,
+ * and both hand identifiers to the parser as views into the source rather than as copies.
+ */
+
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <stddef.h>
+
+/*
+ * The text of a token, pointing into the source being scanned; it is not NUL-terminated and is
+ * only valid while that source is
+ */
+typedef struct {
+    const char *text;
+    int len;
+} tokenView;
+
+/*
+ * The value of a token: 'ival' for NUM, 'view' for IDENTIFIER
+ */
+typedef struct {
+    int ival;
+    tokenView view;
+} tokenValue;
+
+/*
+ * State of the hand-written scanner: the part of the source that has not been scanned yet
+ */
+typedef struct {
+    const char *cur;
+    const char *end;
+} miniScanner;
+
+/*
+ * The scanners parse() can use
+ */
+typedef enum {
+    SCANNER_HAND, // the hand-written scanner below (the default)
+    SCANNER_FLEX // the flex scanner generated from "tokenizer.l"
+} scannerKind;
+
+/*
+ * Selects the scanner every later call to parse() uses, in every thread
+ */
+void selectScanner(scannerKind kind);
+
+/*
+ * Returns the scanner selected by selectScanner()
+ */
+scannerKind getScanner();
+
+/*
+ * Params:
+ *      miniScanner *scanner: the scanner to initialize
+ *      const char *text: the miniC program to scan; it is not modified
+ *      size_t len: length of 'text' in bytes
+ */
+void initScanner(miniScanner *scanner, const char *text, size_t len);
+
+/*
+ * Params:
+ *      miniScanner *scanner: a scanner set up by initScanner()
+ *      tokenValue *value: receives the value of NUM and IDENTIFIER tokens
+ *
+ * Returns:
+ *      the next token (one of the token codes of "y.tab.h", or the character itself for
+ *      single-character tokens), or 0 at the end of the program
+ *
+ * Notes:
+ *      Matches "tokenizer.l" exactly: keywords and identifiers take the longest match, numbers
+ *      are converted as atoi() converts them, and characters that start no token are skipped.
+ *      Characters are classified with a lookup table, and runs of whitespace are skipped 16 bytes
+ *      at a time with SSE2 where it is available.
+ */
+int scanToken(miniScanner *scanner, tokenValue *value);
+
+#endif
@@ -5,88 +5,96 @@
  */
 
 #include "semantic_analysis.h"
+#include "symbol_table.h"
 #include <vector>
-#include <unordered_set>
+#include <unordered_map>
 #include <stdbool.h>
-#include <string>
 #include <stdio.h>
 
-/***************************************** FUNCTION HEADERS *****************************************/
-void processStmt(astNode *node, std::vector<astNode*> &node_stack, 
-	std::vector<std::unordered_set<std::string>> &sym_stack, std::unordered_set<astNode*> &to_pop);
-
 /***************************************** IMPLEMENTATION *****************************************/
 
 /*********************** see "semantic_analysis.h" for details ***********************/
 bool isValidAST(astNode *root) {
-	std::unordered_set<astNode*> to_pop; // set used to revisit block/function nodes
-	std::vector<astNode*> node_stack; // stack used for tree traversal
-	std::vector<std::unordered_set<std::string>> sym_stack; // stack used for maintaining symbol tables
+	flatAST *ast = flattenAST(root);
+	bool valid = isValidAST(ast);
+	freeFlatAST(ast);
+	return valid;
+}
 
-	node_stack.push_back(root);
+/*********************** see "semantic_analysis.h" for details ***********************/
+bool isValidAST(flatAST *ast, FILE *diagnostics) {
+	std::vector<astIndex> scope_ends; // end of the subtree of each function/block in scope
+	symbolTable symbols; // the variables declared in the functions/blocks in scope
+	std::unordered_map<nameId, bool> functions; // callable functions -> whether they take a parameter
 
-	// Performs a preorder traversal on the AST
-	while (!node_stack.empty()) {
-		
-		astNode *node = node_stack.back();
-		node_stack.pop_back();
+	// every function can be called from any other, so collect their names first
+	functions[NAME_PRINT] = true;
+	functions[NAME_READ] = false;
+	std::vector<astIndex> flist;
+	getFunctions(ast, flist);
+	for (int i = 0; i < flist.size(); i++) {
+		astIndex func = flist.at(i);
+		if (functions.count(ast->data[func])) {
+			fprintf(diagnostics, "Error: function '%s' is defined more than once\n", getName(ast->data[func]));
+			return false;
+		}
+		functions[ast->data[func]] = ast->kinds[func + 1] == flat_var;
+	}
 
-		switch (node->type) {
-			case ast_prog: {
-				node_stack.push_back(node->prog.func);
-				break;
-			}
+	// the nodes are stored in preorder, so a single pass over them visits the program in the
+	// order a traversal of the tree would
+	ast->slots.assign(ast->kinds.size(), 0);
+	astIndex end = getNextNode(ast, 0);
+	for (astIndex node = 0; node < end; node++) {
 
-			case ast_func: {
-				// pop symbol table at top of stack if this function block has already been processed
-				if (to_pop.count(node)) {
-					sym_stack.pop_back();
-					to_pop.erase(node);
-					break;
-				}
-				to_pop.insert(node); // revisit this node later
-				node_stack.push_back(node);
-				
-				// initialize new symbol table
-				std::unordered_set<std::string> curr_sym_table;
-				if (node->func.param != NULL) {
-					curr_sym_table.insert(node->func.param->var.name); // function parameters also serve as variable declarations
+		// close the scopes of the functions/blocks whose subtree has been passed
+		while (!scope_ends.empty() && scope_ends.back() <= node) {
+			scope_ends.pop_back();
+			closeScope(&symbols);
+		}
+
+		switch (ast->kinds[node]) {
+			case flat_func: {
+				scope_ends.push_back(getNextNode(ast, node));
+				startFunctionScope(&symbols);
+				if (ast->kinds[node + 1] == flat_var) {
+					// function parameters also serve as variable declarations
+					ast->slots[node + 1] = declareName(&symbols, ast->data[node + 1]);
+					node++; // the parameter is a declaration, not a use
 				}
-				sym_stack.push_back(curr_sym_table);
-				node_stack.push_back(node->func.body);
-				break;
-			}
-			case ast_stmt: {
-				processStmt(node, node_stack, sym_stack, to_pop);
 				break;
 			}
-			case ast_var: {
-				const char *curr_var = node->var.name;
-				bool found = false;
-				// check if current variable appears in an available symbol table
-				for (int i = 0; i < sym_stack.size(); i++) {
-					if (sym_stack.at(i).count(curr_var)) {
-						found = true;
-					}
-				}
-				if (!found) {
-					fprintf(stderr, "Error: variable '%s' used before declared\n", curr_var);
-					return false;
-				}
+			case flat_block: {
+				scope_ends.push_back(getNextNode(ast, node));
+				openScope(&symbols);
 				break;
 			}
-			case ast_rexpr: {
-				node_stack.push_back(node->rexpr.rhs);
-				node_stack.push_back(node->rexpr.lhs);
+			// declare the new variable in the innermost scope
+			case flat_decl: {
+				ast->slots[node] = declareName(&symbols, ast->data[node]);
 				break;
 			}
-			case ast_bexpr: {
-				node_stack.push_back(node->bexpr.rhs);
-				node_stack.push_back(node->bexpr.lhs);
+			// resolve the variable to its declaration in the innermost scope that has one
+			case flat_var: {
+				int32_t slot = lookupName(&symbols, ast->data[node]);
+				if (slot < 0) {
+					fprintf(diagnostics, "Error: variable '%s' used before declared\n", getName(ast->data[node]));
+					return false;
+				}
+				ast->slots[node] = slot;
 				break;
 			}
-			case ast_uexpr: {
-				node_stack.push_back(node->uexpr.expr);
+			case flat_call: {
+				// the callee must be defined and called with as many arguments as it takes
+				std::unordered_map<nameId, bool>::iterator callee = functions.find(ast->data[node]);
+				if (callee == functions.end()) {
+					fprintf(diagnostics, "Error: call to undefined function '%s'\n", getName(ast->data[node]));
+					return false;
+				}
+				if (callee->second != (ast->sizes[node] > 1)) {
+					fprintf(diagnostics, "Error: function '%s' called with the wrong number of arguments\n", getName(ast->data[node]));
+					return false;
+				}
 				break;
 			}
 			default: {
@@ -97,65 +105,34 @@ bool isValidAST(astNode *root) {
 	return true;
 }
 
-/* Helper function for analyzeAST(): takes an AST statement node (as well as the node stack, 
-   symbol table stack, and 'to_pop' set) as parameters and processes the individual statement separately */
-void processStmt(astNode *node, std::vector<astNode*> &node_stack, 
-	std::vector<std::unordered_set<std::string>> &sym_stack, std::unordered_set<astNode*> &to_pop) {
-	switch (node->stmt.type) {
-		case ast_block: {
-			// pop symbol table at top of stack if this block has already been processed
-			if (to_pop.count(node)) {
-				sym_stack.pop_back();
-				to_pop.erase(node);
-				break;
-			}
-			to_pop.insert(node); // revisit this node later
-			node_stack.push_back(node);
-
-			std::unordered_set<std::string> curr_sym_table;
-			sym_stack.push_back(curr_sym_table);
-			
-			// push each statement inside of the current block statement onto node stack
-			vector<astNode*> *slist = node->stmt.block.stmt_list;
-			for (int i = slist->size() - 1; i >= 0; i--) {
-				node_stack.push_back(slist->at(i));
-			}
-			break;
-		}
-		// add newly declared variable name to the symbol table at the top of the stack
-		case ast_decl: {
-			sym_stack.back().insert(node->stmt.decl.name);
-			break;
-		}
-		case ast_asgn: {
-			node_stack.push_back(node->stmt.asgn.rhs);
-			node_stack.push_back(node->stmt.asgn.lhs);
-			break;
-
+/*********************** see "semantic_analysis.h" for details ***********************/
+void resolveVariables(flatAST *ast, astIndex root) {
+	std::vector<astIndex> scope_ends;
+	symbolTable symbols;
+	ast->slots.resize(ast->kinds.size(), 0);
+	astIndex end = getNextNode(ast, root);
+	for (astIndex node = root; node < end; node++) {
+		while (!scope_ends.empty() && scope_ends.back() <= node) {
+			scope_ends.pop_back();
+			closeScope(&symbols);
 		}
-		case ast_if: {
-			if (node->stmt.ifn.else_body != NULL) {
-				node_stack.push_back(node->stmt.ifn.else_body);
+		if (ast->kinds[node] == flat_func) {
+			scope_ends.push_back(getNextNode(ast, node));
+			startFunctionScope(&symbols);
+			if (ast->kinds[node + 1] == flat_var) {
+				ast->slots[node + 1] = declareName(&symbols, ast->data[node + 1]);
+				node++;
 			}
-			node_stack.push_back(node->stmt.ifn.if_body);
-			node_stack.push_back(node->stmt.ifn.cond);
-			break;
 		}
-		case ast_while: {
-			node_stack.push_back(node->stmt.whilen.body);
-			node_stack.push_back(node->stmt.whilen.cond);
-			break;
+		else if (ast->kinds[node] == flat_block) {
+			scope_ends.push_back(getNextNode(ast, node));
+			openScope(&symbols);
 		}
-
-		case ast_call: {
-			if (node->stmt.call.param != NULL) {
-				node_stack.push_back(node->stmt.call.param);
-			}
-			break;
+		else if (ast->kinds[node] == flat_decl) {
+			ast->slots[node] = declareName(&symbols, ast->data[node]);
 		}
-		case ast_ret: {
-			node_stack.push_back(node->stmt.ret.expr);
-			break;
+		else if (ast->kinds[node] == flat_var) {
+			ast->slots[node] = lookupName(&symbols, ast->data[node]);
 		}
 	}
 }
@@ -8,6 +8,8 @@
 #define SEMANTIC_ANALYSIS_H
 
 #include "../ast/ast.h"
+#include "../ast/flat_ast.h"
+#include <stdio.h>
 
 /*
  * Params: 
@@ -17,12 +19,34 @@
  * 
  * Returns:
  *      TRUE, if the provided abstract syntax tree is semantically valid (i.e. there
- *      are no variables that are used before they are declared)
+ *      are no variables that are used before they are declared, no function is defined
+ *      twice, and every call names a defined function and passes as many arguments as
+ *      it takes)
  *
  *      FALSE, OTHERWISE
  */
 bool isValidAST(astNode *root);
 
+/*
+ * Same as above for a program in flat form (see "flat_ast.h"); the check is a single pass
+ * over the node array, so it is the one the compiler itself uses. It also resolves every
+ * variable to the slot of its declaration, which it stores in 'ast->slots' for IR generation:
+ * a declaration in a block hides one of the same name in the enclosing scopes until the block
+ * ends (see "symbol_table.h"). The first error found is printed to 'diagnostics'.
+ */
+bool isValidAST(flatAST *ast, FILE *diagnostics = stderr);
+
+/*
+ * Params:
+ *      flatAST *ast: a semantically valid program in flat form, or a single function
+ *      astIndex root: the program or function whose variables to resolve
+ *
+ * Notes:
+ *      Fills in 'ast->slots' for the subtree of 'root' as isValidAST() does, without checking
+ *      it; for ASTs built by hand, which are not checked before their IR is generated.
+ */
+void resolveVariables(flatAST *ast, astIndex root);
+
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * symbol_table.c - implements the scoped symbol table that resolves variables to slots
+ */
+
+#include "symbol_table.h"
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "symbol_table.h" for details ***********************/
+void startFunctionScope(symbolTable *table) {
+    table->bindings.clear();
+    table->hidden.clear();
+    table->scope_starts.clear();
+    table->num_slots = 0;
+    openScope(table);
+}
+
+/*********************** see "symbol_table.h" for details ***********************/
+void openScope(symbolTable *table) {
+    table->scope_starts.push_back(table->hidden.size());
+}
+
+/*********************** see "symbol_table.h" for details ***********************/
+void closeScope(symbolTable *table) {
+    size_t start = table->scope_starts.back();
+    table->scope_starts.pop_back();
+
+    // undo the scope's declarations, latest first, so a name declared twice ends up with the
+    // binding it had before either
+    while (table->hidden.size() > start) {
+        hiddenBinding &restored = table->hidden.back();
+        table->bindings[restored.name] = restored.binding;
+        table->hidden.pop_back();
+    }
+}
+
+/*********************** see "symbol_table.h" for details ***********************/
+int32_t declareName(symbolTable *table, nameId name) {
+    int32_t depth = table->scope_starts.size();
+    nameBinding none = {-1, -1};
+    std::pair<std::unordered_map<nameId, nameBinding>::iterator, bool> entry = table->bindings.insert(
+        std::pair<nameId, nameBinding>(name, none));
+    nameBinding &binding = entry.first->second;
+    if (binding.depth == depth) {
+        return binding.slot;
+    }
+    hiddenBinding hidden = {name, binding};
+    table->hidden.push_back(hidden);
+    binding.slot = table->num_slots++;
+    binding.depth = depth;
+    return binding.slot;
+}
+
+/*********************** see "symbol_table.h" for details ***********************/
+int32_t lookupName(const symbolTable *table, nameId name) {
+    std::unordered_map<nameId, nameBinding>::const_iterator entry = table->bindings.find(name);
+    return entry != table->bindings.end() ? entry->second.slot : -1;
+}
@@ -0,0 +1,76 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * symbol_table.h - defines the scoped symbol table that resolves the variables of a miniC
+ * function to dense slot numbers: each name maps straight to its innermost declaration, and the
+ * declarations it hides are set aside until the scope that hid them closes, so a lookup costs
+ * the same however deeply the scopes are nested
+ */
+
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include "../support/name_table.h"
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * The declaration a name refers to
+ */
+typedef struct {
+    int32_t slot; // slot of the variable, or -1 if the name is not declared in an open scope
+    int32_t depth; // how many scopes were open when it was declared
+} nameBinding;
+
+/*
+ * A declaration hidden by a later one, restored when the later one's scope closes
+ */
+typedef struct {
+    nameId name;
+    nameBinding binding;
+} hiddenBinding;
+
+typedef struct {
+    std::unordered_map<nameId, nameBinding> bindings; // innermost declaration of each name
+    std::vector<hiddenBinding> hidden; // bindings replaced by declarations in the open scopes
+    std::vector<size_t> scope_starts; // length of 'hidden' when each open scope was opened
+    int32_t num_slots; // slots handed out in the current function
+} symbolTable;
+
+/*
+ * Closes every scope of 'table' and opens the outermost scope of a new function, whose
+ * variables are numbered from slot 0
+ */
+void startFunctionScope(symbolTable *table);
+
+/*
+ * Opens a scope (a block) nested in the innermost open scope of 'table'
+ */
+void openScope(symbolTable *table);
+
+/*
+ * Closes the innermost open scope of 'table'; the names it declared refer again to whatever
+ * they referred to when it was opened
+ */
+void closeScope(symbolTable *table);
+
+/*
+ * Params:
+ *      symbolTable *table: a table with an open scope
+ *      nameId name: a variable declared in the innermost scope
+ *
+ * Returns:
+ *      the slot of the variable. A declaration in an enclosing scope is hidden until the
+ *      innermost scope closes, and the variable gets the next free slot of the function; a
+ *      second declaration in the same scope names the same variable, so it gets the slot of the
+ *      first.
+ */
+int32_t declareName(symbolTable *table, nameId name);
+
+/*
+ * Returns the slot of the innermost declaration of 'name' in an open scope of 'table', or -1
+ * if there is none
+ */
+int32_t lookupName(const symbolTable *table, nameId name);
+
+#endif
@@ -0,0 +1,106 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * arena.c - implements the bump allocator
+ */
+
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT alignof(max_align_t)
+
+/* a block of memory; the memory handed out follows the header */
+struct arena_Block {
+    struct arena_Block *next;
+    size_t size; // bytes following the header
+};
+
+#define BLOCK_HEADER_SIZE ((sizeof(struct arena_Block) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+/***************************************** FUNCTION HEADERS *****************************************/
+struct arena_Block *addBlock(arena *arena, size_t size);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "arena.h" for details ***********************/
+arena *createArena(size_t block_size) {
+    arena *new_arena = (arena *)calloc(1, sizeof(arena));
+    new_arena->block_size = block_size;
+    return new_arena;
+}
+
+/*********************** see "arena.h" for details ***********************/
+void *arenaAlloc(arena *arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    arena->allocated += size;
+
+    // large allocations get a block of their own, so the space left in the current block is
+    // not wasted
+    if (size > arena->block_size / 4) {
+        char *ptr = (char *)addBlock(arena, size) + BLOCK_HEADER_SIZE;
+        memset(ptr, 0, size);
+        return ptr;
+    }
+
+    if (arena->cur == NULL || (size_t)(arena->end - arena->cur) < size) {
+        struct arena_Block *block = addBlock(arena, arena->block_size);
+        arena->cur = (char *)block + BLOCK_HEADER_SIZE;
+        arena->end = arena->cur + block->size;
+    }
+    char *ptr = arena->cur;
+    arena->cur += size;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+/*********************** see "arena.h" for details ***********************/
+void resetArena(arena *arena) {
+    struct arena_Block *kept = NULL;
+    struct arena_Block *block = arena->blocks;
+    while (block != NULL) {
+        struct arena_Block *next = block->next;
+        if (kept == NULL && block->size == arena->block_size) {
+            kept = block;
+        }
+        else {
+            free(block);
+        }
+        block = next;
+    }
+
+    arena->blocks = kept;
+    arena->cur = NULL;
+    arena->end = NULL;
+    if (kept != NULL) {
+        kept->next = NULL;
+        arena->cur = (char *)kept + BLOCK_HEADER_SIZE;
+        arena->end = arena->cur + kept->size;
+    }
+    arena->allocated = 0;
+}
+
+/*********************** see "arena.h" for details ***********************/
+void freeArena(arena *arena) {
+    struct arena_Block *block = arena->blocks;
+    while (block != NULL) {
+        struct arena_Block *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+/* allocates a block with room for 'size' bytes and puts it at the front of the arena's list */
+struct arena_Block *addBlock(arena *arena, size_t size) {
+    struct arena_Block *block = (struct arena_Block *)malloc(BLOCK_HEADER_SIZE + size);
+    if (block == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        abort();
+    }
+    block->size = size;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    return block;
+}
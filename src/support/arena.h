@@ -0,0 +1,82 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * arena.h - defines a bump allocator: memory is handed out in order from large blocks and is
+ * only ever released all at once, by resetting or freeing the arena
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+
+struct arena_Block;
+
+typedef struct {
+    struct arena_Block *blocks; // most recently allocated first
+    char *cur; // next free byte of the current block
+    char *end; // end of the current block
+    size_t block_size; // size of the blocks allocations are normally carved from
+    size_t allocated; // bytes handed out since the arena was created or last reset
+} arena;
+
+/*
+ * Params:
+ *      size_t block_size: size of the blocks to allocate from; allocations larger than a
+ *      quarter of it get a block of their own
+ *
+ * Returns:
+ *      a pointer to a newly allocated, empty arena
+ */
+arena *createArena(size_t block_size = ARENA_DEFAULT_BLOCK_SIZE);
+
+/*
+ * Returns 'size' bytes of zero-filled memory from 'arena', aligned for any type. The memory
+ * stays valid until the arena is reset or freed, and cannot be freed on its own.
+ */
+void *arenaAlloc(arena *arena, size_t size);
+
+/*
+ * Releases everything allocated from 'arena' at once, keeping one block for later allocations
+ */
+void resetArena(arena *arena);
+
+/*
+ * Releases everything allocated from 'arena', and the arena itself
+ */
+void freeArena(arena *arena);
+
+/*
+ * A standard-library allocator that allocates from an arena, so that containers (e.g. the
+ * statement lists of the AST) live in it too; deallocating does nothing
+ */
+template <typename T>
+struct arenaAllocator {
+    typedef T value_type;
+
+    arena *owner;
+
+    arenaAllocator(arena *owner) : owner(owner) {}
+
+    template <typename U>
+    arenaAllocator(const arenaAllocator<U> &other) : owner(other.owner) {}
+
+    T *allocate(size_t count) {
+        return (T *)arenaAlloc(owner, count * sizeof(T));
+    }
+
+    void deallocate(T *ptr, size_t count) {}
+
+    template <typename U>
+    bool operator==(const arenaAllocator<U> &other) const {
+        return owner == other.owner;
+    }
+
+    template <typename U>
+    bool operator!=(const arenaAllocator<U> &other) const {
+        return owner != other.owner;
+    }
+};
+
+#endif
@@ -0,0 +1,98 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * counting_allocator.c - a counting allocator: interposes the C library's allocation functions,
+ * through which operator new and delete, strdup and LLVM all allocate, and reports every block
+ * to the hooks of "memory_counter.h". Replacing malloc affects the whole process, so this object
+ * is kept out of miniC-lib.a and only linked into ./compile; programs that embed the library
+ * keep their own allocator, and their memory reports count nothing
+ */
+
+#include "memory_counter.h"
+#include <stddef.h>
+#include <errno.h>
+#include <malloc.h>
+
+// the C library's own allocator, which glibc exports under these names
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void __libc_free(void *ptr);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+}
+
+/***************************************** FUNCTION HEADERS *****************************************/
+void countBlock(void *ptr);
+void countFreedBlock(void *ptr);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+// AddressSanitizer replaces the allocator itself, so it keeps its own and nothing is counted
+#ifndef __SANITIZE_ADDRESS__
+
+extern "C" void *malloc(size_t size) noexcept {
+    void *ptr = __libc_malloc(size);
+    countBlock(ptr);
+    return ptr;
+}
+
+extern "C" void free(void *ptr) noexcept {
+    countFreedBlock(ptr);
+    __libc_free(ptr);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept {
+    void *ptr = __libc_calloc(count, size);
+    countBlock(ptr);
+    return ptr;
+}
+
+extern "C" void *realloc(void *ptr, size_t size) noexcept {
+    size_t old_size = ptr != NULL && isMemoryAccountingEnabled() ? malloc_usable_size(ptr) : 0;
+    void *new_ptr = __libc_realloc(ptr, size);
+
+    // on failure the old block stays allocated; realloc(ptr, 0) frees it
+    if (new_ptr != NULL || size == 0) {
+        countFree(old_size);
+        countBlock(new_ptr);
+    }
+    return new_ptr;
+}
+
+extern "C" void *memalign(size_t alignment, size_t size) noexcept {
+    void *ptr = __libc_memalign(alignment, size);
+    countBlock(ptr);
+    return ptr;
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size) noexcept {
+    return memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void **ptr, size_t alignment, size_t size) noexcept {
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *block = memalign(alignment, size);
+    if (block == NULL) {
+        return ENOMEM;
+    }
+    *ptr = block;
+    return 0;
+}
+
+#endif
+
+// sizes are taken from the allocator itself, so a block counts the same when it is freed
+void countBlock(void *ptr) {
+    if (ptr != NULL && isMemoryAccountingEnabled()) {
+        countAllocation(malloc_usable_size(ptr));
+    }
+}
+
+void countFreedBlock(void *ptr) {
+    if (ptr != NULL && isMemoryAccountingEnabled()) {
+        countFree(malloc_usable_size(ptr));
+    }
+}
@@ -0,0 +1,42 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * file_io.c - implements helpers for reading and writing whole files
+ */
+
+#include "file_io.h"
+#include <stdio.h>
+#include <string.h>
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "file_io.h" for details ***********************/
+bool readFile(const char *filename, std::string &contents) {
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        return false;
+    }
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        contents.append(buf, n);
+    }
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+}
+
+/*********************** see "file_io.h" for details ***********************/
+bool writeFile(const char *filename, const std::string &contents) {
+    if (strcmp(filename, "-") == 0) {
+        return fwrite(contents.data(), 1, contents.size(), stdout) == contents.size() && fflush(stdout) == 0;
+    }
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: unable to open '%s' for writing\n", filename);
+        return false;
+    }
+    bool ok = fwrite(contents.data(), 1, contents.size(), fp) == contents.size();
+    ok = fclose(fp) == 0 && ok;
+    return ok;
+}
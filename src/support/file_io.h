@@ -0,0 +1,34 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * file_io.h - defines helpers for reading and writing whole files
+ */
+
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <string>
+
+/*
+ * Params:
+ *      const char *filename: path of the file to read
+ *      std::string &contents: string the whole file is appended to
+ *
+ * Returns:
+ *      TRUE, if the file was read successfully
+ *      FALSE, if it could not be opened or read
+ */
+bool readFile(const char *filename, std::string &contents);
+
+/*
+ * Params:
+ *      const char *filename: path of the file to write; an existing file is replaced, and
+ *      "-" writes to stdout
+ *      const std::string &contents: bytes to write
+ *
+ * Returns:
+ *      TRUE, if every byte was written
+ *      FALSE, otherwise (an error message is printed to stderr)
+ */
+bool writeFile(const char *filename, const std::string &contents);
+
+#endif
@@ -0,0 +1,56 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * memory_counter.c - implements the per-thread allocation counters and the hooks that feed them
+ */
+
+#include "memory_counter.h"
+#include <sys/resource.h>
+#include <atomic>
+
+static std::atomic<bool> accounting(false);
+
+// thread-local so that concurrent compiles do not contend; zero-initialized, so reading it never
+// allocates
+static thread_local memoryCounters counters;
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "memory_counter.h" for details ***********************/
+void enableMemoryAccounting() {
+    accounting.store(true, std::memory_order_relaxed);
+}
+
+/*********************** see "memory_counter.h" for details ***********************/
+bool isMemoryAccountingEnabled() {
+    return accounting.load(std::memory_order_relaxed);
+}
+
+/*********************** see "memory_counter.h" for details ***********************/
+void countAllocation(size_t bytes) {
+    if (accounting.load(std::memory_order_relaxed)) {
+        counters.allocated += bytes;
+        counters.allocations += 1;
+    }
+}
+
+/*********************** see "memory_counter.h" for details ***********************/
+void countFree(size_t bytes) {
+    if (accounting.load(std::memory_order_relaxed)) {
+        counters.freed += bytes;
+    }
+}
+
+/*********************** see "memory_counter.h" for details ***********************/
+memoryCounters readMemoryCounters() {
+    return counters;
+}
+
+/*********************** see "memory_counter.h" for details ***********************/
+long readPeakRSS() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return usage.ru_maxrss;
+}
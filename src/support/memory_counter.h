@@ -0,0 +1,59 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * memory_counter.h - defines per-thread counters of the bytes and allocations made, so that the
+ * memory used by each compile phase can be reported (see time_report.h). The counters are fed by
+ * hooks that a counting allocator calls; the library does not replace the process's allocator
+ * itself, so only programs that link one (such as support/counting_allocator.c, which only
+ * ./compile links) count anything
+ */
+
+#ifndef MEMORY_COUNTER_H
+#define MEMORY_COUNTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Totals of the calling thread since accounting was enabled
+ */
+typedef struct {
+    long allocated; // bytes allocated, including the allocator's rounding
+    long allocations; // number of allocations (a realloc counts as one)
+    long freed; // bytes freed, possibly including memory allocated by another thread
+} memoryCounters;
+
+/*
+ * Starts counting allocations. Until this is called, the hooks below do nothing, so a counting
+ * allocator costs a single branch per allocation.
+ */
+void enableMemoryAccounting();
+
+/*
+ * Returns TRUE once enableMemoryAccounting() has been called
+ */
+bool isMemoryAccountingEnabled();
+
+/*
+ * Adds a block of 'bytes' bytes to the allocations of the calling thread, once accounting is
+ * enabled; called by a counting allocator for every block it hands out
+ */
+void countAllocation(size_t bytes);
+
+/*
+ * Adds 'bytes' to the bytes freed by the calling thread, once accounting is enabled; called by
+ * a counting allocator for every block it takes back
+ */
+void countFree(size_t bytes);
+
+/*
+ * Returns the counters of the calling thread (all zero if accounting is not enabled, or if no
+ * counting allocator is linked into the program)
+ */
+memoryCounters readMemoryCounters();
+
+/*
+ * Returns the peak resident set size of the process so far, in KiB
+ */
+long readPeakRSS();
+
+#endif
@@ -0,0 +1,166 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * name_table.c - implements the identifier interning table: an open-addressing hash table of
+ * IDs under a lock for interning, and a chunked array of names that IDs index without one
+ */
+
+#include "name_table.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#define CHUNK_BITS 12
+#define CHUNK_SIZE (1 << CHUNK_BITS) // names per chunk of 'chunks'
+#define MAX_CHUNKS (1 << 16)
+#define TEXT_BLOCK_SIZE (64 * 1024) // bytes of name text allocated at a time
+#define EMPTY_SLOT -1
+
+typedef struct {
+    const char *text;
+    size_t len;
+    unsigned hash;
+} nameEntry;
+
+// chunks are allocated as names are added and never move, so an ID can be looked up while
+// another thread is interning
+static std::atomic<nameEntry *> chunks[MAX_CHUNKS];
+static std::atomic<int> num_names(0);
+
+// guarded by 'table_lock'
+static std::mutex table_lock;
+static std::vector<nameId> slots; // hash table of IDs; the size is a power of two
+static char *text_block = NULL;
+static size_t text_left = 0;
+
+/***************************************** FUNCTION HEADERS *****************************************/
+unsigned hashName(const char *text, size_t len);
+nameEntry *getEntry(nameId id);
+nameId addName(const char *text, size_t len, unsigned hash);
+void growSlots();
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "name_table.h" for details ***********************/
+nameId internName(const char *text, size_t len) {
+    unsigned hash = hashName(text, len);
+    std::lock_guard<std::mutex> guard(table_lock);
+
+    // the extern functions always get the first two IDs
+    if (slots.empty()) {
+        growSlots();
+        addName("print", strlen("print"), hashName("print", strlen("print")));
+        addName("read", strlen("read"), hashName("read", strlen("read")));
+    }
+
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        nameId id = slots.at(i);
+        if (id == EMPTY_SLOT) {
+            return addName(text, len, hash);
+        }
+        nameEntry *entry = getEntry(id);
+        if (entry->hash == hash && entry->len == len && memcmp(entry->text, text, len) == 0) {
+            return id;
+        }
+    }
+}
+
+/*********************** see "name_table.h" for details ***********************/
+nameId internName(const char *text) {
+    return internName(text, strlen(text));
+}
+
+/*********************** see "name_table.h" for details ***********************/
+const char *getName(nameId id) {
+    return getEntry(id)->text;
+}
+
+/*********************** see "name_table.h" for details ***********************/
+size_t getNameLength(nameId id) {
+    return getEntry(id)->len;
+}
+
+/*********************** see "name_table.h" for details ***********************/
+int countNames() {
+    return num_names.load(std::memory_order_acquire);
+}
+
+/* FNV-1a */
+unsigned hashName(const char *text, size_t len) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+nameEntry *getEntry(nameId id) {
+    return &chunks[id >> CHUNK_BITS].load(std::memory_order_acquire)[id & (CHUNK_SIZE - 1)];
+}
+
+/* copies the name into the table and gives it the next ID; called with 'table_lock' held */
+nameId addName(const char *text, size_t len, unsigned hash) {
+    nameId id = num_names.load(std::memory_order_relaxed);
+    if (id >> CHUNK_BITS >= MAX_CHUNKS) {
+        fprintf(stderr, "Error: too many distinct identifiers\n");
+        abort();
+    }
+    if ((id & (CHUNK_SIZE - 1)) == 0) {
+        chunks[id >> CHUNK_BITS].store((nameEntry *)calloc(CHUNK_SIZE, sizeof(nameEntry)), std::memory_order_release);
+    }
+
+    // names share large blocks, except for names too long to fit one well
+    char *copy;
+    if (len + 1 > TEXT_BLOCK_SIZE / 4) {
+        copy = (char *)malloc(len + 1);
+    }
+    else {
+        if (len + 1 > text_left) {
+            text_block = (char *)malloc(TEXT_BLOCK_SIZE);
+            text_left = TEXT_BLOCK_SIZE;
+        }
+        copy = text_block;
+        text_block += len + 1;
+        text_left -= len + 1;
+    }
+    memcpy(copy, text, len);
+    copy[len] = '\0';
+
+    nameEntry *entry = getEntry(id);
+    entry->text = copy;
+    entry->len = len;
+    entry->hash = hash;
+    num_names.store(id + 1, std::memory_order_release);
+
+    // keep the table at most half full
+    if ((size_t)(id + 1) * 2 > slots.size()) {
+        growSlots();
+    }
+    else {
+        size_t mask = slots.size() - 1;
+        size_t i = hash & mask;
+        while (slots.at(i) != EMPTY_SLOT) {
+            i = (i + 1) & mask;
+        }
+        slots.at(i) = id;
+    }
+    return id;
+}
+
+/* doubles the hash table (or creates it) and reinserts every ID; called with 'table_lock' held */
+void growSlots() {
+    size_t size = slots.empty() ? 1024 : slots.size() * 2;
+    slots.assign(size, EMPTY_SLOT);
+    int count = num_names.load(std::memory_order_relaxed);
+    for (nameId id = 0; id < count; id++) {
+        size_t i = getEntry(id)->hash & (size - 1);
+        while (slots.at(i) != EMPTY_SLOT) {
+            i = (i + 1) & (size - 1);
+        }
+        slots.at(i) = id;
+    }
+}
@@ -0,0 +1,58 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * name_table.h - defines the table that interns the identifiers of miniC programs: each distinct
+ * name is stored once for the life of the process and given a small integer ID, so the AST and
+ * every phase after the scanner can compare and hash names as integers
+ */
+
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <stddef.h>
+
+/*
+ * The ID of an interned name. IDs are dense, starting at 0, and equal exactly when the names
+ * are; they are only meaningful within one process.
+ */
+typedef int nameId;
+
+// the names of the two extern functions every miniC program declares, interned up front
+#define NAME_PRINT 0
+#define NAME_READ 1
+
+/*
+ * Params:
+ *      const char *text: the name (need not be NUL-terminated)
+ *      size_t len: length of 'text' in bytes
+ *
+ * Returns:
+ *      the ID of the name, interning it first if it has not been seen before
+ *
+ * Notes:
+ *      Safe to call from any thread. The table never shrinks, so a long-running process (e.g.
+ *      a compile server) holds every distinct name it has compiled.
+ */
+nameId internName(const char *text, size_t len);
+
+/*
+ * Same as above, for a NUL-terminated name
+ */
+nameId internName(const char *text);
+
+/*
+ * Returns the NUL-terminated text of 'id', which stays valid for the life of the process.
+ * Takes no lock, so it is cheap to call from any thread holding an ID.
+ */
+const char *getName(nameId id);
+
+/*
+ * Returns the length of the text of 'id' in bytes
+ */
+size_t getNameLength(nameId id);
+
+/*
+ * Returns the number of names interned so far
+ */
+int countNames();
+
+#endif
@@ -0,0 +1,92 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * source_buffer.c - implements functions that load miniC programs into buffers the scanner
+ * can read in place
+ */
+
+#include "source_buffer.h"
+#include "file_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "source_buffer.h" for details ***********************/
+sourceBuffer *mapSourceFile(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "Error: unable to open '%s'\n", filename);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    if (!S_ISREG(st.st_mode)) {
+        close(fd);
+        std::string contents;
+        if (!readFile(filename, contents)) {
+            fprintf(stderr, "Error: unable to read '%s'\n", filename);
+            return NULL;
+        }
+        return copySourceBuffer(contents.data(), contents.size());
+    }
+
+    // reserve zeroed memory for the file plus the two NUL bytes, then map the file over the
+    // start of it; this works even when the file ends exactly on a page boundary, where the
+    // bytes after it would otherwise fall outside any mapping
+    size_t len = st.st_size;
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t mapped_len = (len + 2 + page_size - 1) / page_size * page_size;
+    void *base = mmap(NULL, mapped_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        fprintf(stderr, "Error: unable to map '%s': %s\n", filename, strerror(errno));
+        return NULL;
+    }
+    if (len > 0 && mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mapped_len);
+        close(fd);
+        fprintf(stderr, "Error: unable to map '%s': %s\n", filename, strerror(errno));
+        return NULL;
+    }
+    close(fd);
+
+    sourceBuffer *buffer = (sourceBuffer *)malloc(sizeof(sourceBuffer));
+    buffer->text = (char *)base;
+    buffer->len = len;
+    buffer->mapped_len = mapped_len;
+    return buffer;
+}
+
+/*********************** see "source_buffer.h" for details ***********************/
+sourceBuffer *copySourceBuffer(const char *source, size_t len) {
+    sourceBuffer *buffer = (sourceBuffer *)malloc(sizeof(sourceBuffer));
+    buffer->text = (char *)malloc(len + 2);
+    memcpy(buffer->text, source, len);
+    buffer->text[len] = '\0';
+    buffer->text[len + 1] = '\0';
+    buffer->len = len;
+    buffer->mapped_len = 0;
+    return buffer;
+}
+
+/*********************** see "source_buffer.h" for details ***********************/
+void freeSourceBuffer(sourceBuffer *buffer) {
+    if (buffer->mapped_len > 0) {
+        munmap(buffer->text, buffer->mapped_len);
+    }
+    else {
+        free(buffer->text);
+    }
+    free(buffer);
+}
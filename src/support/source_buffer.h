@@ -0,0 +1,48 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * source_buffer.h - defines an in-memory copy or mapping of a miniC program laid out the way
+ * the scanner reads it in place: the source text followed by two NUL bytes
+ */
+
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <stddef.h>
+
+typedef struct {
+    char *text; // 'len' bytes of source followed by two NUL bytes; writable
+    size_t len;
+    size_t mapped_len; // length of the memory mapping holding 'text', or 0 if it was allocated
+} sourceBuffer;
+
+/*
+ * Params:
+ *      const char *filename: path of the miniC program to load
+ *
+ * Returns:
+ *      a pointer to a newly allocated buffer holding the file's contents, or NULL if the file
+ *      could not be read (an error message is printed to stderr)
+ *
+ * Notes:
+ *      Regular files are mapped privately rather than read, so loading does not copy the
+ *      source; the two NUL bytes come from the zero-filled memory that follows the end of the
+ *      file. Other files (e.g. pipes) are read into an allocated buffer instead.
+ */
+sourceBuffer *mapSourceFile(const char *filename);
+
+/*
+ * Params:
+ *      const char *source: the text of a miniC program (need not be NUL-terminated)
+ *      size_t len: length of 'source' in bytes
+ *
+ * Returns:
+ *      a pointer to a newly allocated buffer holding a copy of 'source'
+ */
+sourceBuffer *copySourceBuffer(const char *source, size_t len);
+
+/*
+ * Unmaps or frees the text of 'buffer' and releases the buffer itself
+ */
+void freeSourceBuffer(sourceBuffer *buffer);
+
+#endif
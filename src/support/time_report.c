@@ -0,0 +1,280 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * time_report.c - implements functions for recording and reporting the time taken by each
+ * compile phase
+ */
+
+#include "time_report.h"
+#include <time.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+/* a single recorded phase */
+typedef struct {
+    std::string name;
+    std::string counter_name;
+    std::string detail;
+    long counter;
+    double start; // wall-clock start, relative to the creation of the report
+    double wall;
+    double cpu;
+    long allocated; // bytes
+    long allocations;
+    long held; // bytes allocated minus bytes freed
+    long peak_rss; // KiB, when the phase ended
+    int tid;
+} phaseEvent;
+
+struct time_Report {
+    std::mutex lock; // guards every field below
+    double origin;
+    std::vector<phaseEvent> events;
+    std::unordered_map<std::thread::id, int> thread_ids; // small, stable ids used in the trace
+};
+
+/***************************************** FUNCTION HEADERS *****************************************/
+void combinePhases(timeReport *report, std::vector<phaseEvent> &rows, std::vector<int> &calls, std::vector<int> &order);
+double readClock(clockid_t clock);
+void writeJSONString(FILE *fp, const std::string &str);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+/*********************** see "time_report.h" for details ***********************/
+timeReport *createTimeReport() {
+    timeReport *report = new timeReport();
+    report->origin = readClock(CLOCK_MONOTONIC);
+    return report;
+}
+
+/*********************** see "time_report.h" for details ***********************/
+timeStamp startTiming() {
+    timeStamp stamp;
+    stamp.wall = readClock(CLOCK_MONOTONIC);
+    stamp.cpu = readClock(CLOCK_THREAD_CPUTIME_ID);
+    stamp.memory = readMemoryCounters();
+    return stamp;
+}
+
+/*********************** see "time_report.h" for details ***********************/
+void recordPhase(timeReport *report, const char *name, timeStamp start,
+                    const char *counter_name, long counter, const char *detail) {
+    if (report == NULL) {
+        return;
+    }
+    timeStamp end = startTiming();
+
+    phaseEvent event;
+    event.name = name;
+    event.counter_name = counter_name != NULL ? counter_name : "";
+    event.detail = detail != NULL ? detail : "";
+    event.counter = counter;
+    event.wall = end.wall - start.wall;
+    event.cpu = end.cpu - start.cpu;
+    event.allocated = end.memory.allocated - start.memory.allocated;
+    event.allocations = end.memory.allocations - start.memory.allocations;
+    event.held = event.allocated - (end.memory.freed - start.memory.freed);
+    event.peak_rss = isMemoryAccountingEnabled() ? readPeakRSS() : 0;
+
+    std::lock_guard<std::mutex> guard(report->lock);
+    event.start = start.wall - report->origin;
+
+    std::thread::id self = std::this_thread::get_id();
+    if (!report->thread_ids.count(self)) {
+        int next_id = report->thread_ids.size() + 1;
+        report->thread_ids.insert(std::pair<std::thread::id, int>(self, next_id));
+    }
+    event.tid = report->thread_ids.at(self);
+    report->events.push_back(event);
+}
+
+/*********************** see "time_report.h" for details ***********************/
+void printTimeReport(timeReport *report, FILE *fp) {
+    std::lock_guard<std::mutex> guard(report->lock);
+    std::vector<phaseEvent> rows;
+    std::vector<int> calls;
+    std::vector<int> order;
+    combinePhases(report, rows, calls, order);
+
+    fprintf(fp, "===-------------------------------------------------------------------===\n");
+    fprintf(fp, "                      miniC compile time report\n");
+    fprintf(fp, "===-------------------------------------------------------------------===\n");
+    fprintf(fp, "  %10s  %10s  %6s  %s\n", "Wall (ms)", "CPU (ms)", "Calls", "Phase");
+    for (int i = 0; i < order.size(); i++) {
+        phaseEvent &row = rows.at(order.at(i));
+        fprintf(fp, "  %10.3f  %10.3f  %6d  %s", row.wall / 1000.0, row.cpu / 1000.0, calls.at(order.at(i)), row.name.c_str());
+        if (!row.counter_name.empty()) {
+            fprintf(fp, " (%s: %ld)", row.counter_name.c_str(), row.counter);
+        }
+        fprintf(fp, "\n");
+    }
+}
+
+/*********************** see "time_report.h" for details ***********************/
+void printMemoryReport(timeReport *report, FILE *fp) {
+    std::lock_guard<std::mutex> guard(report->lock);
+    std::vector<phaseEvent> rows;
+    std::vector<int> calls;
+    std::vector<int> order;
+    combinePhases(report, rows, calls, order);
+
+    fprintf(fp, "===-------------------------------------------------------------------===\n");
+    fprintf(fp, "                     miniC compile memory report\n");
+    fprintf(fp, "===-------------------------------------------------------------------===\n");
+    fprintf(fp, "  %15s  %11s  %12s  %14s  %6s  %s\n", "Allocated (KiB)", "Allocations", "Held (KiB)",
+        "Peak RSS (KiB)", "Calls", "Phase");
+    for (int i = 0; i < order.size(); i++) {
+        phaseEvent &row = rows.at(order.at(i));
+        fprintf(fp, "  %15.1f  %11ld  %12.1f  %14ld  %6d  %s\n", row.allocated / 1024.0, row.allocations,
+            row.held / 1024.0, row.peak_rss, calls.at(order.at(i)), row.name.c_str());
+    }
+    fprintf(fp, "  Peak RSS of the process: %ld KiB\n", readPeakRSS());
+}
+
+/*********************** see "time_report.h" for details ***********************/
+bool writeMemoryReport(timeReport *report, const char *filename) {
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: unable to open '%s' for writing\n", filename);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(report->lock);
+    std::vector<phaseEvent> rows;
+    std::vector<int> calls;
+    std::vector<int> order;
+    combinePhases(report, rows, calls, order);
+
+    fprintf(fp, "{\"peak_rss_kib\":%ld,\"phases\":[\n", readPeakRSS());
+    for (int i = 0; i < order.size(); i++) {
+        phaseEvent &row = rows.at(order.at(i));
+        fprintf(fp, "{\"name\":");
+        writeJSONString(fp, row.name);
+        fprintf(fp, ",\"calls\":%d,\"allocated_bytes\":%ld,\"allocations\":%ld,\"held_bytes\":%ld,\"peak_rss_kib\":%ld}%s\n",
+            calls.at(order.at(i)), row.allocated, row.allocations, row.held, row.peak_rss, i + 1 < order.size() ? "," : "");
+    }
+    fprintf(fp, "]}\n");
+    bool ok = !ferror(fp);
+    ok = fclose(fp) == 0 && ok;
+    return ok;
+}
+
+/*********************** see "time_report.h" for details ***********************/
+void getPhaseTotals(timeReport *report, std::vector<std::string> &names, std::vector<double> &wall) {
+    std::lock_guard<std::mutex> guard(report->lock);
+    std::vector<phaseEvent> rows;
+    std::vector<int> calls;
+    std::vector<int> order;
+    combinePhases(report, rows, calls, order);
+
+    for (int i = 0; i < order.size(); i++) {
+        names.push_back(rows.at(order.at(i)).name);
+        wall.push_back(rows.at(order.at(i)).wall);
+    }
+}
+
+/*********************** see "time_report.h" for details ***********************/
+bool writeChromeTrace(timeReport *report, const char *filename) {
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: unable to open '%s' for writing\n", filename);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(report->lock);
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int i = 0; i < report->events.size(); i++) {
+        phaseEvent &event = report->events.at(i);
+        fprintf(fp, "{\"name\":");
+        writeJSONString(fp, event.name);
+        fprintf(fp, ",\"cat\":\"compile\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"cpu_us\":%.3f",
+            event.tid, event.start, event.wall, event.cpu);
+        if (!event.counter_name.empty()) {
+            fprintf(fp, ",");
+            writeJSONString(fp, event.counter_name);
+            fprintf(fp, ":%ld", event.counter);
+        }
+        if (isMemoryAccountingEnabled()) {
+            fprintf(fp, ",\"allocated_bytes\":%ld,\"allocations\":%ld,\"held_bytes\":%ld", event.allocated,
+                event.allocations, event.held);
+        }
+        if (!event.detail.empty()) {
+            fprintf(fp, ",\"detail\":");
+            writeJSONString(fp, event.detail);
+        }
+        fprintf(fp, "}}%s\n", i + 1 < report->events.size() ? "," : "");
+    }
+    fprintf(fp, "]}\n");
+    fclose(fp);
+    return true;
+}
+
+/*********************** see "time_report.h" for details ***********************/
+void freeTimeReport(timeReport *report) {
+    delete report;
+}
+
+/* combines the events of 'report' with the same name into one row of 'rows', counting them in
+   'calls'; 'order' receives the indices of the rows ordered by when each phase first started.
+   The caller must hold the report's lock */
+void combinePhases(timeReport *report, std::vector<phaseEvent> &rows, std::vector<int> &calls, std::vector<int> &order) {
+    std::unordered_map<std::string, int> row_index;
+    for (int i = 0; i < report->events.size(); i++) {
+        phaseEvent &event = report->events.at(i);
+        if (!row_index.count(event.name)) {
+            row_index.insert(std::pair<std::string, int>(event.name, rows.size()));
+            rows.push_back(event);
+            calls.push_back(1);
+            continue;
+        }
+        int idx = row_index.at(event.name);
+        phaseEvent &row = rows.at(idx);
+        row.wall += event.wall;
+        row.cpu += event.cpu;
+        row.counter += event.counter;
+        row.allocated += event.allocated;
+        row.allocations += event.allocations;
+        row.held += event.held;
+        if (event.peak_rss > row.peak_rss) {
+            row.peak_rss = event.peak_rss;
+        }
+        if (event.start < row.start) {
+            row.start = event.start;
+        }
+        calls.at(idx) += 1;
+    }
+
+    for (int i = 0; i < rows.size(); i++) {
+        order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&rows](int a, int b) { return rows.at(a).start < rows.at(b).start; });
+}
+
+// reads 'clock' in microseconds
+double readClock(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// writes 'str' as a quoted JSON string, escaping characters JSON does not allow verbatim
+void writeJSONString(FILE *fp, const std::string &str) {
+    fputc('"', fp);
+    for (int i = 0; i < str.size(); i++) {
+        unsigned char c = str.at(i);
+        if (c == '"' || c == '\\') {
+            fprintf(fp, "\\%c", c);
+        }
+        else if (c < 0x20) {
+            fprintf(fp, "\\u%04x", c);
+        }
+        else {
+            fputc(c, fp);
+        }
+    }
+    fputc('"', fp);
+}
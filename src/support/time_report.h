@@ -0,0 +1,105 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * time_report.h - defines functions for recording how much wall-clock and CPU time each
+ * compile phase takes, and for reporting it as a table or as a Chrome trace-event file
+ */
+
+#ifndef TIME_REPORT_H
+#define TIME_REPORT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string>
+#include <vector>
+#include "memory_counter.h"
+
+struct time_Report;
+typedef struct time_Report timeReport;
+
+/*
+ * A point in time as seen by both clocks, in microseconds, together with the allocation
+ * counters of the calling thread (see memory_counter.h)
+ */
+typedef struct {
+    double wall; // monotonic wall-clock time
+    double cpu; // CPU time consumed by the calling thread
+    memoryCounters memory;
+} timeStamp;
+
+/*
+ * Returns:
+ *      a pointer to a newly allocated, empty time report. A report may be shared by
+ *      several threads; every function below is safe to call concurrently.
+ */
+timeReport *createTimeReport();
+
+/*
+ * Returns:
+ *      the current time on both clocks; pass it to recordPhase() once the phase ends
+ */
+timeStamp startTiming();
+
+/*
+ * Params:
+ *      timeReport *report: the report to add the phase to; if NULL, nothing is recorded
+ *      const char *name: name of the phase. Nested phases use '/' separated paths
+ *      (e.g. "optimize/func/iteration 1/foldConstants")
+ *      timeStamp start: the value startTiming() returned when the phase began
+ *      const char *counter_name: optional label of a count attached to the phase
+ *      (e.g. "changed" for the number of instructions an optimization pass changed)
+ *      long counter: the count itself; ignored if 'counter_name' is NULL
+ *      const char *detail: optional text that is only shown in the trace (e.g. a file name)
+ */
+void recordPhase(timeReport *report, const char *name, timeStamp start,
+                    const char *counter_name = NULL, long counter = 0, const char *detail = NULL);
+
+/*
+ * Writes a table of the recorded phases to 'fp'. Phases with the same name (e.g. the same
+ * phase of several files compiled in batch mode) are combined into a single row.
+ */
+void printTimeReport(timeReport *report, FILE *fp);
+
+/*
+ * Writes a table of the memory each recorded phase allocated to 'fp': bytes and number of
+ * allocations, the bytes the phase still held when it ended (allocated minus freed, negative if
+ * it freed more than it allocated), and the peak resident set size of the process when it
+ * ended. Phases are combined by name as in printTimeReport(). The counts are only recorded
+ * while memory accounting is enabled (see enableMemoryAccounting()).
+ */
+void printMemoryReport(timeReport *report, FILE *fp);
+
+/*
+ * Writes the same data as printMemoryReport() to 'filename' as JSON
+ *
+ * Returns:
+ *      TRUE, if the file was written successfully
+ *      FALSE, otherwise
+ */
+bool writeMemoryReport(timeReport *report, const char *filename);
+
+/*
+ * Params:
+ *      timeReport *report: the report to read
+ *      std::vector<std::string> &names: receives the name of every recorded phase, ordered by
+ *      when it first started; phases with the same name appear once, as in printTimeReport()
+ *      std::vector<double> &wall: receives the total wall-clock time of each phase in
+ *      microseconds
+ */
+void getPhaseTotals(timeReport *report, std::vector<std::string> &names, std::vector<double> &wall);
+
+/*
+ * Writes every recorded phase to 'filename' in the Chrome trace-event JSON format, which can
+ * be loaded into chrome://tracing or https://ui.perfetto.dev
+ *
+ * Returns:
+ *      TRUE, if the file was written successfully
+ *      FALSE, otherwise
+ */
+bool writeChromeTrace(timeReport *report, const char *filename);
+
+/*
+ * Releases all memory associated with 'report'
+ */
+void freeTimeReport(timeReport *report);
+
+#endif
@@ -0,0 +1,170 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * ast_cache_benchmark.c - checks the AST files of "ast/ast_file.h": that each miniC program's
+ * AST comes back from its file unchanged and that damaged or stale files are rejected, then
+ * reports how much faster mapping the file is than parsing the program
+ *
+ * Usage: ./ast_cache_benchmark [--runs N] [--dir dir] miniC-file...
+ *
+ * Options:
+ *        --runs N               timed passes over each program; the fastest is reported (default 5)
+ *        --dir dir              where the AST files are written (default: the current directory);
+ *                               they are removed afterwards
+ *
+ * Returns 0 on success, 1 if a program could not be read or parsed or a check failed, and 2 on
+ * a usage error.
+ */
+
+#include "../ast/ast_file.h"
+#include "../parser/parser.h"
+#include "../support/source_buffer.h"
+#include "../support/time_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+/* the fastest of the timed runs, in microseconds */
+typedef struct {
+    double parse;
+    double load;
+} astTimes;
+
+/***************************************** FUNCTION HEADERS *****************************************/
+bool sameAST(const flatAST *a, const flatAST *b);
+bool checkRoundTrip(const flatAST *ast, const char *path, size_t len, const char *input);
+bool checkRejected(const std::string &contents, size_t len, const char *what, const char *input);
+astTimes timeLoading(sourceBuffer *source, const char *path, int runs);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+int main(int argc, char **argv) {
+    int runs = 5;
+    const char *dir = ".";
+    std::vector<const char *> inputs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        }
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: unknown or incomplete option '%s'\n", argv[i]);
+            return 2;
+        }
+        else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (runs < 1 || inputs.empty()) {
+        fprintf(stderr, "Usage: %s [--runs N] [--dir dir] miniC-file...\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    std::string path = std::string(dir) + "/ast_cache_benchmark." + std::to_string(getpid()) + ".ast";
+    printf("%-40s %10s %10s %10s %10s %10s %8s\n", "Program", "Nodes", "Source KB", "AST KB", "Parse (ms)",
+        "Load (ms)", "Speedup");
+    for (int i = 0; i < inputs.size(); i++) {
+        sourceBuffer *source = mapSourceFile(inputs.at(i));
+        if (source == NULL) {
+            ok = false;
+            continue;
+        }
+        flatAST *ast = parse(source->text, source->len);
+        if (ast == NULL) {
+            fprintf(stderr, "Error: unable to parse '%s'\n", inputs.at(i));
+            ok = false;
+            freeSourceBuffer(source);
+            continue;
+        }
+
+        std::string contents;
+        encodeFlatAST(ast, source->len, contents);
+        std::string stale_version(contents);
+        stale_version[offsetof(astFileHeader, version)]++;
+        std::string bad_size(contents);
+        memset(&bad_size[sizeof(astFileHeader)], 0xff, sizeof(astIndex));
+        bool checked = checkRoundTrip(ast, path.c_str(), source->len, inputs.at(i))
+            && checkRejected(contents.substr(0, contents.size() - 1), source->len, "a truncated file", inputs.at(i))
+            && checkRejected(contents, source->len + 1, "a file for another source", inputs.at(i))
+            && checkRejected(stale_version, source->len, "a file of another version", inputs.at(i))
+            && checkRejected(bad_size, source->len, "a file with an out-of-range subtree", inputs.at(i));
+        if (!checked) {
+            ok = false;
+        }
+        else {
+            astTimes times = timeLoading(source, path.c_str(), runs);
+            printf("%-40s %10zu %10.1f %10.1f %10.3f %10.3f %7.1fx\n", inputs.at(i), ast->kinds.size(),
+                source->len / 1024.0, contents.size() / 1024.0, times.parse / 1000.0, times.load / 1000.0,
+                times.load > 0 ? times.parse / times.load : 0.0);
+        }
+        unlink(path.c_str());
+        freeFlatAST(ast);
+        freeSourceBuffer(source);
+    }
+    return ok ? 0 : 1;
+}
+
+/* returns true if 'a' and 'b' have the same nodes */
+bool sameAST(const flatAST *a, const flatAST *b) {
+    return a->kinds == b->kinds && a->data == b->data && a->sizes == b->sizes;
+}
+
+/* writes 'ast' to 'path' and maps it back; returns true if that gives the same AST, otherwise
+   prints an error */
+bool checkRoundTrip(const flatAST *ast, const char *path, size_t len, const char *input) {
+    if (writeASTFile(path, ast, len) == 0) {
+        fprintf(stderr, "Error: unable to write '%s'\n", path);
+        return false;
+    }
+    flatAST *loaded = mapASTFile(path, len);
+    bool same = loaded != NULL && sameAST(ast, loaded);
+    if (!same) {
+        fprintf(stderr, "Error: the AST of '%s' did not survive being written and mapped back\n", input);
+    }
+    if (loaded != NULL) {
+        freeFlatAST(loaded);
+    }
+    return same;
+}
+
+/* returns true if decodeFlatAST() rejects 'contents' for a source of length 'len', otherwise
+   prints an error naming 'what' was accepted */
+bool checkRejected(const std::string &contents, size_t len, const char *what, const char *input) {
+    flatAST *ast = decodeFlatAST(contents.data(), contents.size(), len);
+    if (ast == NULL) {
+        return true;
+    }
+    fprintf(stderr, "Error: %s was accepted for '%s'\n", what, input);
+    freeFlatAST(ast);
+    return false;
+}
+
+/* times parsing 'source' against mapping its AST back from 'path' */
+astTimes timeLoading(sourceBuffer *source, const char *path, int runs) {
+    astTimes best = {0, 0};
+    for (int run = 0; run < runs; run++) {
+        timeStamp start = startTiming();
+        flatAST *parsed = parse(source->text, source->len);
+        timeStamp middle = startTiming();
+        flatAST *loaded = mapASTFile(path, source->len);
+        timeStamp end = startTiming();
+        freeFlatAST(parsed);
+        freeFlatAST(loaded);
+
+        double parse_time = middle.wall - start.wall;
+        double load = end.wall - middle.wall;
+        if (run == 0 || parse_time < best.parse) {
+            best.parse = parse_time;
+        }
+        if (run == 0 || load < best.load) {
+            best.load = load;
+        }
+    }
+    return best;
+}
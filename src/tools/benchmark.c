@@ -0,0 +1,449 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * benchmark.c - times each phase of the compiler over repeated in-process compiles of a set of
+ * miniC programs, and compares the results against a stored baseline
+ *
+ * Usage: ./benchmark [options] miniC-file...
+ *
+ * Options:
+ *        --runs N               number of timed compiles of each program (default 10)
+ *        --warmup N             number of untimed compiles of each program before the timed ones (default 2)
+ *        -j N                   threads the functions of each program are compiled on (default 1)
+ *        --json file            write the results to 'file' as JSON
+ *        --baseline file        compare the results against a JSON file written by an earlier run
+ *        --threshold percent    a stage regressed if its median grew by more than this (default 10)
+ *        --min-delta ms         ...and by more than this many milliseconds (default 0.05)
+ *
+ * Returns 0 on success, 1 if a program failed to compile or a stage regressed against the
+ * baseline, and 2 on a usage error.
+ */
+
+#include "../driver/driver.h"
+#include "../support/file_io.h"
+#include "../support/time_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+typedef struct {
+    int runs;
+    int warmup;
+    int num_threads;
+    const char *json_path;
+    const char *baseline_path;
+    double threshold; // percent
+    double min_delta; // microseconds
+    std::vector<std::string> inputs;
+} benchOptions;
+
+/* wall-clock samples of one stage of the compile, in microseconds, one per timed run */
+typedef struct {
+    std::string name;
+    std::vector<double> samples;
+} stageSamples;
+
+/* the results of benchmarking one program */
+typedef struct {
+    std::string input;
+    long bytes;
+    std::vector<stageSamples> stages; // in the order the stages ran
+} benchResult;
+
+/* a parsed JSON value; only what the results file uses */
+typedef struct json_Value {
+    enum { JSON_NULL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT } kind;
+    double number;
+    std::string string;
+    std::vector<struct json_Value> items;
+    std::vector<std::pair<std::string, struct json_Value>> members;
+} jsonValue;
+
+/***************************************** FUNCTION HEADERS *****************************************/
+bool parseOptions(int argc, char **argv, benchOptions *options);
+bool benchmarkProgram(benchOptions *options, const std::string &input, benchResult &result);
+void addSample(benchResult &result, const std::string &stage, double wall);
+std::string getStageName(const std::string &phase);
+double getPercentile(std::vector<double> samples, double percent);
+void printResults(std::vector<benchResult> &results, FILE *fp);
+bool writeResults(benchOptions *options, std::vector<benchResult> &results);
+bool compareResults(benchOptions *options, std::vector<benchResult> &results, bool *regressed);
+const jsonValue *getMember(const jsonValue *object, const char *name);
+bool parseJSON(const char *&p, jsonValue &value);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+int main(int argc, char **argv) {
+    benchOptions options;
+    if (!parseOptions(argc, argv, &options)) {
+        return 2;
+    }
+
+    bool ok = true;
+    std::vector<benchResult> results;
+    for (int i = 0; i < options.inputs.size(); i++) {
+        benchResult result;
+        if (!benchmarkProgram(&options, options.inputs.at(i), result)) {
+            ok = false;
+            continue;
+        }
+        results.push_back(result);
+    }
+
+    printResults(results, stdout);
+    if (options.json_path != NULL && !writeResults(&options, results)) {
+        ok = false;
+    }
+
+    if (options.baseline_path != NULL) {
+        bool regressed = false;
+        if (!compareResults(&options, results, &regressed) || regressed) {
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+/* compiles 'input' options->warmup + options->runs times, recording the wall-clock time of
+   each stage of the timed runs in 'result'; returns false if the program does not compile */
+bool benchmarkProgram(benchOptions *options, const std::string &input, benchResult &result) {
+    std::string source;
+    if (!readFile(input.c_str(), source)) {
+        fprintf(stderr, "Error: unable to read '%s'\n", input.c_str());
+        return false;
+    }
+    result.input = input;
+    result.bytes = source.size();
+
+    for (int run = 0; run < options->warmup + options->runs; run++) {
+        timeReport *report = createTimeReport();
+        std::string ll_text;
+        std::string s_text;
+        timeStamp start = startTiming();
+        compile_status status = compileSource(source.data(), source.size(), input.c_str(), &ll_text, NULL, &s_text,
+                                                report, NULL, options->num_threads);
+        timeStamp end = startTiming();
+
+        if (status != COMPILE_OK) {
+            fprintf(stderr, "Error: '%s' failed to compile\n", input.c_str());
+            freeTimeReport(report);
+            return false;
+        }
+
+        if (run >= options->warmup) {
+            std::vector<std::string> names;
+            std::vector<double> wall;
+            getPhaseTotals(report, names, wall);
+
+            // several phases can map to the same stage (e.g. a pass in every fixpoint iteration)
+            std::vector<std::string> stages;
+            std::unordered_map<std::string, double> stage_wall;
+            for (int i = 0; i < names.size(); i++) {
+                std::string stage = getStageName(names.at(i));
+                if (stage.empty()) {
+                    continue;
+                }
+                if (!stage_wall.count(stage)) {
+                    stages.push_back(stage);
+                    stage_wall.insert(std::pair<std::string, double>(stage, 0));
+                }
+                stage_wall.at(stage) += wall.at(i);
+            }
+            for (int i = 0; i < stages.size(); i++) {
+                addSample(result, stages.at(i), stage_wall.at(stages.at(i)));
+            }
+            addSample(result, "total", end.wall - start.wall);
+        }
+        freeTimeReport(report);
+    }
+    return true;
+}
+
+/* adds a sample of 'wall' microseconds to 'stage' */
+void addSample(benchResult &result, const std::string &stage, double wall) {
+    for (int i = 0; i < result.stages.size(); i++) {
+        if (result.stages.at(i).name == stage) {
+            result.stages.at(i).samples.push_back(wall);
+            return;
+        }
+    }
+    stageSamples samples;
+    samples.name = stage;
+    samples.samples.push_back(wall);
+    result.stages.push_back(samples);
+}
+
+/* maps a phase of the time report to the stage it is benchmarked as: top-level phases keep
+   their name, and "optimize/<function>/iteration <n>/<pass>" becomes "optimize/<pass>", summed
+   over every function and iteration. Returns "" for the phases that are not benchmarked (the
+   whole compile, which is timed as "total", and the per-function and per-iteration subtotals of
+   the optimizer) */
+std::string getStageName(const std::string &phase) {
+    if (phase == "compileBuffer") {
+        return ""; // the same as "total", minus the call itself
+    }
+    if (phase.find('/') == std::string::npos) {
+        return phase;
+    }
+    if (phase.compare(0, strlen("optimize/"), "optimize/") != 0 || std::count(phase.begin(), phase.end(), '/') != 3) {
+        return "";
+    }
+    return "optimize/" + phase.substr(phase.rfind('/') + 1);
+}
+
+/* returns the nearest-rank 'percent'th percentile of 'samples' */
+double getPercentile(std::vector<double> samples, double percent) {
+    std::sort(samples.begin(), samples.end());
+    int rank = (int)ceil(percent / 100.0 * samples.size());
+    if (rank < 1) {
+        rank = 1;
+    }
+    return samples.at(rank - 1);
+}
+
+/* writes a table with the median, 90th and 99th percentile of every stage to 'fp' */
+void printResults(std::vector<benchResult> &results, FILE *fp) {
+    fprintf(fp, "  %10s  %10s  %10s  %10s  %s\n", "Median(ms)", "p90 (ms)", "p99 (ms)", "Min (ms)", "Stage");
+    for (int i = 0; i < results.size(); i++) {
+        benchResult &result = results.at(i);
+        fprintf(fp, "%s (%ld bytes, %zu runs)\n", result.input.c_str(), result.bytes,
+            result.stages.empty() ? 0 : result.stages.at(0).samples.size());
+        for (int j = 0; j < result.stages.size(); j++) {
+            stageSamples &stage = result.stages.at(j);
+            fprintf(fp, "  %10.3f  %10.3f  %10.3f  %10.3f  %s\n", getPercentile(stage.samples, 50) / 1000.0,
+                getPercentile(stage.samples, 90) / 1000.0, getPercentile(stage.samples, 99) / 1000.0,
+                getPercentile(stage.samples, 0) / 1000.0, stage.name.c_str());
+        }
+    }
+}
+
+/* writes 'results' to options->json_path; returns false if the file could not be written */
+bool writeResults(benchOptions *options, std::vector<benchResult> &results) {
+    std::string json = "{\n  \"version\": 1,\n";
+    json += "  \"runs\": " + std::to_string(options->runs) + ",\n";
+    json += "  \"warmup\": " + std::to_string(options->warmup) + ",\n";
+    json += "  \"threads\": " + std::to_string(options->num_threads) + ",\n";
+    json += "  \"benchmarks\": [";
+    for (int i = 0; i < results.size(); i++) {
+        benchResult &result = results.at(i);
+        // file names are used as they are: the corpus has no characters JSON would need escaped
+        json += std::string(i > 0 ? "," : "") + "\n    {\n      \"input\": \"" + result.input + "\",\n";
+        json += "      \"bytes\": " + std::to_string(result.bytes) + ",\n";
+        json += "      \"stages\": {";
+        for (int j = 0; j < result.stages.size(); j++) {
+            stageSamples &stage = result.stages.at(j);
+            char line[512];
+            snprintf(line, sizeof(line), "%s\n        \"%s\": {\"median_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, "
+                "\"min_us\": %.3f, \"max_us\": %.3f}", j > 0 ? "," : "", stage.name.c_str(),
+                getPercentile(stage.samples, 50), getPercentile(stage.samples, 90), getPercentile(stage.samples, 99),
+                getPercentile(stage.samples, 0), getPercentile(stage.samples, 100));
+            json += line;
+        }
+        json += "\n      }\n    }";
+    }
+    json += "\n  ]\n}\n";
+
+    if (!writeFile(options->json_path, json)) {
+        fprintf(stderr, "Error: unable to write '%s'\n", options->json_path);
+        return false;
+    }
+    return true;
+}
+
+/* compares the median of every stage in 'results' with the one recorded for the same program
+   and stage in options->baseline_path, and prints the stages that regressed; sets 'regressed'
+   if any did. Returns false if the baseline could not be read */
+bool compareResults(benchOptions *options, std::vector<benchResult> &results, bool *regressed) {
+    std::string text;
+    jsonValue baseline;
+    const char *p = NULL;
+    if (readFile(options->baseline_path, text)) {
+        p = text.c_str();
+    }
+    const jsonValue *benchmarks = NULL;
+    if (p == NULL || !parseJSON(p, baseline) || (benchmarks = getMember(&baseline, "benchmarks")) == NULL
+            || benchmarks->kind != jsonValue::JSON_ARRAY) {
+        fprintf(stderr, "Error: unable to read the baseline '%s'\n", options->baseline_path);
+        return false;
+    }
+
+    printf("Compared with %s (threshold %.1f%%, at least %.3f ms):\n", options->baseline_path,
+        options->threshold, options->min_delta / 1000.0);
+    int compared = 0;
+    int regressions = 0;
+    for (int i = 0; i < results.size(); i++) {
+        benchResult &result = results.at(i);
+        const jsonValue *stages = NULL;
+        for (int j = 0; j < benchmarks->items.size(); j++) {
+            const jsonValue *input = getMember(&benchmarks->items.at(j), "input");
+            if (input != NULL && input->string == result.input) {
+                stages = getMember(&benchmarks->items.at(j), "stages");
+            }
+        }
+        if (stages == NULL) {
+            printf("  %s: not in the baseline\n", result.input.c_str());
+            continue;
+        }
+
+        for (int j = 0; j < result.stages.size(); j++) {
+            stageSamples &stage = result.stages.at(j);
+            const jsonValue *old_stage = getMember(stages, stage.name.c_str());
+            const jsonValue *old_median = old_stage != NULL ? getMember(old_stage, "median_us") : NULL;
+            if (old_median == NULL || old_median->kind != jsonValue::JSON_NUMBER) {
+                continue;
+            }
+            compared++;
+            double median = getPercentile(stage.samples, 50);
+            double delta = median - old_median->number;
+            if (delta > options->min_delta && delta > old_median->number * options->threshold / 100.0) {
+                printf("  REGRESSION %s %s: %.3f ms -> %.3f ms (+%.1f%%)\n", result.input.c_str(), stage.name.c_str(),
+                    old_median->number / 1000.0, median / 1000.0,
+                    old_median->number > 0 ? delta / old_median->number * 100.0 : 100.0);
+                regressions++;
+            }
+        }
+    }
+    printf("  %d stage(s) compared, %d regressed\n", compared, regressions);
+    *regressed = regressions > 0;
+    return true;
+}
+
+/* returns the member of 'object' called 'name', or NULL if there is none */
+const jsonValue *getMember(const jsonValue *object, const char *name) {
+    if (object->kind != jsonValue::JSON_OBJECT) {
+        return NULL;
+    }
+    for (int i = 0; i < object->members.size(); i++) {
+        if (object->members.at(i).first == name) {
+            return &object->members.at(i).second;
+        }
+    }
+    return NULL;
+}
+
+/* parses the JSON value starting at 'p' into 'value' and advances 'p' past it; returns false
+   on a syntax error. Handles the subset of JSON the results file is written in (no escapes
+   other than \" and \\, no true/false) */
+bool parseJSON(const char *&p, jsonValue &value) {
+    while (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r') {
+        p++;
+    }
+
+    if (*p == '{' || *p == '[') {
+        bool object = *p == '{';
+        char close = object ? '}' : ']';
+        value.kind = object ? jsonValue::JSON_OBJECT : jsonValue::JSON_ARRAY;
+        p++;
+        while (true) {
+            while (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r' || *p == ',') {
+                p++;
+            }
+            if (*p == close) {
+                p++;
+                return true;
+            }
+            jsonValue item;
+            if (!parseJSON(p, item)) {
+                return false;
+            }
+            if (!object) {
+                value.items.push_back(item);
+                continue;
+            }
+
+            // an object member: the key just parsed, then ':' and the value
+            while (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r') {
+                p++;
+            }
+            jsonValue member;
+            if (item.kind != jsonValue::JSON_STRING || *p++ != ':' || !parseJSON(p, member)) {
+                return false;
+            }
+            value.members.push_back(std::pair<std::string, jsonValue>(item.string, member));
+        }
+    }
+    if (*p == '"') {
+        value.kind = jsonValue::JSON_STRING;
+        for (p++; *p != '"'; p++) {
+            if (*p == '\0') {
+                return false;
+            }
+            if (*p == '\\' && p[1] != '\0') {
+                p++;
+            }
+            value.string.push_back(*p);
+        }
+        p++;
+        return true;
+    }
+    if (strncmp(p, "null", 4) == 0) {
+        value.kind = jsonValue::JSON_NULL;
+        p += 4;
+        return true;
+    }
+
+    char *end;
+    value.kind = jsonValue::JSON_NUMBER;
+    value.number = strtod(p, &end);
+    if (end == p) {
+        return false;
+    }
+    p = end;
+    return true;
+}
+
+/* fills 'options' from the command line; returns false (after printing an error) if an
+   option is unknown or out of range */
+bool parseOptions(int argc, char **argv, benchOptions *options) {
+    options->runs = 10;
+    options->warmup = 2;
+    options->num_threads = 1;
+    options->json_path = NULL;
+    options->baseline_path = NULL;
+    options->threshold = 10.0;
+    options->min_delta = 50.0;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--runs") == 0 && has_value) {
+            options->runs = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && has_value) {
+            options->warmup = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-j") == 0 && has_value) {
+            options->num_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--json") == 0 && has_value) {
+            options->json_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && has_value) {
+            options->baseline_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threshold") == 0 && has_value) {
+            options->threshold = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--min-delta") == 0 && has_value) {
+            options->min_delta = atof(argv[++i]) * 1000.0;
+        }
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: unknown or incomplete option '%s'\n", argv[i]);
+            return false;
+        }
+        else {
+            options->inputs.push_back(argv[i]);
+        }
+    }
+
+    if (options->runs < 1 || options->warmup < 0 || options->inputs.empty()) {
+        fprintf(stderr, "Usage: %s [--runs N] [--warmup N] [-j N] [--json file] [--baseline file] "
+            "[--threshold percent] [--min-delta ms] miniC-file...\n", argv[0]);
+        return false;
+    }
+    return true;
+}
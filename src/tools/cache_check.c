@@ -0,0 +1,152 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * cache_check.c - checks the compile cache of "driver/compile_cache.h": compiles every miniC
+ * program through a fresh cache under its own path and under a second one, twice each, and checks
+ * that every compile gives exactly the outputs of an uncached compile under the same path. The
+ * outputs name the program (in the '.file' directive, the module ID and the source filename), so
+ * the same source under another path must never be served the first path's entry. Both the
+ * whole-program and the per-function cache are checked.
+ *
+ * Usage: ./cache_check [--dir dir] miniC-file...
+ *
+ * Options:
+ *        --dir dir              where the caches are created (default: the current directory);
+ *                               they are removed afterwards
+ *
+ * Returns 0 if every compile matched, 1 if a program could not be read or compiled or an output
+ * differed, and 2 on a usage error.
+ */
+
+#include "../driver/driver.h"
+#include "../driver/compile_cache.h"
+#include "../support/file_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+
+/* the outputs of one compile */
+typedef struct {
+    std::string ll;
+    std::string s;
+} compileOutputs;
+
+/***************************************** FUNCTION HEADERS *****************************************/
+bool compileOutputsOf(const std::string &source, const char *module_name, compileCache *cache, compileOutputs *outputs);
+int checkCache(const std::string &source, const std::vector<std::string> &names, const char *dir, bool per_function);
+void removeCacheDir(const char *dir);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+int main(int argc, char **argv) {
+    const char *dir = ".";
+    std::vector<const char *> inputs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        }
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: unknown or incomplete option '%s'\n", argv[i]);
+            return 2;
+        }
+        else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        fprintf(stderr, "Usage: %s [--dir dir] miniC-file...\n", argv[0]);
+        return 2;
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < inputs.size(); i++) {
+        std::string source;
+        if (!readFile(inputs.at(i), source)) {
+            fprintf(stderr, "Error: unable to read '%s'\n", inputs.at(i));
+            return 1;
+        }
+
+        // the program under its own path, and the same bytes copied somewhere else
+        std::vector<std::string> names;
+        names.push_back(inputs.at(i));
+        names.push_back(std::string("renamed/") + inputs.at(i));
+
+        int failed = checkCache(source, names, dir, false) + checkCache(source, names, dir, true);
+        printf("%-40s %s\n", inputs.at(i), failed == 0 ? "ok" : "MISMATCH");
+        mismatches += failed;
+    }
+
+    printf("%d program(s) checked, %d mismatch(es)\n", (int)inputs.size(), mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+/* compiles 'source' as 'module_name' on one thread, through 'cache' if it is not NULL, into
+   'outputs'; returns false (after printing why) if the compile failed */
+bool compileOutputsOf(const std::string &source, const char *module_name, compileCache *cache, compileOutputs *outputs) {
+    compile_status status = compileSource(source.data(), source.size(), module_name, &outputs->ll, NULL, &outputs->s,
+                                            NULL, cache);
+    if (status != COMPILE_OK) {
+        fprintf(stderr, "Error: '%s' failed to compile\n", module_name);
+        return false;
+    }
+    return true;
+}
+
+/* compiles 'source' under each of 'names' in turn, twice over, through a new cache in 'dir' (of
+   whole programs, or of functions if 'per_function' is TRUE), so the later compiles are served
+   from the entries of the earlier ones; returns the number of compiles whose outputs differ from
+   those of an uncached compile under the same name */
+int checkCache(const std::string &source, const std::vector<std::string> &names, const char *dir, bool per_function) {
+    std::vector<compileOutputs> expected(names.size());
+    for (int i = 0; i < names.size(); i++) {
+        if (!compileOutputsOf(source, names.at(i).c_str(), NULL, &expected.at(i))) {
+            return 1;
+        }
+    }
+
+    std::string cache_dir = std::string(dir) + "/cache_check." + std::to_string(getpid());
+    compileCache *cache = createCompileCache(cache_dir.c_str(), COMPILE_CACHE_DEFAULT_SIZE, "", per_function);
+    if (cache == NULL) {
+        return 1;
+    }
+
+    int mismatches = 0;
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < names.size(); i++) {
+            compileOutputs outputs;
+            if (!compileOutputsOf(source, names.at(i).c_str(), cache, &outputs)) {
+                mismatches++;
+                continue;
+            }
+            if (outputs.ll != expected.at(i).ll || outputs.s != expected.at(i).s) {
+                fprintf(stderr, "Error: %s cache gave '%s' different outputs on compile %d\n",
+                    per_function ? "per-function" : "whole-program", names.at(i).c_str(), round + 1);
+                mismatches++;
+            }
+        }
+    }
+
+    freeCompileCache(cache);
+    removeCacheDir(cache_dir.c_str());
+    return mismatches;
+}
+
+/* removes the cache directory 'dir' and every file in it */
+void removeCacheDir(const char *dir) {
+    DIR *handle = opendir(dir);
+    if (handle == NULL) {
+        return;
+    }
+    struct dirent *dirent;
+    while ((dirent = readdir(handle)) != NULL) {
+        if (strcmp(dirent->d_name, ".") != 0 && strcmp(dirent->d_name, "..") != 0) {
+            unlink((std::string(dir) + "/" + dirent->d_name).c_str());
+        }
+    }
+    closedir(handle);
+    rmdir(dir);
+}
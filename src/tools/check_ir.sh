@@ -0,0 +1,82 @@
+#!/bin/sh
+# Author: Eric Richardson
+# Dartmouth CS57, Spring 2023
+# check_ir.sh - checks compiling from LLVM IR: each miniC program given is compiled to assembly,
+# textual IR and bitcode with './compile', and both IR files are compiled again, which must give
+# the same assembly as the program itself; every file in ../test/ir_tests, IR outside the subset
+# the compiler supports, must be rejected with an error (status 3) and no output; and the IR files
+# in ../test/optimizer_tests and ../test/final_tests, which clang wrote, must either compile or be
+# rejected, never crash, and the ones outside the subset must be rejected
+#
+# Usage: tools/check_ir.sh [--out-dir dir] miniC-file...
+#
+# Options:
+#        --out-dir dir          directory for the outputs (default ir_check_out)
+#
+# Run it from the 'src' directory after 'make'. The script exits with status 1 if a check fails.
+
+REJECT_DIR=../test/ir_tests
+CLANG_IR="../test/optimizer_tests/*.ll ../test/final_tests/*.ll"
+# clang IR that is outside the subset (test3.ll's function takes two parameters)
+CLANG_REJECTS="../test/optimizer_tests/test3.ll"
+OUT_DIR=ir_check_out
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --out-dir) OUT_DIR=$2; shift 2 ;;
+        -*) echo "Error: unknown option '$1'" >&2; exit 2 ;;
+        *) break ;;
+    esac
+done
+
+mkdir -p "$OUT_DIR" || exit 2
+status=0
+
+# the assembly compiled from each program's IR and bitcode must match the program's
+for program in "$@"; do
+    name=$(basename "$program" .c)
+    if ! ./compile --emit=asm,ll,bc -o "$OUT_DIR/$name.s" "$program" 2> "$OUT_DIR/$name.log"; then
+        printf "%-40s %s\n" "$program" "FAILED (see $OUT_DIR/$name.log)"
+        status=1
+        continue
+    fi
+    result=ok
+    for kind in ll bc; do
+        if ! ./compile -S -o "$OUT_DIR/$name.$kind.s" "$OUT_DIR/$name.$kind" 2>> "$OUT_DIR/$name.log"; then
+            result="FAILED to compile its .$kind (see $OUT_DIR/$name.log)"
+        elif ! cmp -s "$OUT_DIR/$name.s" "$OUT_DIR/$name.$kind.s"; then
+            result="MISMATCH from its .$kind"
+        fi
+    done
+    [ "$result" = ok ] || status=1
+    printf "%-40s %s\n" "$program" "$result"
+done
+
+# IR outside the subset must be rejected with a message, whoever wrote it
+for ir in "$REJECT_DIR"/*.ll $CLANG_REJECTS; do
+    name=$(basename "$ir" .ll)
+    rm -f "$OUT_DIR/$name.rejected.s"
+    ./compile -S -o "$OUT_DIR/$name.rejected.s" "$ir" 2> "$OUT_DIR/$name.rejected.log"
+    rc=$?
+    if [ $rc -eq 3 ] && grep -q "^Error: " "$OUT_DIR/$name.rejected.log" && [ ! -e "$OUT_DIR/$name.rejected.s" ]; then
+        result=rejected
+    else
+        result="NOT REJECTED (status $rc, see $OUT_DIR/$name.rejected.log)"
+        status=1
+    fi
+    printf "%-40s %s\n" "$ir" "$result"
+done
+
+# clang's IR is either in the subset or rejected; anything else (a crash) is a failure
+for ir in $CLANG_IR; do
+    name=$(basename "$ir" .ll)
+    ./compile -S -o "$OUT_DIR/$name.clang.s" "$ir" 2> "$OUT_DIR/$name.clang.log"
+    rc=$?
+    case $rc in
+        0) result=compiled ;;
+        3) result=rejected ;;
+        *) result="FAILED (status $rc, see $OUT_DIR/$name.clang.log)"; status=1 ;;
+    esac
+    printf "%-40s %s\n" "$ir" "$result"
+done
+exit $status
@@ -0,0 +1,346 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * generate_program.c - generates valid miniC programs of a chosen size and shape, for
+ * benchmarking how the compiler scales with the size of its input
+ *
+ * Usage: ./gen_program [options] [-o file]
+ *
+ * Options:
+ *        --statements N         total number of statements (default 1000)
+ *        --functions N          number of functions the statements are spread over (default 1)
+ *        --depth N              maximum nesting depth of if and while statements (default 3)
+ *        --variables N          number of variables declared in each function (default 8)
+ *        --loop-density F       fraction of statements that start a while loop (default 0.05)
+ *        --branch-density F     fraction of statements that start an if statement (default 0.1)
+ *        --const-stores F       fraction of assignments that store a constant (default 0.2)
+ *        --call-density F       fraction of statements that call read or print (default 0.05)
+ *        --seed N               seed of the random number generator (default 1)
+ *        -o file                write the program to 'file' instead of stdout
+ *
+ * The same options and seed always produce the same program, on any platform. Every loop runs
+ * a bounded number of times, so the programs also terminate when they are run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+
+typedef struct {
+    long statements;
+    int functions;
+    int depth;
+    int variables;
+    double loop_density;
+    double branch_density;
+    double const_stores;
+    double call_density;
+    uint64_t seed;
+} generatorOptions;
+
+typedef struct {
+    generatorOptions *options;
+    uint64_t state; // state of the random number generator
+    std::string out; // text of the program, flushed to 'fp' as it grows
+    FILE *fp;
+} generator;
+
+// text is written out in chunks of about this size
+#define FLUSH_SIZE (1 << 20)
+
+/***************************************** FUNCTION HEADERS *****************************************/
+uint64_t nextRandom(generator *gen);
+int randomInt(generator *gen, int n);
+double randomFraction(generator *gen);
+void indent(generator *gen, int depth);
+void appendTerm(generator *gen);
+void appendVar(generator *gen);
+void generateFunction(generator *gen, const char *name, long statements);
+void generateStmts(generator *gen, long statements, int depth);
+void generateSimpleStmt(generator *gen, int depth);
+bool parseOptions(int argc, char **argv, generatorOptions *options, const char **output);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+int main(int argc, char **argv) {
+    generatorOptions options;
+    const char *output = NULL;
+    if (!parseOptions(argc, argv, &options, &output)) {
+        return 2;
+    }
+
+    generator gen;
+    gen.options = &options;
+    gen.state = options.seed;
+    gen.fp = stdout;
+    if (output != NULL) {
+        gen.fp = fopen(output, "w");
+        if (gen.fp == NULL) {
+            fprintf(stderr, "Error: unable to open '%s' for writing\n", output);
+            return 2;
+        }
+    }
+
+    gen.out += "extern void print(int);\nextern int read();\n";
+
+    // a program with a single function calls it 'func', so it can be linked with test/final_tests/main.c
+    for (int i = 0; i < options.functions; i++) {
+        long statements = options.statements / options.functions;
+        if (i < options.statements % options.functions) {
+            statements++;
+        }
+        std::string name = options.functions == 1 ? "func" : "f" + std::to_string(i);
+        generateFunction(&gen, name.c_str(), statements);
+    }
+
+    fwrite(gen.out.data(), 1, gen.out.size(), gen.fp);
+    bool ok = !ferror(gen.fp);
+    if (output != NULL) {
+        ok = fclose(gen.fp) == 0 && ok;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: unable to write the program\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* splitmix64: small, fast, and the same sequence everywhere (unlike the distributions of
+   <random>, whose output depends on the standard library) */
+uint64_t nextRandom(generator *gen) {
+    uint64_t z = (gen->state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// returns a random integer in [0, n)
+int randomInt(generator *gen, int n) {
+    return nextRandom(gen) % n;
+}
+
+// returns a random number in [0, 1)
+double randomFraction(generator *gen) {
+    return (nextRandom(gen) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void indent(generator *gen, int depth) {
+    gen->out.append(depth + 1, '\t');
+}
+
+// appends the name of one of the function's variables
+void appendVar(generator *gen) {
+    gen->out += "v" + std::to_string(randomInt(gen, gen->options->variables));
+}
+
+// appends a variable, the parameter or a constant, possibly negated
+void appendTerm(generator *gen) {
+    int kind = randomInt(gen, 8);
+    if (kind == 0) {
+        gen->out.push_back('-');
+    }
+    if (kind < 4) {
+        appendVar(gen);
+    }
+    else if (kind == 4) {
+        gen->out += "n";
+    }
+    else {
+        gen->out += std::to_string(randomInt(gen, 100));
+    }
+}
+
+/* appends a function with 'statements' statements (counting the final return and the
+   statements that open and close loops) */
+void generateFunction(generator *gen, const char *name, long statements) {
+    generatorOptions *options = gen->options;
+    gen->out += "\nint " + std::string(name) + "(int n){\n";
+
+    // variables, then one loop counter per nesting level so nested loops never share one
+    for (int i = 0; i < options->variables; i++) {
+        gen->out += "\tint v" + std::to_string(i) + ";\n";
+    }
+    for (int i = 0; i < options->depth; i++) {
+        gen->out += "\tint c" + std::to_string(i) + ";\n";
+    }
+
+    // every variable is initialized first, so the program never reads an undefined value
+    for (int i = 0; i < options->variables && i < statements - 1; i++) {
+        gen->out += "\tv" + std::to_string(i) + " = " + std::to_string(randomInt(gen, 100)) + ";\n";
+    }
+    long initialized = options->variables < statements - 1 ? options->variables : statements - 1;
+    if (initialized < 0) {
+        initialized = 0;
+    }
+    generateStmts(gen, statements - 1 - initialized, 0);
+
+    gen->out += "\treturn ";
+    appendVar(gen);
+    gen->out += ";\n}\n";
+}
+
+/* appends exactly 'statements' statements nested 'depth' levels deep */
+void generateStmts(generator *gen, long statements, int depth) {
+    generatorOptions *options = gen->options;
+    while (statements > 0) {
+        if (gen->out.size() > FLUSH_SIZE) {
+            fwrite(gen->out.data(), 1, gen->out.size(), gen->fp);
+            gen->out.clear();
+        }
+
+        double choice = randomFraction(gen);
+        bool can_nest = depth < options->depth;
+
+        // a loop takes at least three statements: the counter reset, the loop itself and the
+        // counter increment inside its body
+        if (can_nest && statements >= 3 && choice < options->loop_density) {
+            long body = 1 + randomInt(gen, statements - 2 < 16 ? statements - 2 : 16);
+            std::string counter = "c" + std::to_string(depth);
+
+            indent(gen, depth);
+            gen->out += counter + " = 0;\n";
+            indent(gen, depth);
+            gen->out += "while (" + counter + " < " + std::to_string(2 + randomInt(gen, 9)) + "){\n";
+            generateStmts(gen, body - 1, depth + 1);
+            indent(gen, depth + 1);
+            gen->out += counter + " = " + counter + " + 1;\n";
+            indent(gen, depth);
+            gen->out += "}\n";
+            statements -= body + 2;
+        }
+        else if (can_nest && statements >= 2 && choice < options->loop_density + options->branch_density) {
+            long body = 1 + randomInt(gen, statements - 1 < 16 ? statements - 1 : 16);
+            static const char *relops[] = { "<", ">", "==", "<=", ">=" };
+
+            indent(gen, depth);
+            gen->out += "if (";
+            appendVar(gen);
+            gen->out += std::string(" ") + relops[randomInt(gen, 5)] + " ";
+            appendTerm(gen);
+            gen->out += "){\n";
+
+            // the statements of the body are split between the if and else branches
+            long else_body = body > 1 && randomInt(gen, 2) ? randomInt(gen, body) : 0;
+            generateStmts(gen, body - else_body, depth + 1);
+            indent(gen, depth);
+            if (else_body > 0) {
+                gen->out += "}\n";
+                indent(gen, depth);
+                gen->out += "else {\n";
+                generateStmts(gen, else_body, depth + 1);
+                indent(gen, depth);
+            }
+            gen->out += "}\n";
+            statements -= body + 1;
+        }
+        else {
+            generateSimpleStmt(gen, depth);
+            statements--;
+        }
+    }
+}
+
+/* appends a single assignment or call */
+void generateSimpleStmt(generator *gen, int depth) {
+    generatorOptions *options = gen->options;
+    indent(gen, depth);
+
+    if (randomFraction(gen) < options->call_density) {
+        if (randomInt(gen, 2)) {
+            gen->out += "print(";
+            appendTerm(gen);
+            gen->out += ");\n";
+        }
+        else {
+            appendVar(gen);
+            gen->out += " = read();\n";
+        }
+        return;
+    }
+
+    appendVar(gen);
+    gen->out += " = ";
+    if (randomFraction(gen) < options->const_stores) {
+        gen->out += std::to_string(randomInt(gen, 1000));
+    }
+    else {
+        // a division is always by a positive constant, so it can neither divide by zero nor
+        // overflow (INT_MIN / -1) when the program is run
+        static const char *ops[] = { " + ", " - ", " * ", " / " };
+        int op = randomInt(gen, 4);
+        appendTerm(gen);
+        gen->out += ops[op];
+        if (op == 3) {
+            gen->out += std::to_string(randomInt(gen, 9) + 1);
+        }
+        else {
+            appendTerm(gen);
+        }
+    }
+    gen->out += ";\n";
+}
+
+/* fills 'options' from the command line; returns false (after printing an error) if an
+   option is unknown or out of range */
+bool parseOptions(int argc, char **argv, generatorOptions *options, const char **output) {
+    options->statements = 1000;
+    options->functions = 1;
+    options->depth = 3;
+    options->variables = 8;
+    options->loop_density = 0.05;
+    options->branch_density = 0.1;
+    options->const_stores = 0.2;
+    options->call_density = 0.05;
+    options->seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Error: unknown or incomplete option '%s'\n", argv[i]);
+            return false;
+        }
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "--statements") == 0) {
+            options->statements = atol(value);
+        }
+        else if (strcmp(argv[i - 1], "--functions") == 0) {
+            options->functions = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--depth") == 0) {
+            options->depth = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--variables") == 0) {
+            options->variables = atoi(value);
+        }
+        else if (strcmp(argv[i - 1], "--loop-density") == 0) {
+            options->loop_density = atof(value);
+        }
+        else if (strcmp(argv[i - 1], "--branch-density") == 0) {
+            options->branch_density = atof(value);
+        }
+        else if (strcmp(argv[i - 1], "--const-stores") == 0) {
+            options->const_stores = atof(value);
+        }
+        else if (strcmp(argv[i - 1], "--call-density") == 0) {
+            options->call_density = atof(value);
+        }
+        else if (strcmp(argv[i - 1], "--seed") == 0) {
+            options->seed = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(argv[i - 1], "-o") == 0) {
+            *output = value;
+        }
+        else {
+            fprintf(stderr, "Error: unknown or incomplete option '%s'\n", argv[i - 1]);
+            return false;
+        }
+    }
+
+    if (options->statements < options->functions || options->functions < 1 || options->depth < 0
+            || options->variables < 1) {
+        fprintf(stderr, "Error: need at least one function, one variable, and one statement per function\n");
+        return false;
+    }
+    return true;
+}
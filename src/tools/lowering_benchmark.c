@@ -0,0 +1,165 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * lowering_benchmark.c - compares the single-pass compile, which lowers a miniC program to IR
+ * while parsing it, with the three passes it replaces (parse to an AST, isValidAST() and
+ * generateIR()): checks that both give the same IR for each program, then reports how fast
+ * each one gets from source to unoptimized IR, and to assembly
+ *
+ * Usage: ./lowering_benchmark [--runs N] miniC-file...
+ *
+ * Options:
+ *        --runs N               timed passes over each program; the fastest is reported (default 5)
+ *
+ * Returns 0 on success, 1 if a program could not be read or compiled or the two pipelines give
+ * different IR for it, and 2 on a usage error.
+ */
+
+#include "../driver/driver.h"
+#include "../driver/compiler_session.h"
+#include "../parser/parser.h"
+#include "../parser/semantic_analysis.h"
+#include "../ir_generator/ir_generator.h"
+#include "../support/source_buffer.h"
+#include "../support/time_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <llvm-c/Core.h>
+
+/* the fastest of the timed runs of one pipeline, in microseconds */
+typedef struct {
+    double to_ir;
+    double to_asm;
+} pipelineTimes;
+
+/***************************************** FUNCTION HEADERS *****************************************/
+LLVMModuleRef lowerThreePass(sourceBuffer *source, const char *module_name, LLVMContextRef context);
+LLVMModuleRef lowerSinglePass(sourceBuffer *source, const char *module_name, LLVMContextRef context);
+bool sameIR(sourceBuffer *source, const char *input);
+pipelineTimes timePipeline(sourceBuffer *source, const char *input, pipelineKind kind, int runs);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+int main(int argc, char **argv) {
+    int runs = 5;
+    std::vector<const char *> inputs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        }
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: unknown or incomplete option '%s'\n", argv[i]);
+            return 2;
+        }
+        else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (runs < 1 || inputs.empty()) {
+        fprintf(stderr, "Usage: %s [--runs N] miniC-file...\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    printf("%-40s %10s %12s %12s %8s %12s %12s %8s\n", "Program", "Bytes", "3-pass (ms)", "1-pass (ms)", "Speedup",
+        "Asm 3 (ms)", "Asm 1 (ms)", "Speedup");
+    for (int i = 0; i < inputs.size(); i++) {
+        sourceBuffer *source = mapSourceFile(inputs.at(i));
+        if (source == NULL) {
+            ok = false;
+            continue;
+        }
+        if (!sameIR(source, inputs.at(i))) {
+            ok = false;
+            freeSourceBuffer(source);
+            continue;
+        }
+
+        pipelineTimes three = timePipeline(source, inputs.at(i), PIPELINE_AST, runs);
+        pipelineTimes one = timePipeline(source, inputs.at(i), PIPELINE_SINGLE_PASS, runs);
+        printf("%-40s %10zu %12.3f %12.3f %7.2fx %12.3f %12.3f %7.2fx\n", inputs.at(i), source->len,
+            three.to_ir / 1000.0, one.to_ir / 1000.0, one.to_ir > 0 ? three.to_ir / one.to_ir : 0.0,
+            three.to_asm / 1000.0, one.to_asm / 1000.0, one.to_asm > 0 ? three.to_asm / one.to_asm : 0.0);
+        freeSourceBuffer(source);
+    }
+    selectPipeline(PIPELINE_AST);
+    return ok ? 0 : 1;
+}
+
+/* returns the unoptimized IR of 'source' from the three passes, or NULL if it does not compile */
+LLVMModuleRef lowerThreePass(sourceBuffer *source, const char *module_name, LLVMContextRef context) {
+    flatAST *ast = parse(source->text, source->len);
+    if (ast == NULL) {
+        return NULL;
+    }
+    LLVMModuleRef module = isValidAST(ast) ? generateIR(ast, module_name, context) : NULL;
+    freeFlatAST(ast);
+    return module;
+}
+
+/* same as above from the single pass */
+LLVMModuleRef lowerSinglePass(sourceBuffer *source, const char *module_name, LLVMContextRef context) {
+    bool semantic_error;
+    return parseToIR(source->text, source->len, module_name, context, &semantic_error);
+}
+
+/* returns true if both pipelines give the same unoptimized IR for 'source'; otherwise prints
+   the first line they differ on */
+bool sameIR(sourceBuffer *source, const char *input) {
+    compilerSession *session = createCompilerSession();
+    LLVMModuleRef expected = ownModule(session, lowerThreePass(source, input, session->context));
+    LLVMModuleRef lowered = ownModule(session, lowerSinglePass(source, input, session->context));
+    if (expected == NULL || lowered == NULL) {
+        fprintf(stderr, "Error: '%s' does not compile\n", input);
+        freeCompilerSession(session);
+        return false;
+    }
+
+    char *expected_text = LLVMPrintModuleToString(expected);
+    char *lowered_text = LLVMPrintModuleToString(lowered);
+    bool same = strcmp(expected_text, lowered_text) == 0;
+    if (!same) {
+        int line = 1;
+        for (int i = 0; expected_text[i] == lowered_text[i]; i++) {
+            line += expected_text[i] == '\n';
+        }
+        fprintf(stderr, "Error: the single pass gives different IR for '%s' (from line %d)\n", input, line);
+    }
+    LLVMDisposeMessage(expected_text);
+    LLVMDisposeMessage(lowered_text);
+    freeCompilerSession(session);
+    return same;
+}
+
+/* times getting the unoptimized IR of 'source' with the pipeline 'kind', and compiling it all
+   the way to assembly */
+pipelineTimes timePipeline(sourceBuffer *source, const char *input, pipelineKind kind, int runs) {
+    pipelineTimes best = {0, 0};
+    selectPipeline(kind);
+    for (int run = 0; run < runs; run++) {
+        compilerSession *session = createCompilerSession();
+        timeStamp start = startTiming();
+        ownModule(session, kind == PIPELINE_AST ? lowerThreePass(source, input, session->context)
+            : lowerSinglePass(source, input, session->context));
+        timeStamp lowered = startTiming();
+        freeCompilerSession(session);
+
+        std::string s_text;
+        timeStamp compile_start = startTiming();
+        compileBuffer(source->text, source->len, input, NULL, NULL, &s_text);
+        timeStamp compiled = startTiming();
+
+        double to_ir = lowered.wall - start.wall;
+        double to_asm = compiled.wall - compile_start.wall;
+        if (run == 0 || to_ir < best.to_ir) {
+            best.to_ir = to_ir;
+        }
+        if (run == 0 || to_asm < best.to_asm) {
+            best.to_asm = to_asm;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,141 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * parse_check.c - checks that the parser is reentrant: parses every miniC program once on its
+ * own, then parses them all again on many threads at the same time, and checks that every
+ * concurrent parse produced exactly the same AST. Both scanners are checked.
+ *
+ * Usage: ./parse_check [--threads N] [--rounds N] miniC-file...
+ *
+ * Options:
+ *        --threads N            threads parsing at the same time (default 8)
+ *        --rounds N             times each thread parses every program (default 10)
+ *
+ * Returns 0 if every AST matched, 1 if a program could not be read or parsed or an AST
+ * differed, and 2 on a usage error.
+ */
+
+#include "../parser/parser.h"
+#include "../support/source_buffer.h"
+#include "../support/time_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/***************************************** FUNCTION HEADERS *****************************************/
+bool sameAST(const flatAST *a, const flatAST *b);
+long checkScanner(scannerKind kind, std::vector<sourceBuffer *> &sources, const std::vector<const char *> &inputs,
+                    int threads, int rounds);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+int main(int argc, char **argv) {
+    int threads = 8;
+    int rounds = 10;
+    std::vector<const char *> inputs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        }
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: unknown or incomplete option '%s'\n", argv[i]);
+            return 2;
+        }
+        else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (threads < 1 || rounds < 1 || inputs.empty()) {
+        fprintf(stderr, "Usage: %s [--threads N] [--rounds N] miniC-file...\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<sourceBuffer *> sources;
+    for (int i = 0; i < inputs.size(); i++) {
+        sourceBuffer *source = mapSourceFile(inputs.at(i));
+        if (source == NULL) {
+            return 1;
+        }
+        sources.push_back(source);
+    }
+
+    long mismatches = checkScanner(SCANNER_HAND, sources, inputs, threads, rounds);
+    mismatches += checkScanner(SCANNER_FLEX, sources, inputs, threads, rounds);
+    selectScanner(SCANNER_HAND);
+
+    for (int i = 0; i < sources.size(); i++) {
+        freeSourceBuffer(sources.at(i));
+    }
+    return mismatches == 0 ? 0 : 1;
+}
+
+/* parses every program in 'sources' with the scanner 'kind', first one at a time and then on
+   'threads' threads at once, 'rounds' times each; returns the number of concurrent parses whose
+   AST differs from the one parsed alone (or that failed) */
+long checkScanner(scannerKind kind, std::vector<sourceBuffer *> &sources, const std::vector<const char *> &inputs,
+                    int threads, int rounds) {
+    selectScanner(kind);
+
+    // the flex scanner writes into the buffer it scans, so every parse gets a copy of its own;
+    // the reference parses also intern every name, so later parses get the same name IDs
+    std::vector<flatAST *> expected;
+    for (int i = 0; i < sources.size(); i++) {
+        sourceBuffer *copy = copySourceBuffer(sources.at(i)->text, sources.at(i)->len);
+        expected.push_back(parse(copy->text, copy->len));
+        freeSourceBuffer(copy);
+        if (expected.back() == NULL) {
+            fprintf(stderr, "Error: '%s' could not be parsed\n", inputs.at(i));
+            return 1;
+        }
+    }
+
+    std::atomic<long> mismatches(0);
+    std::atomic<long> nodes(0);
+    timeStamp start = startTiming();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t] {
+            for (int round = 0; round < rounds; round++) {
+                // threads start at different programs, so that different programs are parsed
+                // at the same time as well as the same one
+                for (int j = 0; j < sources.size(); j++) {
+                    int i = (j + t) % sources.size();
+                    sourceBuffer *copy = copySourceBuffer(sources.at(i)->text, sources.at(i)->len);
+                    flatAST *ast = parse(copy->text, copy->len);
+                    freeSourceBuffer(copy);
+                    if (ast == NULL || !sameAST(ast, expected.at(i))) {
+                        fprintf(stderr, "Error: concurrent parse of '%s' gave a different AST\n", inputs.at(i));
+                        mismatches++;
+                    }
+                    if (ast != NULL) {
+                        nodes += ast->kinds.size();
+                        freeFlatAST(ast);
+                    }
+                }
+            }
+        }));
+    }
+    for (int t = 0; t < workers.size(); t++) {
+        workers.at(t).join();
+    }
+    timeStamp end = startTiming();
+
+    for (int i = 0; i < expected.size(); i++) {
+        freeFlatAST(expected.at(i));
+    }
+    printf("%-8s %zu programs, %d threads x %d rounds: %ld parses, %ld nodes, %ld mismatches (%.1f ms)\n",
+        kind == SCANNER_HAND ? "hand" : "flex", sources.size(), threads, rounds,
+        (long)threads * rounds * sources.size(), nodes.load(), mismatches.load(), (end.wall - start.wall) / 1000.0);
+    return mismatches;
+}
+
+/* returns true if both ASTs have the same nodes, in the same order */
+bool sameAST(const flatAST *a, const flatAST *b) {
+    return a->kinds == b->kinds && a->data == b->data && a->sizes == b->sizes;
+}
@@ -0,0 +1,118 @@
+#!/bin/sh
+# Author: Eric Richardson
+# Dartmouth CS57, Spring 2023
+# run_kernels.sh - measures the code the compiler generates: compiles each kernel in
+# ../test/kernels with './compile' and, as reference points, with gcc and clang at -O0 and -O2,
+# links each one against ../test/kernels/driver.c, runs it on the input listed in
+# ../test/kernels/inputs.txt, and reports the cycles and instructions it retired
+#
+# Usage: tools/run_kernels.sh [--reps N] [--json file] [--out-dir dir] [--compilers "list"]
+#
+# Options:
+#        --reps N               timed calls of each kernel; the minimum is reported (default 5)
+#        --json file            also write the results to 'file' as JSON
+#        --out-dir dir          directory for the binaries (default kernels_out)
+#        --compilers "list"     configurations to run, from minic, gcc-O0, gcc-O2, clang-O0 and
+#                               clang-O2 (default: all of them)
+#
+# Run it from the 'src' directory after 'make'. Every configuration must compute the same result
+# for a kernel; the script exits with status 1 if one does not, or if a build or run fails.
+# Compilers that are not installed are skipped.
+
+KERNEL_DIR=../test/kernels
+REPS=5
+JSON=
+OUT_DIR=kernels_out
+COMPILERS="minic gcc-O0 gcc-O2 clang-O0 clang-O2"
+ARCH_FLAGS=-m32
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --reps) REPS=$2; shift 2 ;;
+        --json) JSON=$2; shift 2 ;;
+        --out-dir) OUT_DIR=$2; shift 2 ;;
+        --compilers) COMPILERS=$2; shift 2 ;;
+        *) echo "Error: unknown option '$1'" >&2; exit 2 ;;
+    esac
+done
+
+mkdir -p "$OUT_DIR" || exit 2
+status=0
+json_kernels=
+
+# builds kernel $1 with configuration $2 into $3; returns non-zero if the build fails
+build() {
+    case "$2" in
+        minic)
+            ./compile -S -o "$3.s" "$KERNEL_DIR/$1.c" > /dev/null &&
+                gcc $ARCH_FLAGS -o "$3" "$KERNEL_DIR/driver.c" "$3.s" ;;
+        gcc-*|clang-*)
+            # -fwrapv gives signed overflow the wrapping behavior of the generated code
+            ${2%-*} $ARCH_FLAGS -${2#*-} -fwrapv -o "$3" "$KERNEL_DIR/driver.c" "$KERNEL_DIR/$1.c" ;;
+        *)
+            echo "Error: unknown configuration '$2'" >&2; return 1 ;;
+    esac
+}
+
+printf "%-10s %-10s %12s %14s %14s %10s %8s\n" "Kernel" "Compiler" "Result" "Cycles" "Instructions" "Time (ms)" "vs gcc-O2"
+while read -r kernel input; do
+    case "$kernel" in
+        ''|'#'*) continue ;;
+    esac
+
+    expected=
+    reference=
+    rows=
+    json_results=
+    for config in $COMPILERS; do
+        compiler=${config%-*}
+        [ "$config" = minic ] && compiler=gcc
+        if ! command -v "$compiler" > /dev/null 2>&1; then
+            continue
+        fi
+
+        binary="$OUT_DIR/$kernel.$config"
+        if ! build "$kernel" "$config" "$binary" 2> "$binary.log"; then
+            printf "%-10s %-10s %12s  (build failed, see %s)\n" "$kernel" "$config" "-" "$binary.log"
+            status=1
+            continue
+        fi
+        output=$("$binary" "$input" "$REPS" < /dev/null 2> "$binary.log") && set -- $output
+        if [ $? -ne 0 ] || [ $# -ne 4 ]; then
+            printf "%-10s %-10s %12s  (run failed, see %s)\n" "$kernel" "$config" "-" "$binary.log"
+            status=1
+            continue
+        fi
+        result=$1 cycles=$2 instructions=$3 ns=$4
+
+        # every configuration must agree with the first one that ran
+        if [ -z "$expected" ]; then
+            expected=$result
+        elif [ "$result" != "$expected" ]; then
+            echo "Error: $kernel built with $config returned $result, expected $expected" >&2
+            status=1
+        fi
+
+        # cycles are compared with gcc -O2 (wall-clock time when the counters are unavailable)
+        [ "$config" = gcc-O2 ] && reference=$cycles && [ "$cycles" = - ] && reference=$ns
+        rows="$rows$config $result $cycles $instructions $ns
+"
+
+        [ "$cycles" = - ] && cycles=null
+        [ "$instructions" = - ] && instructions=null
+        json_results="$json_results${json_results:+, }\"$config\": {\"result\": $result, \"cycles\": $cycles, \"instructions\": $instructions, \"ns\": $ns}"
+    done
+
+    printf "%s" "$rows" | awk -v kernel="$kernel" -v reference="$reference" '{
+        measure = $3 == "-" ? $5 : $3
+        ratio = reference != "" && reference > 0 ? sprintf("%.2fx", measure / reference) : "-"
+        printf "%-10s %-10s %12s %14s %14s %10.3f %8s\n", kernel, $1, $2, $3, $4, $5 / 1e6, ratio
+    }'
+    json_kernels="$json_kernels${json_kernels:+,
+}    {\"kernel\": \"$kernel\", \"input\": $input, \"results\": {$json_results}}"
+done < "$KERNEL_DIR/inputs.txt"
+
+if [ -n "$JSON" ]; then
+    printf '{\n  "version": 1,\n  "reps": %s,\n  "kernels": [\n%s\n  ]\n}\n' "$REPS" "$json_kernels" > "$JSON" || status=1
+fi
+exit $status
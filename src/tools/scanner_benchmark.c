@@ -0,0 +1,204 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * scanner_benchmark.c - compares the hand-written scanner of "parser/scanner.h" with the flex
+ * scanner: checks that both produce the same tokens for each miniC program, then reports how
+ * fast each one tokenizes and parses it
+ *
+ * Usage: ./scanner_benchmark [--runs N] miniC-file...
+ *
+ * Options:
+ *        --runs N               timed passes over each program; the fastest is reported (default 5)
+ *
+ * Returns 0 on success, 1 if a program could not be read or the scanners disagree on it, and 2
+ * on a usage error.
+ */
+
+#include "../parser/parser.h"
+#include "../support/source_buffer.h"
+#include "../support/time_report.h"
+#include "../y.tab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// the flex scanner (see "tokenizer.l")
+typedef struct yy_buffer_state *YY_BUFFER_STATE;
+extern int yylex_init(void **scanner);
+extern int yylex_destroy(void *scanner);
+extern YY_BUFFER_STATE yy_scan_buffer(char *base, size_t size, void *scanner);
+extern void yy_delete_buffer(YY_BUFFER_STATE buffer, void *scanner);
+extern int flexLex(tokenValue *value, void *scanner);
+
+/* a token and its value, as the parser receives it */
+typedef struct {
+    int token;
+    tokenValue value;
+} scannedToken;
+
+/* the fastest of the timed runs, in microseconds */
+typedef struct {
+    double scan;
+    double parse;
+} scannerTimes;
+
+/***************************************** FUNCTION HEADERS *****************************************/
+bool scanHand(sourceBuffer *source, std::vector<scannedToken> *tokens);
+bool scanFlex(sourceBuffer *source, std::vector<scannedToken> *tokens);
+bool sameTokens(const std::vector<scannedToken> &hand, const std::vector<scannedToken> &flex, const char *input);
+scannerTimes timeScanner(sourceBuffer *source, scannerKind kind, int runs);
+void printRow(const char *input, const char *scanner, sourceBuffer *source, long tokens, scannerTimes times);
+
+
+/***************************************** IMPLEMENTATION *****************************************/
+
+int main(int argc, char **argv) {
+    int runs = 5;
+    std::vector<const char *> inputs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        }
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: unknown or incomplete option '%s'\n", argv[i]);
+            return 2;
+        }
+        else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (runs < 1 || inputs.empty()) {
+        fprintf(stderr, "Usage: %s [--runs N] miniC-file...\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    printf("%-40s %-8s %10s %10s %10s %10s %10s\n", "Program", "Scanner", "Tokens", "Scan (ms)", "MB/s",
+        "ns/token", "Parse (ms)");
+    for (int i = 0; i < inputs.size(); i++) {
+        sourceBuffer *source = mapSourceFile(inputs.at(i));
+        if (source == NULL) {
+            ok = false;
+            continue;
+        }
+
+        std::vector<scannedToken> hand;
+        std::vector<scannedToken> flex;
+        if (!scanHand(source, &hand) || !scanFlex(source, &flex) || !sameTokens(hand, flex, inputs.at(i))) {
+            ok = false;
+            freeSourceBuffer(source);
+            continue;
+        }
+
+        printRow(inputs.at(i), "hand", source, hand.size(), timeScanner(source, SCANNER_HAND, runs));
+        printRow(inputs.at(i), "flex", source, flex.size(), timeScanner(source, SCANNER_FLEX, runs));
+        freeSourceBuffer(source);
+    }
+    selectScanner(SCANNER_HAND);
+    return ok ? 0 : 1;
+}
+
+/* appends every token of 'source' from the hand-written scanner to 'tokens' (or only counts
+   them if 'tokens' is NULL); always succeeds */
+bool scanHand(sourceBuffer *source, std::vector<scannedToken> *tokens) {
+    miniScanner scanner;
+    initScanner(&scanner, source->text, source->len);
+    scannedToken scanned;
+    memset(&scanned, 0, sizeof(scanned));
+    while ((scanned.token = scanToken(&scanner, &scanned.value)) != 0) {
+        if (tokens != NULL) {
+            tokens->push_back(scanned);
+        }
+    }
+    return true;
+}
+
+/* same as above with the flex scanner; returns false if flex rejects the buffer */
+bool scanFlex(sourceBuffer *source, std::vector<scannedToken> *tokens) {
+    void *scanner;
+    if (yylex_init(&scanner) != 0) {
+        fprintf(stderr, "Error: unable to create the scanner\n");
+        return false;
+    }
+    YY_BUFFER_STATE state = yy_scan_buffer(source->text, source->len + 2, scanner);
+    if (state == NULL) {
+        fprintf(stderr, "Error: source buffer is not followed by two NUL bytes\n");
+        yylex_destroy(scanner);
+        return false;
+    }
+    scannedToken scanned;
+    memset(&scanned, 0, sizeof(scanned));
+    while ((scanned.token = flexLex(&scanned.value, scanner)) != 0) {
+        if (tokens != NULL) {
+            tokens->push_back(scanned);
+        }
+    }
+    yy_delete_buffer(state, scanner);
+    yylex_destroy(scanner);
+    return true;
+}
+
+/* returns true if both scanners produced the same tokens with the same values; otherwise
+   prints the first difference */
+bool sameTokens(const std::vector<scannedToken> &hand, const std::vector<scannedToken> &flex, const char *input) {
+    for (size_t i = 0; i < hand.size() && i < flex.size(); i++) {
+        const scannedToken &a = hand.at(i);
+        const scannedToken &b = flex.at(i);
+        bool same = a.token == b.token;
+        if (same && a.token == NUM) {
+            same = a.value.ival == b.value.ival;
+        }
+        else if (same && a.token == IDENTIFIER) {
+            same = a.value.view.text == b.value.view.text && a.value.view.len == b.value.view.len;
+        }
+        if (!same) {
+            fprintf(stderr, "Error: scanners disagree on token %zu of '%s' (hand %d, flex %d)\n", i, input,
+                a.token, b.token);
+            return false;
+        }
+    }
+    if (hand.size() != flex.size()) {
+        fprintf(stderr, "Error: scanners disagree on the number of tokens in '%s' (hand %zu, flex %zu)\n", input,
+            hand.size(), flex.size());
+        return false;
+    }
+    return true;
+}
+
+/* times tokenizing and parsing 'source' with the scanner 'kind' */
+scannerTimes timeScanner(sourceBuffer *source, scannerKind kind, int runs) {
+    scannerTimes best = {0, 0};
+    selectScanner(kind);
+    for (int run = 0; run < runs; run++) {
+        timeStamp start = startTiming();
+        if (kind == SCANNER_HAND) {
+            scanHand(source, NULL);
+        }
+        else {
+            scanFlex(source, NULL);
+        }
+        timeStamp scanned = startTiming();
+        flatAST *ast = parse(source->text, source->len);
+        timeStamp parsed = startTiming();
+        if (ast != NULL) {
+            freeFlatAST(ast);
+        }
+
+        double scan = scanned.wall - start.wall;
+        double parse_time = parsed.wall - scanned.wall;
+        if (run == 0 || scan < best.scan) {
+            best.scan = scan;
+        }
+        if (run == 0 || parse_time < best.parse) {
+            best.parse = parse_time;
+        }
+    }
+    return best;
+}
+
+void printRow(const char *input, const char *scanner, sourceBuffer *source, long tokens, scannerTimes times) {
+    double seconds = times.scan / 1e6;
+    printf("%-40s %-8s %10ld %10.3f %10.1f %10.2f %10.3f\n", input, scanner, tokens, times.scan / 1000.0,
+        seconds > 0 ? source->len / 1e6 / seconds : 0.0, tokens > 0 ? times.scan * 1000.0 / tokens : 0.0,
+        times.parse / 1000.0);
+}
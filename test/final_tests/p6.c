@@ -0,0 +1,38 @@
+extern int read();
+extern void print(int);
+
+int square(int x){
+	int s;
+	s = x * x;
+	return s;
+}
+
+int sum_squares(int n){
+	int i;
+	int total;
+	int sq;
+
+	i = 1;
+	total = 0;
+	while (i <= n){
+		sq = square(i);
+		total = total + sq;
+		i = i + 1;
+	}
+	return total;
+}
+
+int func(int n){
+	int r;
+
+	r = sum_squares(n);
+	print(r);
+	r = triple(r);
+	return r;
+}
+
+int triple(int y){
+	int t;
+	t = y * 3;
+	return t;
+}
@@ -0,0 +1,5 @@
+; a 64-bit function: every value the compiler generates is an i32
+define i64 @func(i64 %0) {
+  %2 = add i64 %0, 1
+  ret i64 %2
+}
@@ -0,0 +1,11 @@
+; 'ne' comparison: miniC's '!=' is generated as 'eq' with the branch targets swapped
+define i32 @func(i32 %0) {
+  %2 = icmp ne i32 %0, 0
+  br i1 %2, label %3, label %4
+
+3:
+  ret i32 1
+
+4:
+  ret i32 0
+}
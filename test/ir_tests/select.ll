@@ -0,0 +1,6 @@
+; a comparison consumed by something other than the branch right after it
+define i32 @func(i32 %0) {
+  %2 = icmp slt i32 %0, 0
+  %3 = select i1 %2, i32 0, i32 %0
+  ret i32 %3
+}
@@ -0,0 +1,6 @@
+; remainder and bitwise xor: the code generator has no instructions for either
+define i32 @func(i32 %0) {
+  %2 = srem i32 %0, 3
+  %3 = xor i32 %2, 1
+  ret i32 %3
+}
@@ -0,0 +1,5 @@
+; two parameters: a miniC function takes at most one
+define i32 @func(i32 %0, i32 %1) {
+  %3 = add i32 %0, %1
+  ret i32 %3
+}
@@ -0,0 +1,5 @@
+; an undefined operand: operands are constants, the parameter or instructions
+define i32 @func(i32 %0) {
+  %2 = add i32 %0, undef
+  ret i32 %2
+}
@@ -0,0 +1,7 @@
+; a call to an external function other than print and read
+declare i32 @abs(i32)
+
+define i32 @func(i32 %0) {
+  %2 = call i32 @abs(i32 %0)
+  ret i32 %2
+}
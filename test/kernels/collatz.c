@@ -0,0 +1,28 @@
+extern void print(int);
+extern int read();
+
+int func(int n){
+	int i;
+	int x;
+	int half;
+	int twice;
+	int steps;
+	steps = 0;
+	i = 1;
+	while (i <= n){
+		x = i;
+		while (x > 1){
+			half = x / 2;
+			twice = half * 2;
+			if (twice == x)
+				x = half;
+			else {
+				x = x * 3;
+				x = x + 1;
+			}
+			steps = steps + 1;
+		}
+		i = i + 1;
+	}
+	return steps;
+}
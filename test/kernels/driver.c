@@ -0,0 +1,110 @@
+/* Author: Eric Richardson
+ * Dartmouth CS57, Spring 2023
+ * driver.c - runs a compiled miniC kernel with a fixed input and measures it with the
+ * hardware performance counters (see src/tools/run_kernels.sh)
+ *
+ * Usage: ./kernel input repetitions
+ *
+ * Calls func(input) once to warm up, then 'repetitions' more times, and prints a single line:
+ *        result cycles instructions nanoseconds
+ * where each measurement is the minimum over the repetitions. If the counters cannot be opened
+ * (e.g. because of kernel.perf_event_paranoid or a virtual machine without a PMU), cycles and
+ * instructions are printed as '-' and only the wall-clock time is measured.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// the kernel; kernels only compute, and must not call print or read, which are not defined here
+int func(int);
+
+/* opens a counter of the hardware event 'config' for user-space code of this thread;
+   returns -1 if it is unavailable */
+int openCounter(uint64_t config) {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+int64_t readCounter(int fd) {
+	int64_t value = 0;
+	if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value)) {
+		return -1;
+	}
+	return value;
+}
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s input repetitions\n", argv[0]);
+		return 2;
+	}
+	int input = atoi(argv[1]);
+	int repetitions = atoi(argv[2]);
+
+	int cycles_fd = openCounter(PERF_COUNT_HW_CPU_CYCLES);
+	int instructions_fd = openCounter(PERF_COUNT_HW_INSTRUCTIONS);
+	int64_t min_cycles = -1;
+	int64_t min_instructions = -1;
+	int64_t min_ns = -1;
+
+	int result = func(input);
+	for (int i = 0; i < repetitions; i++) {
+		struct timespec start, end;
+		if (cycles_fd >= 0 && instructions_fd >= 0) {
+			ioctl(cycles_fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(instructions_fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(cycles_fd, PERF_EVENT_IOC_ENABLE, 0);
+			ioctl(instructions_fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		int value = func(input);
+
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		if (cycles_fd >= 0 && instructions_fd >= 0) {
+			ioctl(cycles_fd, PERF_EVENT_IOC_DISABLE, 0);
+			ioctl(instructions_fd, PERF_EVENT_IOC_DISABLE, 0);
+			int64_t cycles = readCounter(cycles_fd);
+			int64_t instructions = readCounter(instructions_fd);
+			if (cycles >= 0 && (min_cycles < 0 || cycles < min_cycles)) {
+				min_cycles = cycles;
+			}
+			if (instructions >= 0 && (min_instructions < 0 || instructions < min_instructions)) {
+				min_instructions = instructions;
+			}
+		}
+		int64_t ns = (int64_t)(end.tv_sec - start.tv_sec) * 1000000000 + (end.tv_nsec - start.tv_nsec);
+		if (min_ns < 0 || ns < min_ns) {
+			min_ns = ns;
+		}
+
+		if (value != result) {
+			fprintf(stderr, "Error: func(%d) returned %d, then %d\n", input, result, value);
+			return 1;
+		}
+	}
+
+	printf("%d ", result);
+	if (min_cycles >= 0 && min_instructions >= 0) {
+		printf("%lld %lld ", (long long)min_cycles, (long long)min_instructions);
+	}
+	else {
+		printf("- - ");
+	}
+	printf("%lld\n", (long long)min_ns);
+	return 0;
+}
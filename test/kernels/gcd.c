@@ -0,0 +1,32 @@
+extern void print(int);
+extern int read();
+
+int func(int n){
+	int i;
+	int j;
+	int a;
+	int b;
+	int q;
+	int t;
+	int sum;
+	sum = 0;
+	i = 1;
+	while (i <= n){
+		j = 1;
+		while (j <= n){
+			a = i;
+			b = j;
+			while (b > 0){
+				q = a / b;
+				q = q * b;
+				t = a - q;
+				a = b;
+				b = t;
+			}
+			sum = sum + a;
+			j = j + 1;
+		}
+		i = i + 1;
+	}
+	return sum;
+}
@@ -0,0 +1,28 @@
+extern void print(int);
+extern int read();
+
+int func(int n){
+	int i;
+	int j;
+	int k;
+	int t;
+	int acc;
+	acc = 0;
+	i = 0;
+	while (i < n){
+		j = 0;
+		while (j < n){
+			k = 0;
+			while (k < n){
+				t = i * j;
+				t = t + k;
+				acc = acc + t;
+				acc = acc - i;
+				k = k + 1;
+			}
+			j = j + 1;
+		}
+		i = i + 1;
+	}
+	return acc;
+}
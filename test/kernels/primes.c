@@ -0,0 +1,30 @@
+extern void print(int);
+extern int read();
+
+int func(int n){
+	int i;
+	int d;
+	int q;
+	int prime;
+	int count;
+	count = 0;
+	i = 2;
+	while (i <= n){
+		prime = 1;
+		d = 2;
+		q = d * d;
+		while (q <= i){
+			q = i / d;
+			q = q * d;
+			if (q == i){
+				prime = 0;
+				d = i;
+			}
+			d = d + 1;
+			q = d * d;
+		}
+		count = count + prime;
+		i = i + 1;
+	}
+	return count;
+}